@@ -0,0 +1,7 @@
+#pragma once
+
+#include <maf/messaging/client-server/ipc/local_shm/Stub.h>
+
+namespace maf {
+namespace localshm = maf::messaging::ipc::local_shm;
+} // namespace maf
@@ -26,6 +26,8 @@ class SignalTimer {
 
   void setCyclic(bool yes = true) { impl_.setCyclic(yes); }
 
+  void setSlack(Milliseconds slack) { impl_.setSlack(slack); }
+
   TimeoutSignal timeoutSignal;
 
  private:
@@ -5,10 +5,15 @@
 #include <maf/utils/ExecutorIF.h>
 
 #include <chrono>
+#include <functional>
+#include <memory>
 
 namespace maf {
 namespace messaging {
 
+// SyncTimer does not block the thread that starts it, all SyncTimers share
+// one timer thread that dispatches expirations to the timer's executor, or
+// calls the callback directly on the timer thread if no executor is given.
 class SyncTimer : public pattern::Unasignable {
   using ExecutorIFPtr = std::shared_ptr<util::ExecutorIF>;
 
@@ -27,7 +32,7 @@ class SyncTimer : public pattern::Unasignable {
   MAF_EXPORT void setCyclic(bool cyclic = true);
 
  private:
-  struct SyncTimerDataPrv *d_;
+  std::shared_ptr<struct SyncTimerDataPrv> d_;
 };
 
 }  // namespace messaging
@@ -35,6 +35,8 @@ class Timer : public pattern::Unasignable {
   MAF_EXPORT void stop(const ComponentInstance& comp);
   MAF_EXPORT bool running() const;
   MAF_EXPORT void setCyclic(bool cyclic = true);
+  MAF_EXPORT void setSlack(std::chrono::milliseconds slack);
+  MAF_EXPORT std::chrono::milliseconds slack() const;
   MAF_EXPORT static void timeoutAfter(long long milliseconds,
                                       TimeOutCallback callback);
   MAF_EXPORT static void timeoutAfter(std::chrono::milliseconds milliseconds,
@@ -45,6 +47,7 @@ class Timer : public pattern::Unasignable {
   MAF_EXPORT static void timeoutAfter(std::chrono::milliseconds milliseconds,
                                       TimeOutCallback callback,
                                       const ComponentInstance& comp);
+  MAF_EXPORT static unsigned long long savedWakeupCount();
 
  private:
   std::shared_ptr<struct TimerData> d_;
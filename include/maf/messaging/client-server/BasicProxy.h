@@ -5,6 +5,7 @@
 #include <maf/messaging/client-server/ParamTranslatingStatus.h>
 #include <maf/utils/ExecutorIF.h>
 #include <maf/utils/Pointers.h>
+#include <maf/utils/serialization/FieldChanges.h>
 
 #include <cassert>
 
@@ -48,8 +49,19 @@ class BasicProxy {
   RegID registerStatus(NotificationProcessingCallback<Status> callback,
                        ActionCallStatus *callStatus = nullptr) noexcept;
 
+  //! The server sends only the updates passing all the filters
+  template <class Status, AllowOnlyStatusT<PTrait, Status> = true>
+  RegID registerStatus(NotificationProcessingCallback<Status> callback,
+                       const SubscriptionFilters &filters,
+                       ActionCallStatus *callStatus = nullptr) noexcept;
+
+  template <class Attributes, AllowOnlyAttributesT<PTrait, Attributes> = true>
+  RegID registerSignal(NotificationProcessingCallback<Attributes> callback,
+                       ActionCallStatus *callStatus = nullptr) noexcept;
+
   template <class Attributes, AllowOnlyAttributesT<PTrait, Attributes> = true>
   RegID registerSignal(NotificationProcessingCallback<Attributes> callback,
+                       const SubscriptionFilters &filters,
                        ActionCallStatus *callStatus = nullptr) noexcept;
 
   template <class Signal, AllowOnlySignalT<PTrait, Signal> = true>
@@ -118,6 +130,10 @@ class BasicProxy {
   CSPayloadProcessCallback createUpdateMsgHandlerCallback(
       NotificationProcessingCallback<CSParam> callback) noexcept;
 
+  template <class CSParam>
+  static std::optional<double> numericField(const CSPayloadIFPtr &payload,
+                                            size_t index) noexcept;
+
   template <class CSParam>
   CSPayloadProcessCallback createResponseMsgHandlerCallback(
       ResponseProcessingCallback<CSParam> callback) noexcept;
@@ -268,6 +284,16 @@ CSPayloadProcessCallback BasicProxy<PTrait>::createUpdateMsgHandlerCallback(
   return {};
 }
 
+template <class PTrait>
+template <class CSParam>
+std::optional<double> BasicProxy<PTrait>::numericField(
+    const CSPayloadIFPtr &payload, size_t index) noexcept {
+  if (auto content = convert<CSParam>(payload)) {
+    return srz::numericField(*content, index);
+  }
+  return {};
+}
+
 template <class PTrait>
 template <class CSParam>
 typename BasicProxy<PTrait>::template Response<CSParam>
@@ -330,11 +356,20 @@ template <class Status, AllowOnlyStatusT<PTrait, Status>>
 RegID BasicProxy<PTrait>::registerStatus(
     NotificationProcessingCallback<Status> callback,
     ActionCallStatus *callStatus) noexcept {
+  return registerStatus<Status>(std::move(callback), {}, callStatus);
+}
+
+template <class PTrait>
+template <class Status, AllowOnlyStatusT<PTrait, Status>>
+RegID BasicProxy<PTrait>::registerStatus(
+    NotificationProcessingCallback<Status> callback,
+    const SubscriptionFilters &filters, ActionCallStatus *callStatus) noexcept {
   auto propertyID = getOpID<Status>();
   if (auto translatorCallback =
           createUpdateMsgHandlerCallback(std::move(callback))) {
     return requester_->registerStatus(propertyID, std::move(translatorCallback),
-                                      callStatus);
+                                      callStatus, filters,
+                                      &BasicProxy::numericField<Status>);
   } else {
     util::assign_ptr(callStatus, ActionCallStatus::InvalidParam);
     MAF_LOGGER_ERROR("Registering status id[ ", propertyID,
@@ -349,11 +384,20 @@ template <class Attributes, AllowOnlyAttributesT<PTrait, Attributes>>
 RegID BasicProxy<PTrait>::registerSignal(
     NotificationProcessingCallback<Attributes> callback,
     ActionCallStatus *callStatus) noexcept {
+  return registerSignal<Attributes>(std::move(callback), {}, callStatus);
+}
+
+template <class PTrait>
+template <class Attributes, AllowOnlyAttributesT<PTrait, Attributes>>
+RegID BasicProxy<PTrait>::registerSignal(
+    NotificationProcessingCallback<Attributes> callback,
+    const SubscriptionFilters &filters, ActionCallStatus *callStatus) noexcept {
   auto signalID = getOpID<Attributes>();
   if (auto translatedCallback =
           createUpdateMsgHandlerCallback(std::move(callback))) {
     return requester_->registerSignal(signalID, std::move(translatedCallback),
-                                      callStatus);
+                                      callStatus, filters,
+                                      &BasicProxy::numericField<Attributes>);
   } else {
     util::assign_ptr(callStatus, ActionCallStatus::InvalidParam);
     MAF_LOGGER_ERROR(
@@ -42,6 +42,11 @@ class BasicStub {
   template <class Status, AllowOnlyStatusT<PTrait, Status> = true>
   std::shared_ptr<Status> getStatus();
 
+  //! Coalesces updates of Status, clients get the latest value at most once
+  //! per minInterval
+  template <class Status, AllowOnlyStatusT<PTrait, Status> = true>
+  void setPublishInterval(std::chrono::milliseconds minInterval);
+
   template <class Attributes, AllowOnlyAttributesT<PTrait, Attributes> = true>
   ActionCallStatus broadcastSignal(const std::shared_ptr<Attributes> &attr);
 
@@ -122,6 +127,14 @@ std::shared_ptr<Status> BasicStub<PTrait>::getStatus() {
   }
 }
 
+template <class PTrait>
+template <class Status, AllowOnlyStatusT<PTrait, Status>>
+void BasicStub<PTrait>::setPublishInterval(
+    std::chrono::milliseconds minInterval) {
+  provider_->setStatusPublishInterval(PTrait::template getOperationID<Status>(),
+                                      minInterval);
+}
+
 template <class PTrait>
 template <class Attributes, AllowOnlyAttributesT<PTrait, Attributes>>
 ActionCallStatus BasicStub<PTrait>::broadcastSignal(
@@ -140,7 +140,10 @@
 #define mc_maf_csc_declare_feature(type, name)                          \
   struct name##_##type : public maf::messaging::cs_##type {             \
     static constexpr maf::messaging::OpIDConst ID =                     \
-        MAF_CS_CONTRACT_PREFIX #name "." #type;                         \
+        maf::messaging::InternedID::fromLiteral(                        \
+            MAF_CS_CONTRACT_PREFIX #name "." #type);                    \
+    static inline const bool ID_PUBLISHED =                             \
+        maf::messaging::InternedID::publish(ID);                        \
     static constexpr maf::messaging::OpIDConst operationID() noexcept { \
       return ID;                                                        \
     }
@@ -7,6 +7,7 @@
 #include "Address.h"
 #include "CSMsgPayloadIF.h"
 #include "CSTypes.h"
+#include "SubscriptionFilter.h"
 
 namespace maf {
 namespace messaging {
@@ -47,6 +48,10 @@ class CSMessage {
   MAF_EXPORT CSPayloadIFPtr payload() const;
   MAF_EXPORT void setPayload(CSPayloadIFPtr payload);
 
+  //! Conditions of a StatusRegister or SignalRegister
+  MAF_EXPORT const SubscriptionFilters &subscriptionFilters() const;
+  MAF_EXPORT void setSubscriptionFilters(SubscriptionFilters filters);
+
  protected:
   ServiceID serviceID_ = ServiceIDInvalid;
   OpID operationID_ = OpIDInvalid;
@@ -54,6 +59,7 @@ class CSMessage {
   OpCode operationCode_ = OpCode::Invalid;
   CSPayloadIFPtr payload_;
   Address sourceAddress_;
+  SubscriptionFilters subscriptionFilters_;
 };
 
 template <class CSMessageDerived = CSMessage>
@@ -19,6 +19,13 @@ MAF_EXPORT std::shared_ptr<ServiceProviderIF> getServiceProvider(
     const ConnectionType &conntype, const Address &serverAddr,
     const ServiceID &sid) noexcept;
 
+//! Number of threads decoding and dispatching incoming messages. Messages of
+//! one service, or of one client on the server side, are always handled in
+//! order on the same thread. Can only be changed before the first requester
+//! or provider is created, returns false otherwise
+MAF_EXPORT bool setDispatcherThreadCount(size_t count) noexcept;
+MAF_EXPORT size_t dispatcherThreadCount() noexcept;
+
 }  // namespace csmgmt
 }  // namespace messaging
 }  // namespace maf
@@ -2,6 +2,9 @@
 
 #include <maf/export/MafExport_global.h>
 
+#include <memory>
+#include <optional>
+
 namespace maf {
 namespace messaging {
 
@@ -9,7 +12,11 @@ enum class CSPayloadType : char {
   IncomingData = 0,
   OutgoingData = 1,
   Error = 2,
-  NA
+  NA,
+  // Only the fields changed since the previous status
+  Changes,
+  // Subscription filters of a register message
+  Filters
 };
 
 class MAF_EXPORT CSMsgPayloadIF {
@@ -18,6 +25,24 @@ public:
   virtual CSPayloadType type() const = 0;
   virtual bool equal(const CSMsgPayloadIF *other) const = 0;
   virtual CSMsgPayloadIF *clone() const = 0;
+
+  //! Status update holding only what changed since previous, null when the
+  //! content cannot tell its fields apart
+  virtual std::shared_ptr<CSMsgPayloadIF> changesSince(
+      const CSMsgPayloadIF * /*previous*/) const {
+    return {};
+  }
+  //! Whether this holds only changes, then patchedOnto gives the whole
+  //! status from the one they apply to
+  virtual bool partial() const { return false; }
+  virtual std::shared_ptr<CSMsgPayloadIF> patchedOnto(
+      std::shared_ptr<CSMsgPayloadIF> /*base*/) const {
+    return {};
+  }
+  //! Field index of the content as a number, for subscription filters
+  virtual std::optional<double> numericField(size_t /*index*/) const {
+    return {};
+  }
 };
 
 } // namespace messaging
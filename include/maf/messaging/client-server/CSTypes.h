@@ -4,15 +4,17 @@
 #include <stdint.h>
 #include <string>
 
+#include "InternedID.h"
+
 // clang-format off
 namespace maf {
 namespace messaging {
 
 
-using OpID              = std::string;
-using OpIDConst         = const char*;
-using ServiceID         = std::string;
-using ServiceIDConst    = const char*;
+using OpID              = InternedID;
+using OpIDConst         = InternedID;
+using ServiceID         = InternedID;
+using ServiceIDConst    = InternedID;
 using RequestID         = uint64_t;
 using ConnectionType    = std::string;
 
@@ -28,15 +30,19 @@ MC_MAF_STRINGIFYABLE_ENUM(OpCode, char,
     RegisterServiceStatus,
     UnregisterServiceStatus,
     ServiceStatusUpdate,
+//  Connection
+    NegotiateHeader,
 //  Unhandle
     Invalid
 )
 
-constexpr OpIDConst         OpIDInvalid      = "";
-constexpr ServiceIDConst    ServiceIDInvalid = "";
+constexpr OpIDConst         OpIDInvalid      = InternedID::fromLiteral("");
+constexpr ServiceIDConst    ServiceIDInvalid = InternedID::fromLiteral("");
 constexpr RequestID         RequestIDInvalid = static_cast<RequestID>(-1);
-constexpr OpIDConst OpID_ServiceAvailable    = "service_available.property";
-constexpr OpIDConst OpID_ServiceUnavailable  = "service_unavailable.property";
+constexpr OpIDConst OpID_ServiceAvailable    =
+    InternedID::fromLiteral("service_available.property");
+constexpr OpIDConst OpID_ServiceUnavailable  =
+    InternedID::fromLiteral("service_unavailable.property");
 
 // clang-format on
 } // messaging
@@ -9,6 +9,7 @@ namespace maf {
 namespace messaging {
 
 using ServiceRequesterIFPtr = std::shared_ptr<class ServiceRequesterIF>;
+using ServiceProviderIFPtr = std::shared_ptr<class ServiceProviderIF>;
 
 class ClientIF : public CSMessageReceiverIF,
                  private ServiceStatusObserverIF,
@@ -19,6 +20,11 @@ public:
   virtual bool hasServiceRequester(const ServiceID &sid) = 0;
   virtual ServiceRequesterIFPtr getServiceRequester(const ServiceID &sid) = 0;
   virtual Availability getServiceStatus(const ServiceID &sid) = 0;
+  //! Provider of the service if it runs in this process, requests may go to
+  //! it directly then
+  virtual ServiceProviderIFPtr localServiceProvider(const ServiceID &) {
+    return {};
+  }
   virtual bool init(const Address &serverAddr) = 0;
   virtual bool start() = 0;
   virtual void stop() = 0;
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <maf/export/MafExport_global.h>
+#include <stdint.h>
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace maf {
+namespace messaging {
+
+/*! \brief Name of a service or an operation, compared by its hash
+ * The 64-bit FNV-1a hash of a name made by fromLiteral() is computed at compile
+ * time, both ends of a connection derive the same value from the contract, so
+ * the hash alone goes on the wire. Other names are copied once into a
+ * process-wide table, copying an ID never allocates.
+ */
+class InternedID {
+ public:
+  using Hash = uint64_t;
+
+  static constexpr Hash hashOf(std::string_view name) noexcept {
+    Hash hash = 14695981039346656037ull;
+    for (auto c : name) {
+      hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+    }
+    return hash;
+  }
+
+  constexpr InternedID() noexcept
+      : InternedID(std::string_view{}, hashOf({})) {}
+
+  //! The name is referred to, not copied, it must be a string literal or live
+  //! as long as the process. For the contract macros and other compile time
+  //! IDs, the name ends at the first NUL
+  template <size_t N>
+  static constexpr InternedID fromLiteral(const char (&literal)[N]) noexcept {
+    std::string_view name{literal, std::char_traits<char>::length(literal)};
+    return {name, hashOf(name)};
+  }
+
+  //! Any other array may go away before the ID, its name is copied
+  template <size_t N>
+  InternedID(const char (&name)[N]) : InternedID(std::string_view{name}) {}
+  template <size_t N>
+  InternedID(char (&name)[N]) : InternedID(std::string_view{name}) {}
+
+  template <typename CharPtr,
+            std::enable_if_t<std::is_same_v<CharPtr, const char *> ||
+                                 std::is_same_v<CharPtr, char *>,
+                             bool> = true>
+  InternedID(CharPtr name) : InternedID(std::string_view{name}) {}
+  InternedID(const std::string &name) : InternedID(std::string_view{name}) {}
+  MAF_EXPORT explicit InternedID(std::string_view name);
+
+  //! The ID known by this hash, its name is empty if never interned here
+  MAF_EXPORT static InternedID fromHash(Hash hash);
+  //! Makes a literal ID known to fromHash, returns false on hash collision
+  MAF_EXPORT static bool publish(const InternedID &literal);
+
+  constexpr Hash hash() const noexcept { return hash_; }
+  constexpr std::string_view name() const noexcept { return name_; }
+  constexpr bool empty() const noexcept { return hash_ == hashOf({}); }
+  //! The name, or the hash in hex if the name is unknown
+  MAF_EXPORT std::string str() const;
+
+  friend constexpr bool operator==(const InternedID &lhs,
+                                   const InternedID &rhs) noexcept {
+    return lhs.hash_ == rhs.hash_;
+  }
+  friend constexpr bool operator!=(const InternedID &lhs,
+                                   const InternedID &rhs) noexcept {
+    return lhs.hash_ != rhs.hash_;
+  }
+  friend constexpr bool operator<(const InternedID &lhs,
+                                  const InternedID &rhs) noexcept {
+    return lhs.hash_ < rhs.hash_;
+  }
+
+ private:
+  constexpr InternedID(std::string_view name, Hash hash) noexcept
+      : name_{name}, hash_{hash} {}
+
+  std::string_view name_;
+  Hash hash_;
+};
+
+inline std::ostream &operator<<(std::ostream &os, const InternedID &id) {
+  return os << id.str();
+}
+
+}  // namespace messaging
+}  // namespace maf
+
+namespace std {
+template <>
+struct hash<maf::messaging::InternedID> {
+  size_t operator()(const maf::messaging::InternedID &id) const noexcept {
+    return static_cast<size_t>(id.hash());
+  }
+};
+}  // namespace std
@@ -5,6 +5,8 @@
 #include "CSStatus.h"
 #include "ServiceStatusObserverIF.h"
 
+#include <vector>
+
 namespace maf {
 namespace messaging {
 
@@ -17,6 +19,17 @@ public:
   virtual ~ServerIF() = default;
   virtual ActionCallStatus sendMessageToClient(const CSMessagePtr &msg,
                                                const Address &addr) = 0;
+  //! Sends the same message to all addrs, servers that serialize messages do
+  //! it once for all of them. Returns the status of each address in order
+  virtual std::vector<ActionCallStatus> sendMessageToClients(
+      const CSMessagePtr &msg, const std::vector<Address> &addrs) {
+    std::vector<ActionCallStatus> results;
+    results.reserve(addrs.size());
+    for (const auto &addr : addrs) {
+      results.push_back(sendMessageToClient(msg, addr));
+    }
+    return results;
+  }
   virtual ServiceProviderIFPtr getServiceProvider(const ServiceID &sid) = 0;
   virtual bool hasServiceProvider(const ServiceID &sid) = 0;
   virtual bool init(const Address &serverAddr) = 0;
@@ -1,8 +1,11 @@
 #pragma once
 
 #include "CSMessageReceiverIF.h"
+#include "RequestIF.h"
 #include "ServiceProviderShared.h"
 
+#include <chrono>
+
 namespace maf {
 namespace messaging {
 
@@ -25,6 +28,10 @@ public:
   virtual bool unregisterRequestHandler(const OpID &opID) = 0;
 
   virtual ActionCallStatus respondToRequest(const CSMessagePtr &csMsg) = 0;
+
+  //! Hands a request of the same process to its handler as is, without
+  //! keeping track of it. Returns false if there is no handler
+  virtual bool dispatchRequest(const std::shared_ptr<RequestIF> &request) = 0;
   virtual ActionCallStatus setStatus(const OpID &propertyID,
                                      const CSPayloadIFPtr &property) = 0;
 
@@ -32,6 +39,11 @@ public:
                                            const CSPayloadIFPtr &event) = 0;
 
   virtual CSPayloadIFPtr getStatus(const OpID &propertyID) = 0;
+
+  //! Status updates go out at most once per minInterval, the latest one wins
+  //! and is sent when the interval ends. Zero sends every update right away
+  virtual void setStatusPublishInterval(const OpID &propertyID,
+                                        std::chrono::milliseconds minInterval) = 0;
 };
 
 } // namespace messaging
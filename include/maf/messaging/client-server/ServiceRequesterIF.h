@@ -1,11 +1,14 @@
 #pragma once
 
 #include <chrono>
+#include <functional>
+#include <optional>
 
 #include "CSMessageReceiverIF.h"
 #include "CSShared.h"
 #include "RegID.h"
 #include "ServiceStatusObserverIF.h"
+#include "SubscriptionFilter.h"
 
 namespace maf {
 namespace messaging {
@@ -19,13 +22,26 @@ class MAF_EXPORT ServiceRequesterIF : public CSMessageReceiverIF,
 
   virtual const ServiceID &serviceID() const = 0;
 
+  //! Reads a field of an update as a number, for the filters checked on the
+  //! client side
+  using FieldReader =
+      std::function<std::optional<double>(const CSPayloadIFPtr &, size_t)>;
+
+  //! The server checks the filters while all the callbacks of the operation
+  //! have the same ones. Otherwise it sends every update and each callback
+  //! checks its own filters with readField, or numericField() of the update
+  //! if it is empty
   virtual RegID registerStatus(const OpID &propertyID,
                                CSPayloadProcessCallback callback,
-                               ActionCallStatus *callStatus) = 0;
+                               ActionCallStatus *callStatus,
+                               const SubscriptionFilters &filters = {},
+                               FieldReader readField = {}) = 0;
 
   virtual RegID registerSignal(const OpID &propertyID,
                                CSPayloadProcessCallback callback,
-                               ActionCallStatus *callStatus) = 0;
+                               ActionCallStatus *callStatus,
+                               const SubscriptionFilters &filters = {},
+                               FieldReader readField = {}) = 0;
 
   virtual ActionCallStatus unregister(const RegID &regID) = 0;
   virtual ActionCallStatus unregisterAll(const OpID &propertyID) = 0;
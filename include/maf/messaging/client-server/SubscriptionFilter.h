@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+namespace maf {
+namespace messaging {
+
+/*! \brief Condition a client puts on the updates of a status or signal
+ * It goes to the server with the registration, the server checks it before
+ * sending an update. Fields are given by their index in the declaration of
+ * the status or attributes, only arithmetic and enum fields can be checked.
+ */
+struct SubscriptionFilter {
+  enum class Kind : uint8_t {
+    Equal,          // field == low
+    Range,          // low <= field <= high
+    ChangeAtLeast,  // |field - value last sent| >= low
+    EveryNth        // one of every low updates
+  };
+
+  Kind kind = Kind::EveryNth;
+  uint32_t field = 0;
+  double low = 1;
+  double high = 0;
+
+  static SubscriptionFilter equal(uint32_t field, double value) {
+    return {Kind::Equal, field, value, value};
+  }
+  static SubscriptionFilter range(uint32_t field, double low, double high) {
+    return {Kind::Range, field, low, high};
+  }
+  static SubscriptionFilter changeAtLeast(uint32_t field, double threshold) {
+    return {Kind::ChangeAtLeast, field, threshold, 0};
+  }
+  static SubscriptionFilter everyNth(uint32_t n) {
+    return {Kind::EveryNth, 0, static_cast<double>(n), 0};
+  }
+
+  bool operator==(const SubscriptionFilter &other) const {
+    return kind == other.kind && field == other.field && low == other.low &&
+           high == other.high;
+  }
+  bool operator!=(const SubscriptionFilter &other) const {
+    return !(*this == other);
+  }
+};
+
+//! An update is sent only if it passes all the filters
+using SubscriptionFilters = std::vector<SubscriptionFilter>;
+
+}  // namespace messaging
+}  // namespace maf
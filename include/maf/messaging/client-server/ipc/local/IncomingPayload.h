@@ -5,6 +5,7 @@
 
 #include <cassert>
 #include <memory>
+#include <mutex>
 
 namespace maf {
 namespace messaging {
@@ -12,32 +13,85 @@ namespace ipc {
 namespace local {
 
 class IncomingPayload : public CSMsgPayloadIF {
-  using StreamType = srz::IByteStream;
   using StreamPtrType = std::shared_ptr<srz::IByteStream>;
   using StreamViewType = srz::IByteStreamView;
+  using BytesOwnerType = std::shared_ptr<const void>;
 
-  StreamPtrType stream_;
+  // Keeps alive the bytes the view reads, a stream or a mapped payload
+  BytesOwnerType bytesOwner_;
+  StreamViewType view_;
+  // Changes only, they apply to the status in base_
+  bool partial_ = false;
+  std::shared_ptr<CSMsgPayloadIF> base_;
+
+  // Content decoded from the bytes, shared by the clones of this payload so
+  // that the subscribers and the status cache decode it once
+  struct Decoded {
+    std::mutex mutex;
+    const void *type = nullptr;
+    std::shared_ptr<void> content;
+  };
+  std::shared_ptr<Decoded> decoded_ = std::make_shared<Decoded>();
+
+  // Tells types apart without RTTI
+  template <class Content>
+  static const void *typeKey() {
+    static const char key = 0;
+    return &key;
+  }
 
  public:
-  IncomingPayload(StreamPtrType stream) : stream_{std::move(stream)} {}
+  IncomingPayload(StreamPtrType stream)
+      : bytesOwner_{stream}, view_{*stream} {}
+  IncomingPayload(BytesOwnerType bytesOwner, StreamViewType view,
+                  bool partial = false)
+      : bytesOwner_{std::move(bytesOwner)}, view_{view}, partial_{partial} {}
   bool equal(const CSMsgPayloadIF *other) const override {
     if (other && (other != this)) {
       if (other->type() == CSPayloadType::IncomingData) {
         auto otherAsThis = static_cast<const IncomingPayload *>(other);
         // Don't compare content of stream
-        return otherAsThis->stream() == this->stream();
+        return otherAsThis->bytesOwner_ == this->bytesOwner_;
       }
     }
     return false;
   }
   CSPayloadType type() const override { return CSPayloadType::IncomingData; }
   CSMsgPayloadIF *clone() const override {
-    assert(stream_);
-    return new IncomingPayload(stream());
+    assert(bytesOwner_);
+    return new IncomingPayload(*this);
+  }
+
+  bool partial() const override { return partial_; }
+  std::shared_ptr<CSMsgPayloadIF> patchedOnto(
+      std::shared_ptr<CSMsgPayloadIF> base) const override {
+    auto patched = std::make_shared<IncomingPayload>(*this);
+    patched->base_ = std::move(base);
+    // Decodes to a content of its own, the changes alone do not decode
+    patched->decoded_ = std::make_shared<Decoded>();
+    return patched;
   }
 
-  const StreamPtrType &stream() const { return stream_; }
-  StreamViewType streamView() const { return StreamViewType(*stream_); }
+  bool hasSource() const { return bytesOwner_ != nullptr; }
+  StreamViewType streamView() const { return view_; }
+  const std::shared_ptr<CSMsgPayloadIF> &base() const { return base_; }
+
+  //! Content decoded before as Content, null if not decoded or as another type
+  template <class Content>
+  std::shared_ptr<Content> decoded() const {
+    std::lock_guard lock(decoded_->mutex);
+    if (decoded_->type == typeKey<Content>()) {
+      return std::static_pointer_cast<Content>(decoded_->content);
+    }
+    return {};
+  }
+
+  template <class Content>
+  void keepDecoded(std::shared_ptr<Content> content) const {
+    std::lock_guard lock(decoded_->mutex);
+    decoded_->type = typeKey<Content>();
+    decoded_->content = std::move(content);
+  }
 };
 
 }  // namespace local
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <maf/messaging/client-server/CSMsgPayloadIF.h>
+#include <maf/utils/serialization/FieldChanges.h>
 #include <maf/utils/serialization/OByteStream.h>
 #include <maf/utils/serialization/Serializer.h>
 
@@ -16,8 +17,15 @@ class MAF_EXPORT OutgoingPayload : public CSMsgPayloadIF {
   CSPayloadType type() const override { return CSPayloadType::OutgoingData; }
   virtual ~OutgoingPayload() = default;
   virtual bool serialize(srz::OByteStream &os) const = 0;
+  //! Status updates can also be written as the fields changed since the
+  //! previous status, for receivers which keep it
+  virtual bool hasChanges() const { return false; }
+  virtual bool serializeChanges(srz::OByteStream &) const { return false; }
 };
 
+template <class Content>
+class OutgoingChangesT;
+
 template <class Content>
 class OutgoingPayloadT : public OutgoingPayload {
  public:
@@ -43,6 +51,25 @@ class OutgoingPayloadT : public OutgoingPayload {
     return new OutgoingPayloadT(content());
   }
 
+  std::shared_ptr<CSMsgPayloadIF> changesSince(
+      const CSMsgPayloadIF *previous) const override {
+    if constexpr (srz::is_tuplizable_type_v<Content>) {
+      if (content_ && previous &&
+          previous->type() == CSPayloadType::OutgoingData) {
+        if (auto &before =
+                static_cast<const OutgoingPayloadT *>(previous)->content()) {
+          return std::make_shared<OutgoingChangesT<Content>>(
+              content_, srz::changedFields(*before, *content_));
+        }
+      }
+    }
+    return {};
+  }
+
+  std::optional<double> numericField(size_t index) const override {
+    return content_ ? srz::numericField(*content_, index) : std::nullopt;
+  }
+
   bool serialize(srz::OByteStream &os) const override {
     if (content_) {
       srz::SR sr(os);
@@ -56,6 +83,26 @@ class OutgoingPayloadT : public OutgoingPayload {
   ContentType content_;
 };
 
+template <class Content>
+class OutgoingChangesT : public OutgoingPayloadT<Content> {
+ public:
+  using ContentType = typename OutgoingPayloadT<Content>::ContentType;
+  using FieldBits = srz::FieldBits<Content>;
+
+  OutgoingChangesT(const ContentType &content, FieldBits changed)
+      : OutgoingPayloadT<Content>{content}, changed_{changed} {}
+
+  CSMsgPayloadIF *clone() const override { return new OutgoingChangesT(*this); }
+  bool hasChanges() const override { return true; }
+  bool serializeChanges(srz::OByteStream &os) const override {
+    srz::serializeChanges(os, *this->content(), changed_);
+    return !os.fail();
+  }
+
+ private:
+  FieldBits changed_;
+};
+
 }  // namespace local
 }  // namespace ipc
 }  // namespace messaging
@@ -4,6 +4,7 @@
 #include <maf/messaging/client-server/ParamTraitBase.h>
 #include <maf/messaging/client-server/ParamTranslatingStatus.h>
 #include <maf/utils/Pointers.h>
+#include <maf/utils/serialization/FieldChanges.h>
 #include <maf/utils/serialization/Serializer.h>
 
 #include "IncomingPayload.h"
@@ -38,22 +39,22 @@ class ParamTrait : public ParamTraitBase {
       // CSPayloadIFPtr as std::shared_ptr of IncomingMsgContent
       auto incomingPayload = static_cast<IncomingPayload *>(payload.get());
 
-      std::shared_ptr<PureContentType> content;
-      if (incomingPayload->stream()) {
+      if (!incomingPayload->hasSource()) {
+        assign_ptr(status, TranslationStatus::NoSource);
+        return {};
+      }
+      // Decoded once, the subscribers and the cached status share it
+      auto content = incomingPayload->template decoded<PureContentType>();
+      if (content) {
+        assign_ptr(status, TranslationStatus::Success);
+      } else {
         content.reset(new PureContentType);
-        auto streamView = incomingPayload->streamView();
-
-        auto ds = srz::DSR{streamView};
-
-        ds >> *content;
-
-        if (!streamView.fail()) {
+        if (decodeInto(*incomingPayload, *content)) {
+          incomingPayload->keepDecoded(content);
           assign_ptr(status, TranslationStatus::Success);
         } else {
           assign_ptr(status, TranslationStatus::SourceCorrupted);
         }
-      } else {
-        assign_ptr(status, TranslationStatus::NoSource);
       }
       return content;
 
@@ -79,6 +80,28 @@ class ParamTrait : public ParamTraitBase {
     }
     //    return "Not Dumpable!";
   }
+
+ private:
+  // Changes are decoded over the status they were made against
+  template <class Content>
+  static bool decodeInto(const IncomingPayload &payload, Content &content) {
+    auto streamView = payload.streamView();
+    if (!payload.partial()) {
+      srz::DSR{streamView} >> content;
+      return !streamView.fail();
+    }
+    if constexpr (srz::is_tuplizable_type_v<Content>) {
+      // The base decodes once too, its content is copied before patching
+      auto &base = payload.base();
+      if (base && base->type() == CSPayloadType::IncomingData) {
+        if (auto baseContent = translate<Content>(base)) {
+          content = *baseContent;
+          return srz::deserializeChanges(streamView, content);
+        }
+      }
+    }
+    return false;
+  }
 };
 
 }  // namespace local
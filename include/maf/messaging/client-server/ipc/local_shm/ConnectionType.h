@@ -0,0 +1,14 @@
+#pragma once
+
+namespace maf {
+namespace messaging {
+namespace ipc {
+namespace local_shm {
+
+//! Same messages as ipc::local, carried through shared memory rings
+inline constexpr auto connection_type = "local_shm.ipc.messaging.maf";
+
+}  // namespace local_shm
+}  // namespace ipc
+}  // namespace messaging
+}  // namespace maf
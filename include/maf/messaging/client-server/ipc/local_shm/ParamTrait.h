@@ -0,0 +1,15 @@
+#pragma once
+
+#include <maf/messaging/client-server/ipc/local/ParamTrait.h>
+
+namespace maf {
+namespace messaging {
+namespace ipc {
+namespace local_shm {
+
+using ParamTrait = local::ParamTrait;
+
+}  // namespace local_shm
+}  // namespace ipc
+}  // namespace messaging
+}  // namespace maf
@@ -2,6 +2,7 @@
 
 #include <maf/messaging/client-server/CSMsgPayloadIF.h>
 #include <maf/messaging/client-server/cs_param.h>
+#include <maf/utils/serialization/FieldChanges.h>
 #include <memory>
 
 namespace maf {
@@ -37,6 +38,10 @@ public:
     return new Payload(type_, content_);
   }
 
+  std::optional<double> numericField(size_t index) const override {
+    return content_ ? srz::numericField(*content_, index) : std::nullopt;
+  }
+
 private:
   ContentType content_;
   CSPayloadType type_ = CSPayloadType::NA;
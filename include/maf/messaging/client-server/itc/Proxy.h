@@ -1,5 +1,6 @@
 #pragma once
 
+#include <maf/export/MafExport_global.h>
 #include <maf/messaging/client-server/BasicProxy.h>
 
 #include "ConnectionType.h"
@@ -23,6 +24,11 @@ inline ProxyPtr createProxy(const ServiceID &sid = {},
                             std::move(statusObsv));
 }
 
+//! Requests to a service of this process call its handler directly, turned
+//! off they go through messages like to any other service, for measuring or
+//! debugging that path. Applies to services becoming available afterwards
+MAF_EXPORT void setDirectRequests(bool enabled);
+
 }  // namespace itc
 }  // namespace messaging
 }  // namespace maf
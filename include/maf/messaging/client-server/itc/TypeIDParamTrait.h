@@ -18,7 +18,8 @@ struct output_base {};
 #define MAF_CS_SIMPLE_REQUEST(RequestName, Input, Output)                 \
   struct RequestName##Request {                                           \
     static constexpr OpIDConst operationID() {                            \
-      return #RequestName #Input #Output;                                 \
+      return maf::messaging::InternedID::fromLiteral(                     \
+          #RequestName #Input #Output);                                   \
     }                                                                     \
     struct input : public Input, maf::messaging::details::input_base {    \
       using Input::Input;                                                 \
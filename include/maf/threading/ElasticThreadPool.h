@@ -0,0 +1,54 @@
+#pragma once
+
+#include <maf/export/MafExport_global.h>
+
+#include <chrono>
+
+#include "IThreadPool.h"
+
+namespace maf {
+namespace threading {
+
+/*! \brief Thread pool that grows under load and shrinks when idle
+ * A thread is added when pending tasks outnumber what the live threads can
+ * absorb, or when a task has waited longer than maxQueueLatency. Threads that
+ * stay idle for idleTimeout retire until minThreads are left.
+ */
+class ElasticThreadPool : public IThreadPool {
+public:
+  struct Config {
+    unsigned int minThreads = 0;
+    // 0 means std::thread::hardware_concurrency()
+    unsigned int maxThreads = 0;
+    // Pending tasks each live thread is expected to absorb before growing
+    unsigned int queueDepthPerThread = 1;
+    std::chrono::milliseconds maxQueueLatency{5};
+    std::chrono::milliseconds idleTimeout{2000};
+  };
+
+  struct Stats {
+    unsigned long long spawned = 0;
+    unsigned long long retired = 0;
+    unsigned int alive = 0;
+    unsigned int idle = 0;
+    size_t pending = 0;
+  };
+
+  MAF_EXPORT ElasticThreadPool(Config config);
+  MAF_EXPORT ElasticThreadPool(unsigned int maxThreadCount = 0);
+  MAF_EXPORT ~ElasticThreadPool() override;
+  MAF_EXPORT void run(Runnable *pRuner, unsigned int priority = 0) override;
+  MAF_EXPORT void runBatch(Runnable *const *runners, size_t count,
+                           unsigned int priority = 0) override;
+  //! Lowering the max retires the surplus threads once they finish their task
+  MAF_EXPORT void setMaxThreadCount(unsigned int nThreadCount) override;
+  MAF_EXPORT unsigned int activeThreadCount() override;
+  MAF_EXPORT void shutdown() override;
+  MAF_EXPORT Stats stats() const;
+
+private:
+  struct ElasticImpl *_pImpl;
+};
+
+} // namespace threading
+} // namespace maf
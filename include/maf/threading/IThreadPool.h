@@ -1,6 +1,13 @@
 #pragma once
 
+#include <functional>
+#include <type_traits>
+#include <vector>
+
 #include "Runnable.h"
+#include "TaskGroup.h"
+#include "TaskRunners.h"
+#include "Upcoming.h"
 
 namespace maf {
 namespace threading {
@@ -8,10 +15,63 @@ namespace threading {
 class IThreadPool {
 public:
   virtual void run(Runnable *pRuner, unsigned int priority = 0) = 0;
+  //! Same as calling run for each task, pools may enqueue them in one go
+  virtual void runBatch(Runnable *const *runners, size_t count,
+                        unsigned int priority = 0) {
+    for (size_t i = 0; i < count; ++i) {
+      run(runners[i], priority);
+    }
+  }
   virtual void setMaxThreadCount(unsigned int nThreadCount) = 0;
   virtual unsigned int activeThreadCount() = 0;
   virtual void shutdown() = 0;
   virtual ~IThreadPool() {}
+
+  //! Runs f without collecting its result
+  template <class F> void post(F &&f, unsigned int priority = 0) {
+    run(new details::CallableRunner<std::decay_t<F>>{std::forward<F>(f)},
+        priority);
+  }
+
+  //! Runs f and lets group wait for it
+  template <class F>
+  void post(TaskGroup &group, F &&f, unsigned int priority = 0) {
+    run(new details::GroupedRunner<std::decay_t<F>>{group, std::forward<F>(f)},
+        priority);
+  }
+
+  //! Runs f and delivers its result, or its exception
+  template <class F, class R = std::invoke_result_t<std::decay_t<F> &>>
+  Upcoming<R> submit(F &&f, unsigned int priority = 0) {
+    auto runner =
+        new details::PromisedRunner<std::decay_t<F>, R>{std::forward<F>(f)};
+    auto future = runner->getFuture();
+    run(runner, priority);
+    return Upcoming<R>{std::move(future)};
+  }
+
+  //! Runs f(0) .. f(count - 1) as separate tasks, the result is ready once
+  //! all of them are done and holds the first exception thrown if any
+  template <class F>
+  Upcoming<void> submitBulk(size_t count, F &&f, unsigned int priority = 0) {
+    using State = details::BulkState<std::decay_t<F>>;
+    using Runner = details::BulkRunner<std::decay_t<F>>;
+    if (count == 0) {
+      std::promise<void> nothingToDo;
+      nothingToDo.set_value();
+      return Upcoming<void>{nothingToDo.get_future()};
+    }
+
+    auto state = new State{count, std::forward<F>(f)};
+    auto future = state->promise.get_future();
+    std::vector<Runnable *> runners;
+    runners.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+      runners.push_back(new Runner{state, i});
+    }
+    runBatch(runners.data(), count, priority);
+    return Upcoming<void>{std::move(future)};
+  }
 };
 
 } // namespace threading
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace maf {
+namespace threading {
+
+/*! \brief Bounded lock-free multi producer/multi consumer FIFO
+ * Dmitry Vyukov's sequence-numbered cell array: a producer or consumer claims
+ * a slot with one CAS on its own index, the cell's sequence tells whether the
+ * slot is ready. Capacity is rounded up to a power of two.
+ */
+template <class T> class MPMCRing {
+  struct Cell {
+    std::atomic<size_t> sequence;
+    T data;
+  };
+
+public:
+  using value_type = T;
+
+  explicit MPMCRing(size_t capacity) {
+    size_t cap = 2;
+    while (cap < capacity) {
+      cap <<= 1;
+    }
+    _mask = cap - 1;
+    _cells.reset(new Cell[cap]);
+    for (size_t i = 0; i < cap; ++i) {
+      _cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  MPMCRing(const MPMCRing &) = delete;
+  MPMCRing &operator=(const MPMCRing &) = delete;
+
+  size_t capacity() const { return _mask + 1; }
+
+  //! Approximate when other threads are pushing or popping
+  size_t size() const {
+    auto tail = _enqueuePos.load(std::memory_order_acquire);
+    auto head = _dequeuePos.load(std::memory_order_acquire);
+    return tail > head ? tail - head : 0;
+  }
+
+  //! value is left untouched if the ring is full
+  template <class U> bool tryPush(U &&value) {
+    auto pos = _enqueuePos.load(std::memory_order_relaxed);
+    Cell *cell;
+    while (true) {
+      cell = &_cells[pos & _mask];
+      auto seq = cell->sequence.load(std::memory_order_acquire);
+      auto diff = static_cast<std::ptrdiff_t>(seq) -
+                  static_cast<std::ptrdiff_t>(pos);
+      if (diff == 0) {
+        if (_enqueuePos.compare_exchange_weak(pos, pos + 1,
+                                              std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false; // full
+      } else {
+        pos = _enqueuePos.load(std::memory_order_relaxed);
+      }
+    }
+    cell->data = std::forward<U>(value);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool tryPop(T &value) {
+    auto pos = _dequeuePos.load(std::memory_order_relaxed);
+    Cell *cell;
+    while (true) {
+      cell = &_cells[pos & _mask];
+      auto seq = cell->sequence.load(std::memory_order_acquire);
+      auto diff = static_cast<std::ptrdiff_t>(seq) -
+                  static_cast<std::ptrdiff_t>(pos + 1);
+      if (diff == 0) {
+        if (_dequeuePos.compare_exchange_weak(pos, pos + 1,
+                                              std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false; // empty
+      } else {
+        pos = _dequeuePos.load(std::memory_order_relaxed);
+      }
+    }
+    value = std::move(cell->data);
+    cell->sequence.store(pos + _mask + 1, std::memory_order_release);
+    return true;
+  }
+
+  //! Moves elements from first until the ring is full, returns how many
+  template <class InputIt> size_t tryPushN(InputIt first, size_t count) {
+    size_t pushed = 0;
+    while (pushed < count && tryPush(std::move(*first))) {
+      ++first;
+      ++pushed;
+    }
+    return pushed;
+  }
+
+  template <class OutputIt> size_t tryPopN(OutputIt out, size_t maxCount) {
+    size_t popped = 0;
+    T value;
+    while (popped < maxCount && tryPop(value)) {
+      *out++ = std::move(value);
+      ++popped;
+    }
+    return popped;
+  }
+
+private:
+  std::unique_ptr<Cell[]> _cells;
+  size_t _mask;
+  alignas(64) std::atomic<size_t> _enqueuePos{0};
+  alignas(64) std::atomic<size_t> _dequeuePos{0};
+};
+
+} // namespace threading
+} // namespace maf
@@ -0,0 +1,289 @@
+#pragma once
+
+#include <maf/logging/Logger.h>
+#include <maf/utils/ExecutorIF.h>
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "IThreadPool.h"
+#include "Upcoming.h"
+
+// Data parallel helpers running on an IThreadPool.
+// A range is cut into chunks, one pool task per chunk. The result is
+// delivered either as an Upcoming or by executing a callback on an executor,
+// e.g this_component::getExecutor() to get it back on the calling component.
+// Pool threads must not block on the returned Upcoming, that may deadlock a
+// pool whose threads are all waiting.
+
+namespace maf {
+namespace threading {
+
+//! Number of elements handled by one task, 0 lets the helpers pick one that
+//! gives each pool thread a few chunks to balance uneven work
+struct ChunkSize {
+  size_t value = 0;
+};
+
+namespace details {
+
+struct NoResult {};
+
+inline size_t chunkSizeFor(IThreadPool &pool, size_t count, ChunkSize chunk) {
+  if (chunk.value != 0) {
+    return chunk.value;
+  }
+  size_t threads = pool.activeThreadCount();
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  return std::max<size_t>(1, count / (threads * 4));
+}
+
+// Lives as long as one of its chunk tasks does, so the completion handler
+// runs exactly once: when the last task finished or was dropped by the pool
+template <class Result, class ChunkFunc, class OnDone> class ChunkedJob {
+public:
+  ChunkedJob(size_t chunks, ChunkFunc f, OnDone onDone)
+      : chunkFunc_{std::move(f)}, onDone_{std::move(onDone)}, chunks_{chunks},
+        partials_(std::is_same_v<Result, NoResult> ? 0 : chunks) {}
+
+  ~ChunkedJob() {
+    auto error = error_;
+    if (!error && executed_.load(std::memory_order_acquire) != chunks_) {
+      error = std::make_exception_ptr(
+          std::future_error{std::future_errc::broken_promise});
+    }
+    onDone_(error, partials_);
+  }
+
+  void runChunk(size_t k) {
+    try {
+      if constexpr (std::is_same_v<Result, NoResult>) {
+        chunkFunc_(k);
+      } else {
+        partials_[k].emplace(chunkFunc_(k));
+      }
+    } catch (...) {
+      if (!errorTaken_.test_and_set(std::memory_order_relaxed)) {
+        error_ = std::current_exception();
+      }
+    }
+    executed_.fetch_add(1, std::memory_order_acq_rel);
+  }
+
+private:
+  ChunkFunc chunkFunc_;
+  OnDone onDone_;
+  size_t chunks_;
+  std::vector<std::optional<Result>> partials_;
+  std::atomic<size_t> executed_{0};
+  std::atomic_flag errorTaken_ = ATOMIC_FLAG_INIT;
+  std::exception_ptr error_;
+};
+
+template <class Result, class ChunkFunc, class OnDone>
+void runChunks(IThreadPool &pool, size_t chunks, ChunkFunc chunkFunc,
+               OnDone onDone) {
+  using Job = ChunkedJob<Result, ChunkFunc, OnDone>;
+  auto job = std::make_shared<Job>(chunks, std::move(chunkFunc),
+                                   std::move(onDone));
+  std::vector<Runnable *> runners;
+  runners.reserve(chunks);
+  for (size_t k = 0; k < chunks; ++k) {
+    auto task = [job, k] { job->runChunk(k); };
+    runners.push_back(new CallableRunner<decltype(task)>{std::move(task)});
+  }
+  job.reset();
+  pool.runBatch(runners.data(), runners.size());
+}
+
+template <class T, class Combine>
+T combinePartials(T init, std::vector<std::optional<T>> &partials,
+                  const Combine &combine) {
+  for (auto &p : partials) {
+    init = combine(std::move(init), std::move(*p));
+  }
+  return init;
+}
+
+template <class Index, class F, class OnDone>
+void parallelFor(IThreadPool &pool, Index first, Index last, F f,
+                 ChunkSize chunk, OnDone onDone) {
+  auto count = first < last ? static_cast<size_t>(last - first) : 0;
+  auto size = chunkSizeFor(pool, count, chunk);
+  auto chunks = (count + size - 1) / size;
+  runChunks<NoResult>(
+      pool, chunks,
+      [f = std::move(f), first, last, size](size_t k) {
+        auto begin = first + static_cast<Index>(k * size);
+        auto end = last - begin > static_cast<Index>(size)
+                       ? begin + static_cast<Index>(size)
+                       : last;
+        for (auto i = begin; i != end; ++i) {
+          f(i);
+        }
+      },
+      std::move(onDone));
+}
+
+template <class Index, class T, class Map, class Combine, class OnDone>
+void parallelReduce(IThreadPool &pool, Index first, Index last, T identity,
+                    Map map, Combine combine, ChunkSize chunk,
+                    OnDone onDone) {
+  auto count = first < last ? static_cast<size_t>(last - first) : 0;
+  auto size = chunkSizeFor(pool, count, chunk);
+  auto chunks = (count + size - 1) / size;
+  auto sharedCombine = std::make_shared<const Combine>(std::move(combine));
+  runChunks<T>(
+      pool, chunks,
+      [map = std::move(map), sharedCombine, identity, first, last,
+       size](size_t k) {
+        auto begin = first + static_cast<Index>(k * size);
+        auto end = last - begin > static_cast<Index>(size)
+                       ? begin + static_cast<Index>(size)
+                       : last;
+        auto acc = identity;
+        for (auto i = begin; i != end; ++i) {
+          acc = (*sharedCombine)(std::move(acc), map(i));
+        }
+        return acc;
+      },
+      [onDone = std::move(onDone), sharedCombine,
+       identity](std::exception_ptr error,
+                 std::vector<std::optional<T>> &partials) mutable {
+        if (error) {
+          onDone(error, std::optional<T>{});
+        } else {
+          onDone(error, std::optional<T>{combinePartials(
+                            std::move(identity), partials, *sharedCombine)});
+        }
+      });
+}
+
+inline auto promiseSetter(std::shared_ptr<std::promise<void>> promise) {
+  return [promise = std::move(promise)](
+             std::exception_ptr error,
+             std::vector<std::optional<NoResult>> &) {
+    error ? promise->set_exception(error) : promise->set_value();
+  };
+}
+
+template <class Callback>
+auto executorPoster(util::ExecutorIFPtr executor, Callback callback) {
+  return [executor = std::move(executor), callback = std::move(callback)](
+             std::exception_ptr error,
+             std::vector<std::optional<NoResult>> &) mutable {
+    if (error) {
+      MAF_LOGGER_ERROR("parallel_for failed, skip posting its result");
+    } else if (!executor->execute(std::move(callback))) {
+      MAF_LOGGER_WARN("Executor rejected the result of parallel_for");
+    }
+  };
+}
+
+template <class Index>
+using EnableIfIndex = std::enable_if_t<std::is_integral_v<Index>, bool>;
+
+} // namespace details
+
+//! Calls f(i) for every i in [first, last). All the chunks share f and call
+//! it as const from several pool threads at once, it must be safe for that
+template <class Index, class F, details::EnableIfIndex<Index> = true>
+Upcoming<void> parallel_for(IThreadPool &pool, Index first, Index last, F f,
+                            ChunkSize chunk = {}) {
+  auto promise = std::make_shared<std::promise<void>>();
+  auto future = promise->get_future();
+  details::parallelFor(pool, first, last, std::move(f), chunk,
+                       details::promiseSetter(std::move(promise)));
+  return Upcoming<void>{std::move(future)};
+}
+
+//! Calls f(i) for every i in [first, last) then executes onDone() on
+//! executor, onDone is skipped if one of the calls threw
+template <class Index, class F, class OnDone,
+          details::EnableIfIndex<Index> = true>
+void parallel_for(IThreadPool &pool, Index first, Index last, F f,
+                  util::ExecutorIFPtr executor, OnDone onDone,
+                  ChunkSize chunk = {}) {
+  details::parallelFor(pool, first, last, std::move(f), chunk,
+                       details::executorPoster(std::move(executor),
+                                               std::move(onDone)));
+}
+
+//! Calls f(element) for every element of a random access container, the
+//! container must outlive the returned Upcoming
+template <class Container, class F>
+Upcoming<void> parallel_for_each(IThreadPool &pool, Container &c, F f,
+                                 ChunkSize chunk = {}) {
+  auto begin = std::begin(c);
+  return parallel_for(
+      pool, size_t{0}, static_cast<size_t>(std::size(c)),
+      [begin, f = std::move(f)](size_t i) { f(begin[i]); }, chunk);
+}
+
+//! Folds map(i) for i in [first, last) with combine, which must be
+//! associative with identity as its neutral element. map and combine are
+//! called as const from several threads at once, like f of parallel_for
+template <class Index, class T, class Map, class Combine,
+          details::EnableIfIndex<Index> = true>
+Upcoming<T> parallel_reduce(IThreadPool &pool, Index first, Index last,
+                            T identity, Map map, Combine combine,
+                            ChunkSize chunk = {}) {
+  auto promise = std::make_shared<std::promise<T>>();
+  auto future = promise->get_future();
+  details::parallelReduce(
+      pool, first, last, std::move(identity), std::move(map),
+      std::move(combine), chunk,
+      [promise](std::exception_ptr error, std::optional<T> result) {
+        error ? promise->set_exception(error)
+              : promise->set_value(std::move(*result));
+      });
+  return Upcoming<T>{std::move(future)};
+}
+
+//! Same as above but executes onDone(result) on executor, onDone is skipped
+//! if one of the calls threw
+template <class Index, class T, class Map, class Combine, class OnDone,
+          details::EnableIfIndex<Index> = true>
+void parallel_reduce(IThreadPool &pool, Index first, Index last, T identity,
+                     Map map, Combine combine, util::ExecutorIFPtr executor,
+                     OnDone onDone, ChunkSize chunk = {}) {
+  details::parallelReduce(
+      pool, first, last, std::move(identity), std::move(map),
+      std::move(combine), chunk,
+      [executor = std::move(executor), onDone = std::move(onDone)](
+          std::exception_ptr error, std::optional<T> result) mutable {
+        if (error) {
+          MAF_LOGGER_ERROR("parallel_reduce failed, skip posting its result");
+        } else if (!executor->execute(
+                       [onDone = std::move(onDone),
+                        result = std::move(*result)]() mutable {
+                         onDone(std::move(result));
+                       })) {
+          MAF_LOGGER_WARN("Executor rejected the result of parallel_reduce");
+        }
+      });
+}
+
+//! Folds map(element) over a random access container
+template <class Container, class T, class Map, class Combine>
+Upcoming<T> parallel_reduce(IThreadPool &pool, const Container &c, T identity,
+                            Map map, Combine combine, ChunkSize chunk = {}) {
+  auto begin = std::begin(c);
+  return parallel_reduce(
+      pool, size_t{0}, static_cast<size_t>(std::size(c)), std::move(identity),
+      [begin, map = std::move(map)](size_t i) { return map(begin[i]); },
+      std::move(combine), chunk);
+}
+
+} // namespace threading
+} // namespace maf
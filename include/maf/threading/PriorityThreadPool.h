@@ -0,0 +1,41 @@
+#pragma once
+
+#include <maf/export/MafExport_global.h>
+
+#include <cstddef>
+
+#include "IThreadPool.h"
+
+namespace maf {
+namespace threading {
+
+/*! \brief Fixed size pool scheduling tasks by priority band
+ * Priority p goes to band min(p, BAND_COUNT - 1), each band is a FIFO.
+ * Dequeuing is weighted-fair rather than strict: band b is served 2^b times
+ * out of every 2^BAND_COUNT - 1 turns when all bands are busy, so a flood of
+ * high priority tasks slows low priority ones down without starving them.
+ */
+class PriorityThreadPool : public IThreadPool {
+public:
+  static constexpr unsigned int BAND_COUNT = 8;
+
+  struct BandStats {
+    unsigned long long submitted = 0;
+    unsigned long long executed = 0;
+    size_t pending = 0;
+  };
+
+  MAF_EXPORT PriorityThreadPool(unsigned int threadCount = 0);
+  MAF_EXPORT ~PriorityThreadPool() override;
+  MAF_EXPORT void run(Runnable *pRuner, unsigned int priority = 0) override;
+  void setMaxThreadCount(unsigned int /*nThreadCount*/) override {}
+  MAF_EXPORT unsigned int activeThreadCount() override;
+  MAF_EXPORT void shutdown() override;
+  MAF_EXPORT BandStats bandStats(unsigned int band) const;
+
+private:
+  struct TheImpl *_pImpl;
+};
+
+} // namespace threading
+} // namespace maf
@@ -1,5 +1,8 @@
 #pragma once
 
+#include "MPMCRing.h"
+#include "RingQueue.h"
+#include "SPSCRing.h"
 #include "ThreadSafeQueue.h"
 
 namespace maf {
@@ -8,6 +11,8 @@ namespace threading {
 template <typename T> using Queue = ThreadSafeQueue<stdwrap::Queue<T>>;
 template <typename T, typename Comp = std::less<T>>
 using PriorityQueue = ThreadSafeQueue<stdwrap::PriorityQueue<T, Comp>>;
+template <typename T> using BoundedQueue = RingQueue<MPMCRing<T>>;
+template <typename T> using SPSCQueue = RingQueue<SPSCRing<T>>;
 
 } // namespace threading
 } // namespace maf
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <type_traits>
+
+namespace maf {
+namespace threading {
+
+/*! \brief Bounded blocking queue over a lock-free ring
+ * Same interface as ThreadSafeQueue, so Queue<T> users can switch with a
+ * typedef. push and pop go straight to the ring, the mutex is only taken to
+ * park a thread that finds the ring empty or full, or to wake one up.
+ * Unlike ThreadSafeQueue, push blocks while the ring is full: a consumer must
+ * not push into its own queue once it may be full.
+ */
+template <class Ring> class RingQueue {
+public:
+  using value_type = typename Ring::value_type;
+  using reference = value_type &;
+  using const_reference = const value_type &;
+  using ApplyAction = std::function<void(value_type &)>;
+  static constexpr size_t DEFAULT_CAPACITY = 1024;
+
+  explicit RingQueue(size_t capacity = DEFAULT_CAPACITY) : ring_{capacity} {}
+  ~RingQueue() { close(); }
+
+  bool empty() const { return ring_.size() == 0; }
+  size_t size() const { return ring_.size(); }
+  size_t capacity() const { return ring_.capacity(); }
+
+  //! Blocks while the queue is full, returns false if it is closed
+  bool push(const value_type &data) { return pushImpl(data); }
+  bool push(value_type &&data) { return pushImpl(std::move(data)); }
+
+  //! Returns false without blocking if the queue is full or closed
+  template <class U> bool tryPush(U &&data) {
+    if (isClosed() || !ring_.tryPush(std::forward<U>(data))) {
+      return false;
+    }
+    wake(notEmpty_, consumersWaiting_, false);
+    return true;
+  }
+
+  //! Pushes the whole range, blocking while the queue is full.
+  //! Returns how many elements were pushed before the queue got closed
+  template <class InputIt> size_t pushN(InputIt first, InputIt last) {
+    auto total = static_cast<size_t>(std::distance(first, last));
+    size_t pushed = 0;
+    while (pushed < total && !isClosed()) {
+      auto n = ring_.tryPushN(first, total - pushed);
+      if (n != 0) {
+        std::advance(first, n);
+        pushed += n;
+        wake(notEmpty_, consumersWaiting_, n > 1);
+      } else {
+        parkUntil(notFull_, producersWaiting_, NoDeadline{},
+                  [this] { return ring_.size() < ring_.capacity(); });
+      }
+    }
+    return pushed;
+  }
+
+  template <class TimePoint>
+  bool waitUntil(value_type &value, const TimePoint &absTime) {
+    while (!isClosed()) {
+      if (ring_.tryPop(value)) {
+        wake(notFull_, producersWaiting_, false);
+        return true;
+      }
+      if (!parkUntil(notEmpty_, consumersWaiting_, absTime,
+                     [this] { return !empty(); })) {
+        return false;
+      }
+    }
+    return false;
+  }
+
+  template <class Duration,
+            std::enable_if_t<!std::is_arithmetic_v<Duration>, bool> = true>
+  bool waitFor(value_type &value, const Duration &interval) {
+    return waitUntil(value, std::chrono::steady_clock::now() + interval);
+  }
+
+  bool waitFor(value_type &value, long long ms) {
+    return waitFor(value, std::chrono::milliseconds{ms});
+  }
+
+  bool wait(value_type &value) { return waitUntil(value, NoDeadline{}); }
+
+  bool tryPop(value_type &value) {
+    if (isClosed() || !ring_.tryPop(value)) {
+      return false;
+    }
+    wake(notFull_, producersWaiting_, false);
+    return true;
+  }
+
+  //! Waits for at least one element then takes up to maxCount of them.
+  //! Returns 0 once the queue is closed
+  template <class OutputIt> size_t popN(OutputIt out, size_t maxCount) {
+    while (maxCount != 0 && !isClosed()) {
+      if (auto n = ring_.tryPopN(out, maxCount)) {
+        wake(notFull_, producersWaiting_, n > 1);
+        return n;
+      }
+      parkUntil(notEmpty_, consumersWaiting_, NoDeadline{},
+                [this] { return !empty(); });
+    }
+    return 0;
+  }
+
+  void reOpen() { closed_.store(false, std::memory_order_release); }
+
+  void close() {
+    if (!closed_.exchange(true, std::memory_order_acq_rel)) {
+      std::lock_guard lock(mutex_);
+      notEmpty_.notify_all();
+      notFull_.notify_all();
+    }
+  }
+
+  bool isClosed() const { return closed_.load(std::memory_order_acquire); }
+
+  void clear(ApplyAction onClearCallback = nullptr) {
+    value_type v;
+    while (ring_.tryPop(v)) {
+      if (onClearCallback) {
+        onClearCallback(v);
+      }
+    }
+    wake(notFull_, producersWaiting_, true);
+  }
+
+private:
+  struct NoDeadline {};
+
+  // Returns false on timeout. The waiting count is raised under the mutex and
+  // the waker checks it after a full fence, so either the waker sees a
+  // sleeper or the sleeper sees the new state in its predicate
+  template <class TimePoint, class Pred>
+  bool parkUntil(std::condition_variable &cv, std::atomic<unsigned> &waiting,
+                 const TimePoint &absTime, Pred ready) {
+    std::unique_lock lock(mutex_);
+    waiting.fetch_add(1, std::memory_order_seq_cst);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto pred = [&] { return isClosed() || ready(); };
+    bool woken = true;
+    if constexpr (std::is_same_v<TimePoint, NoDeadline>) {
+      cv.wait(lock, pred);
+    } else {
+      woken = cv.wait_until(lock, absTime, pred);
+    }
+    waiting.fetch_sub(1, std::memory_order_relaxed);
+    return woken;
+  }
+
+  void wake(std::condition_variable &cv, std::atomic<unsigned> &waiting,
+            bool all) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiting.load(std::memory_order_relaxed) != 0) {
+      { std::lock_guard lock(mutex_); }
+      all ? cv.notify_all() : cv.notify_one();
+    }
+  }
+
+  template <class U> bool pushImpl(U &&data) {
+    while (!isClosed()) {
+      if (ring_.tryPush(std::forward<U>(data))) {
+        wake(notEmpty_, consumersWaiting_, false);
+        return true;
+      }
+      parkUntil(notFull_, producersWaiting_, NoDeadline{},
+                [this] { return ring_.size() < ring_.capacity(); });
+    }
+    return false;
+  }
+
+  Ring ring_;
+  std::mutex mutex_;
+  std::condition_variable notEmpty_;
+  std::condition_variable notFull_;
+  std::atomic<unsigned> consumersWaiting_{0};
+  std::atomic<unsigned> producersWaiting_{0};
+  std::atomic_bool closed_{false};
+};
+
+} // namespace threading
+} // namespace maf
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace maf {
+namespace threading {
+
+/*! \brief Bounded lock-free FIFO for exactly one producer and one consumer
+ * Each side owns its index and keeps a cached copy of the other one, so the
+ * shared cache lines are only touched when the cached view says the ring looks
+ * full or empty. Batch operations publish their elements with a single store.
+ * Capacity is rounded up to a power of two.
+ */
+template <class T> class SPSCRing {
+public:
+  using value_type = T;
+
+  explicit SPSCRing(size_t capacity) {
+    size_t cap = 2;
+    while (cap < capacity) {
+      cap <<= 1;
+    }
+    _mask = cap - 1;
+    _slots.reset(new T[cap]);
+  }
+
+  SPSCRing(const SPSCRing &) = delete;
+  SPSCRing &operator=(const SPSCRing &) = delete;
+
+  size_t capacity() const { return _mask + 1; }
+
+  size_t size() const {
+    auto head = _head.load(std::memory_order_acquire);
+    return _tail.load(std::memory_order_acquire) - head;
+  }
+
+  //! Producer side, value is left untouched if the ring is full
+  template <class U> bool tryPush(U &&value) {
+    auto tail = _tail.load(std::memory_order_relaxed);
+    if (tail - _cachedHead > _mask) {
+      _cachedHead = _head.load(std::memory_order_acquire);
+      if (tail - _cachedHead > _mask) {
+        return false;
+      }
+    }
+    _slots[tail & _mask] = std::forward<U>(value);
+    _tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  //! Consumer side
+  bool tryPop(T &value) {
+    auto head = _head.load(std::memory_order_relaxed);
+    if (head == _cachedTail) {
+      _cachedTail = _tail.load(std::memory_order_acquire);
+      if (head == _cachedTail) {
+        return false;
+      }
+    }
+    value = std::move(_slots[head & _mask]);
+    _head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  //! Producer side, moves elements from first until the ring is full
+  template <class InputIt> size_t tryPushN(InputIt first, size_t count) {
+    auto tail = _tail.load(std::memory_order_relaxed);
+    auto space = capacity() - (tail - _cachedHead);
+    if (space < count) {
+      _cachedHead = _head.load(std::memory_order_acquire);
+      space = capacity() - (tail - _cachedHead);
+    }
+    auto n = count < space ? count : space;
+    for (size_t i = 0; i < n; ++i, ++first) {
+      _slots[(tail + i) & _mask] = std::move(*first);
+    }
+    _tail.store(tail + n, std::memory_order_release);
+    return n;
+  }
+
+  //! Consumer side
+  template <class OutputIt> size_t tryPopN(OutputIt out, size_t maxCount) {
+    auto head = _head.load(std::memory_order_relaxed);
+    auto available = _cachedTail - head;
+    if (available < maxCount) {
+      _cachedTail = _tail.load(std::memory_order_acquire);
+      available = _cachedTail - head;
+    }
+    auto n = maxCount < available ? maxCount : available;
+    for (size_t i = 0; i < n; ++i) {
+      *out++ = std::move(_slots[(head + i) & _mask]);
+    }
+    _head.store(head + n, std::memory_order_release);
+    return n;
+  }
+
+private:
+  std::unique_ptr<T[]> _slots;
+  size_t _mask;
+  alignas(64) std::atomic<size_t> _tail{0};
+  size_t _cachedHead = 0;
+  alignas(64) std::atomic<size_t> _head{0};
+  size_t _cachedTail = 0;
+};
+
+} // namespace threading
+} // namespace maf
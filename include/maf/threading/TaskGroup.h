@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+namespace maf {
+namespace threading {
+
+/*! \brief Counts outstanding tasks and lets a thread wait for all of them
+ * Cheaper than collecting one Upcoming per task: no shared state per task,
+ * just one atomic decrement when a task finishes. Tasks dropped by a pool
+ * that shuts down count as finished too, waiters never hang on them.
+ */
+class TaskGroup {
+public:
+  TaskGroup() = default;
+  TaskGroup(const TaskGroup &) = delete;
+  TaskGroup &operator=(const TaskGroup &) = delete;
+
+  void add(size_t count = 1) {
+    pending_.fetch_add(count, std::memory_order_relaxed);
+  }
+
+  void done() {
+    if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      std::lock_guard lock(mutex_);
+      allDone_.notify_all();
+    }
+  }
+
+  size_t pending() const { return pending_.load(std::memory_order_acquire); }
+
+  void wait() {
+    if (pending() != 0) {
+      std::unique_lock lock(mutex_);
+      allDone_.wait(lock, [this] { return pending() == 0; });
+    }
+  }
+
+  template <class Duration> bool waitFor(const Duration &timeout) {
+    if (pending() == 0) {
+      return true;
+    }
+    std::unique_lock lock(mutex_);
+    return allDone_.wait_for(lock, timeout, [this] { return pending() == 0; });
+  }
+
+private:
+  std::atomic<size_t> pending_{0};
+  std::mutex mutex_;
+  std::condition_variable allDone_;
+};
+
+} // namespace threading
+} // namespace maf
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <atomic>
+#include <exception>
+#include <future>
+#include <type_traits>
+
+#include "Runnable.h"
+#include "TaskGroup.h"
+
+namespace maf {
+namespace threading {
+namespace details {
+
+// The callable lives inside the runner itself, so a task costs one allocation
+// no matter how big its captures are. Pools queue Runnable pointers, and the
+// work-stealing deque must steal a slot with one atomic word read, so the
+// runner cannot be stored inline in a queue slot instead
+
+template <class F> class CallableRunner : public Runnable {
+public:
+  template <class Fn>
+  explicit CallableRunner(Fn &&f) : callable_{std::forward<Fn>(f)} {
+    setAutoDeleted(true);
+  }
+  void run() override { callable_(); }
+
+private:
+  F callable_;
+};
+
+// If the pool drops the task, the promise is destroyed unset and the waiting
+// side gets a broken promise
+template <class F, class R> class PromisedRunner : public Runnable {
+public:
+  template <class Fn>
+  explicit PromisedRunner(Fn &&f) : callable_{std::forward<Fn>(f)} {
+    setAutoDeleted(true);
+  }
+
+  std::future<R> getFuture() { return promise_.get_future(); }
+
+  void run() override {
+    try {
+      if constexpr (std::is_void_v<R>) {
+        callable_();
+        promise_.set_value();
+      } else {
+        promise_.set_value(callable_());
+      }
+    } catch (...) {
+      promise_.set_exception(std::current_exception());
+    }
+  }
+
+private:
+  F callable_;
+  std::promise<R> promise_;
+};
+
+template <class F> class GroupedRunner : public Runnable {
+public:
+  template <class Fn>
+  GroupedRunner(TaskGroup &group, Fn &&f)
+      : group_{group}, callable_{std::forward<Fn>(f)} {
+    setAutoDeleted(true);
+    group_.add();
+  }
+  ~GroupedRunner() override { group_.done(); }
+  void run() override { callable_(); }
+
+private:
+  TaskGroup &group_;
+  F callable_;
+};
+
+// Shared by all tasks of one submitBulk call, the last runner to go away
+// settles the promise and frees it
+template <class F> struct BulkState {
+  template <class Fn>
+  BulkState(size_t count, Fn &&f)
+      : callable{std::forward<Fn>(f)}, total{count}, remaining{count} {}
+
+  void finishOne() {
+    if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      if (firstError) {
+        promise.set_exception(firstError);
+      } else if (executed.load(std::memory_order_relaxed) != total) {
+        promise.set_exception(std::make_exception_ptr(
+            std::future_error{std::future_errc::broken_promise}));
+      } else {
+        promise.set_value();
+      }
+      delete this;
+    }
+  }
+
+  F callable;
+  const size_t total;
+  std::atomic<size_t> remaining;
+  std::atomic<size_t> executed{0};
+  std::atomic_flag errorTaken = ATOMIC_FLAG_INIT;
+  std::exception_ptr firstError;
+  std::promise<void> promise;
+};
+
+template <class F> class BulkRunner : public Runnable {
+public:
+  BulkRunner(BulkState<F> *state, size_t index)
+      : state_{state}, index_{index} {
+    setAutoDeleted(true);
+  }
+  ~BulkRunner() override { state_->finishOne(); }
+
+  void run() override {
+    try {
+      state_->callable(index_);
+    } catch (...) {
+      if (!state_->errorTaken.test_and_set(std::memory_order_relaxed)) {
+        state_->firstError = std::current_exception();
+      }
+    }
+    state_->executed.fetch_add(1, std::memory_order_relaxed);
+  }
+
+private:
+  BulkState<F> *state_;
+  size_t index_;
+};
+
+} // namespace details
+} // namespace threading
+} // namespace maf
@@ -7,7 +7,7 @@
 namespace maf {
 namespace threading {
 
-enum PoolType { DynamicCount, StableCount, Priority };
+enum PoolType { DynamicCount, StableCount, Priority, WorkStealing };
 
 class ThreadPoolFactory {
 public:
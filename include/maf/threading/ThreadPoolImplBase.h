@@ -74,48 +74,49 @@ public:
   }
 
 private:
+  using RunningSlot = typename std::list<Task *>::iterator;
+
   // copt = Called On Pool Threads
-  void coptRun(Task task) {
-    addToRunningTasks(task);
+  void coptRun(RunningSlot slot, TaskRef task) {
+    setRunningTask(slot, &task);
     _fRun(task);
-    removeFromRunningTasks(task);
+    setRunningTask(slot, nullptr);
     _fDone(task);
   }
   void coptRunPendingTask() {
+    auto slot = addRunningSlot();
     Task task;
     while (_taskQueue.wait(task)) {
-      coptRun(task);
+      coptRun(slot, task);
     }
   }
 
   std::vector<std::thread> _pool;
   std::once_flag _shutdowned;
   TaskQueue _taskQueue;
-  std::list<Task> _runningTasks;
+  // One slot per pool thread pointing to the task it is running, so tracking
+  // running tasks neither copies them nor allocates
+  std::list<Task *> _runningTasks;
   std::mutex _runningTaskMutex;
   unsigned int _maxThreadCount;
   TaskExc _fRun;
   TaskExc _fStop;
   TaskExc _fDone;
 
-  void addToRunningTasks(Task task) {
+  RunningSlot addRunningSlot() {
     std::lock_guard<std::mutex> lock(_runningTaskMutex);
-    _runningTasks.push_back(std::move(task));
+    return _runningTasks.insert(_runningTasks.end(), nullptr);
   }
-  void removeFromRunningTasks(const Task &task) {
+  void setRunningTask(RunningSlot slot, Task *task) {
     std::lock_guard<std::mutex> lock(_runningTaskMutex);
-    for (auto iTask = _runningTasks.begin(); iTask != _runningTasks.end();
-         ++iTask) {
-      if (*iTask == task) {
-        _runningTasks.erase(iTask);
-        break;
-      }
-    }
+    *slot = task;
   }
   void stopRunningTasks() {
     std::lock_guard<std::mutex> lock(_runningTaskMutex);
-    for (auto &task : _runningTasks) {
-      _fStop(task);
+    for (auto task : _runningTasks) {
+      if (task) {
+        _fStop(*task);
+      }
     }
   }
 
@@ -84,7 +84,7 @@ class ThreadSafeQueue {
   bool tryPop(value_type &value) {
     std::lock_guard lock(queue_);
     if (!queue_->empty() && !isClosed()) {
-      value = queue_->front();
+      value = std::move(queue_->front());
       queue_->pop();
       return true;
     }
@@ -1,11 +1,19 @@
 #pragma once
 
+#include <memory>
 #include <string>
+#include <string_view>
 
 namespace maf {
 namespace srz {
 
 using Buffer = std::string;
 
+//! Bytes stored elsewhere, e.g. in a mapped file, kept alive by owner
+struct SharedBytes {
+  std::shared_ptr<const void> owner;
+  std::string_view bytes;
+};
+
 } // namespace srz
 } // namespace maf
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <maf/utils/cppextension/TupleDiff.h>
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "OByteStream.h"
+#include "Serializer.h"
+#include "Tuplizable.h"
+
+namespace maf {
+namespace srz {
+
+//! Bit i stands for field i of a tuplizable object
+template <class Object>
+using FieldBits = std::bitset<std::tuple_size_v<
+    decltype(std::declval<const Object &>().as_tuple())>>;
+
+template <class Object>
+FieldBits<Object> changedFields(const Object &before, const Object &after) {
+  auto beforeFields = before.as_tuple();
+  auto afterFields = after.as_tuple();
+  return util::tuple_diff(beforeFields, afterFields);
+}
+
+namespace internal {
+
+template <class Tuple, class Visit, size_t... Is>
+void forEachField(Tuple &fields, Visit &&visit, std::index_sequence<Is...>) {
+  (visit(std::get<Is>(fields), Is), ...);
+}
+
+template <class Tuple, class Visit>
+void forEachField(Tuple &fields, Visit &&visit) {
+  forEachField(fields, std::forward<Visit>(visit),
+               std::make_index_sequence<std::tuple_size_v<Tuple>>{});
+}
+
+template <size_t N>
+using FieldBitBytes = std::array<char, (N + 7) / 8>;
+
+}  // namespace internal
+
+//! Writes the field count, the bits of the changed fields, then the values
+//! of those fields only
+template <class Object>
+void serializeChanges(OByteStream &os, const Object &object,
+                      const FieldBits<Object> &changed) {
+  constexpr auto FieldCount = FieldBits<Object>{}.size();
+  internal::FieldBitBytes<FieldCount> bits{};
+  for (size_t i = 0; i < FieldCount; ++i) {
+    if (changed[i]) {
+      bits[i / 8] |= static_cast<char>(1 << (i % 8));
+    }
+  }
+  SR sr(os);
+  sr << static_cast<uint32_t>(FieldCount);
+  os.write(bits.data(), bits.size());
+  auto fields = object.as_tuple();
+  internal::forEachField(fields, [&](const auto &field, size_t i) {
+    if (changed[i]) {
+      sr << field;
+    }
+  });
+}
+
+//! Patches object with changes written by serializeChanges. Returns false if
+//! they were written for another layout, throws if they are cut short
+template <class Object, class IStream>
+bool deserializeChanges(IStream &is, Object &object) {
+  constexpr auto FieldCount = FieldBits<Object>{}.size();
+  DSR<IStream> ds(is);
+  uint32_t count = 0;
+  ds >> count;
+  internal::FieldBitBytes<FieldCount> bits{};
+  auto pos = is.readingPos();
+  is.read(bits.data(), bits.size());
+  if (count != FieldCount || is.readingPos() != pos + bits.size()) {
+    return false;
+  }
+  auto fields = object.as_tuple();
+  internal::forEachField(fields, [&](auto &field, size_t i) {
+    if (bits[i / 8] & (1 << (i % 8))) {
+      ds >> field;
+    }
+  });
+  return true;
+}
+
+//! Field index of a tuplizable object as a number, empty if there is no such
+//! field or it is not arithmetic
+template <class Object>
+std::optional<double> numericField(const Object &object, size_t index) {
+  std::optional<double> value;
+  if constexpr (is_tuplizable_type_v<Object>) {
+    auto fields = object.as_tuple();
+    internal::forEachField(fields, [&](const auto &field, size_t i) {
+      using Field = std::decay_t<decltype(field)>;
+      if constexpr (std::is_arithmetic_v<Field> || std::is_enum_v<Field>) {
+        if (i == index) {
+          value = static_cast<double>(field);
+        }
+      }
+    });
+  }
+  return value;
+}
+
+}  // namespace srz
+}  // namespace maf
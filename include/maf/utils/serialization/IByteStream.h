@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstring>
+#include <string_view>
 
 #include "Buffer.h"
 
@@ -84,14 +85,22 @@ class IByteStream : public details::BasicIByteStream<Buffer> {
  private:
 };
 
-class IByteStreamView : public details::BasicIByteStream<const Buffer &> {
-  using Base = BasicIByteStream<const Buffer &>;
+// Reads bytes owned by someone else, a Buffer or any mapped memory
+class IByteStreamView : public details::BasicIByteStream<std::string_view> {
+  using Base = BasicIByteStream<std::string_view>;
 
  public:
   using Base::BasicIByteStream;
   IByteStreamView(const IByteStream &ibs)
-      : BasicIByteStream<const Buffer &>(ibs.buffer(), ibs.readingPos(),
-                                         ibs.state()) {}
+      : Base(ibs.buffer(), ibs.readingPos(), ibs.state()) {}
+  IByteStreamView(const IByteStreamView &other)
+      : Base(other.buffer_, other.readingPos_, other.state_) {}
+  IByteStreamView &operator=(const IByteStreamView &other) {
+    buffer_ = other.buffer_;
+    readingPos_ = other.readingPos_;
+    state_ = other.state_;
+    return *this;
+  }
 };
 
 }  // namespace srz
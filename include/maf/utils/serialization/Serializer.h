@@ -51,7 +51,7 @@ template <class OStream, typename T>
 void serialize(OStream &, const T &);
 
 template <class IStream, typename T>
-T deserialize(IStream &, bool &);
+bool deserialize(IStream &, T &);
 
 namespace internal {
 
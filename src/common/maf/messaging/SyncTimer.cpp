@@ -2,29 +2,64 @@
 #include <maf/messaging/SyncTimer.h>
 #include <maf/utils/ExecutorIF.h>
 
-#include <atomic>
-#include <cassert>
-#include <condition_variable>
 #include <mutex>
 
+#include "TimerManager.h"
+
 namespace maf {
 
 namespace messaging {
 
+using ExecutorIFPtr = util::ExecutorIFPtr;
+using TimeOutCallback = SyncTimer::TimeOutCallback;
+
+static std::shared_ptr<TimerManager> timerEngine() {
+  static auto engine = std::make_shared<TimerManager>();
+  return engine;
+}
+
 struct SyncTimerDataPrv {
-  std::condition_variable_any timeoutCondition;
-  std::recursive_mutex mutex;
-  bool running = false;
+  // Keeps the shared timer thread alive as long as any SyncTimer exists
+  std::shared_ptr<TimerManager> engine = timerEngine();
+  std::mutex mutex;
+  TimerManager::JobID jid = TimerManager::invalidJobID();
+  std::chrono::milliseconds interval{0};
+  TimeOutCallback callback;
+  ExecutorIFPtr executor;
   bool cyclic = false;
+
+  SyncTimerDataPrv(bool cc) : cyclic(cc) {}
+
+  bool running() const {
+    return TimerManager::isValid(jid) && engine->isRunning(jid);
+  }
+
+  void launch() {
+    jid = engine->start(
+        interval.count(),
+        [callback = callback, executor = executor] {
+          if (executor) {
+            executor->execute(callback);
+          } else {
+            callback();
+          }
+        },
+        cyclic);
+  }
+
+  void cancel() {
+    if (running()) {
+      engine->stop(jid);
+    }
+    jid = TimerManager::invalidJobID();
+  }
 };
 
 SyncTimer::SyncTimer(bool cyclic)
-    : d_{new SyncTimerDataPrv{{}, {}, false, cyclic}} {}
+    : d_{std::make_shared<SyncTimerDataPrv>(cyclic)} {}
+
+SyncTimer::~SyncTimer() { stop(); }
 
-SyncTimer::~SyncTimer() {
-  stop();
-  delete d_;
-}
 void SyncTimer::start(long long milliseconds, TimeOutCallback callback,
                       ExecutorIFPtr executor) {
   start(std::chrono::milliseconds{milliseconds}, std::move(callback),
@@ -36,50 +71,44 @@ void SyncTimer::start(std::chrono::milliseconds milliseconds,
   if (!callback) {
     MAF_LOGGER_ERROR("[TimerImpl]: Please specify not null callback");
   } else {
-    if (running()) {
+    std::lock_guard lock(d_->mutex);
+    if (d_->running()) {
       MAF_LOGGER_INFO("TimerImpl is still running, then stop!");
-      stop();
+      d_->cancel();
     }
 
-    std::unique_lock lock(d_->mutex);
-    d_->running = true;
-
-    do {
-      if (!d_->timeoutCondition.wait_for(lock, milliseconds,
-                                         [this] { return !d_->running; })) {
-        if (executor) {
-          executor->execute(d_->cyclic ? callback : std::move(callback));
-        } else {
-          callback();
-        }
-      }
-
-      if (!d_->running)  // restarted
-      {
-        break;
-      }
-
-    } while (d_->cyclic);
-
-    d_->running = false;
+    d_->interval = milliseconds;
+    d_->callback = std::move(callback);
+    d_->executor = std::move(executor);
+    d_->launch();
   }
 }
 
-void SyncTimer::restart() { d_->timeoutCondition.notify_one(); }
+void SyncTimer::restart() {
+  std::lock_guard lock(d_->mutex);
+  if (d_->running()) {
+    d_->engine->restart(d_->jid);
+  } else if (d_->callback) {
+    d_->launch();
+  }
+}
 
 void SyncTimer::stop() {
   std::lock_guard lock(d_->mutex);
-  if (d_->running) {
-    d_->running = false;
-    d_->timeoutCondition.notify_one();
-  }
+  d_->cancel();
 }
 
-bool SyncTimer::running() { return d_->running; }
+bool SyncTimer::running() {
+  std::lock_guard lock(d_->mutex);
+  return d_->running();
+}
 
 void SyncTimer::setCyclic(bool cyclic) {
   std::lock_guard lock(d_->mutex);
   d_->cyclic = cyclic;
+  if (TimerManager::isValid(d_->jid)) {
+    d_->engine->setCyclic(d_->jid, cyclic);
+  }
 }
 
 }  // namespace messaging
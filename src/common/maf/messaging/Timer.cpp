@@ -4,6 +4,7 @@
 #include <maf/utils/CallOnExit.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <memory>
 #include <thread>
@@ -32,6 +33,7 @@ struct TimerData {
   TimeOutCallback callback;
   DeadLine deadline = Clock::now();
   ExecutionTimeout duration;
+  ExecutionTimeout slack = ExecutionTimeout::zero();
   bool cyclic = false;
   bool running = false;
 
@@ -47,6 +49,7 @@ struct TimerData {
     deadline = Clock::now() + duration;
   }
   bool expired() const { return deadline <= Clock::now(); }
+  DeadLine latestDeadline() const { return deadline + slack; }
   void onExpired() { callback(); }
   void reset(TimeOutCallback&& cb, ExecutionTimeout d, bool cc = false) {
     callback = move(cb);
@@ -65,10 +68,12 @@ struct TimerMgr {
   enum class State : char { NoTimer, HaveTimer, Waiting };
   Heap records_;
   State state_;
+  bool coalesced_ = false;
 
   void cleanup();
   void refresh();
   void checkAllTimers();
+  DeadLine nextWakeupTime() const;
   void start(TimerDataPtr record);
   void stop(TimerDataPtr record);
   void onTimerModified();
@@ -88,6 +93,8 @@ struct TimerMgr {
   decltype(auto) end() const { return std::end(records_); }
 };
 
+static std::atomic<unsigned long long> savedWakeups_{0};
+
 static TimerMgr& mgr() {
   static thread_local TimerMgr _;
   return _;
@@ -135,6 +142,16 @@ void Timer::stop(const ComponentInstance& comp) {
 
 bool Timer::running() const { return d_->running; }
 
+void Timer::setSlack(milliseconds slack) { d_->slack = slack; }
+
+milliseconds Timer::slack() const {
+  return duration_cast<milliseconds>(d_->slack);
+}
+
+unsigned long long Timer::savedWakeupCount() {
+  return savedWakeups_.load(std::memory_order_relaxed);
+}
+
 void Timer::setCyclic(bool cyclic) {
   if (cyclic != d_->cyclic) {
     d_->cyclic = cyclic;
@@ -177,10 +194,15 @@ void TimerMgr::checkAllTimers() {
     return;
   }
   auto comp = this_component::instance();
+  auto coalesced = coalesced_;
+  auto lastExpiredDeadline = DeadLine::min();
+  coalesced_ = false;
   while (auto timer = getShortestTimer()) {
     if (!timer->expired()) {
+      auto wakeupTime = nextWakeupTime();
+      coalesced_ = wakeupTime != timer->deadline;
       state_ = State::Waiting;
-      comp->runOnceUntil(timer->deadline);
+      comp->runOnceUntil(wakeupTime);
       state_ = State::HaveTimer;
       comp->execute([this] { checkAllTimers(); });
       break;
@@ -193,11 +215,39 @@ void TimerMgr::checkAllTimers() {
     state_ = State::HaveTimer;
     // shortest timer might be stopped while waiting
     if (timer->running) {
+      if (coalesced && lastExpiredDeadline != DeadLine::min() &&
+          timer->deadline > lastExpiredDeadline) {
+        // this expiration would have needed its own wakeup without slack
+        savedWakeups_.fetch_add(1, std::memory_order_relaxed);
+      }
+      lastExpiredDeadline = timer->deadline;
       onShortestTimerExpired(timer);
     }
   }
 }
 
+DeadLine TimerMgr::nextWakeupTime() const {
+  // Each timer may expire anywhere in [deadline, deadline + slack], waking up
+  // at the earliest window end lets every timer whose deadline has come by
+  // then share that single wakeup.
+  auto wakeupTime = records_.front()->latestDeadline();
+  if (wakeupTime == records_.front()->deadline) {
+    return wakeupTime;
+  }
+
+  // records_ is a min-heap on deadline, the subtree of a timer whose deadline
+  // is not earlier than current wakeupTime cannot lower it anymore
+  auto visit = [this, &wakeupTime](size_t i, auto& self) -> void {
+    if (i < records_.size() && records_[i]->deadline < wakeupTime) {
+      wakeupTime = std::min(wakeupTime, records_[i]->latestDeadline());
+      self(2 * i + 1, self);
+      self(2 * i + 2, self);
+    }
+  };
+  visit(0, visit);
+  return wakeupTime;
+}
+
 void TimerMgr::start(TimerDataPtr record) {
   if (!record->running) {
     record->running = true;
@@ -2,90 +2,12 @@
 #include <algorithm>
 #include <maf/logging/Logger.h>
 
-using namespace std::chrono;
-
 namespace maf {
 
 namespace messaging {
 
-static bool test(const std::atomic_bool &flag) {
-  return flag.load(std::memory_order_acquire);
-}
-
-static void set(std::atomic_bool &flag, bool value) {
-  return flag.store(value, std::memory_order_release);
-}
-
-template <typename Lockable> class ConcurrentMutex {
-  Lockable &l1;
-  Lockable &l2_;
-
-public:
-  ConcurrentMutex(Lockable &l1, Lockable &l2) : l1(l1), l2_(l2) {}
-  void lock() { return std::lock(l1, l2_); }
-  void unlock() {
-    l1.unlock();
-    l2_.unlock();
-  }
-};
-
-struct JobDesc {
-  using JobID = TimerManagerImpl::JobID;
-  using Duration = TimerManagerImpl::Duration;
-  using TimeOutCallback = TimerManagerImpl::TimeOutCallback;
-
-  JobDesc(JobID id_, Duration duration_, TimeOutCallback callback_,
-          bool isCyclic_ = false) {
-    *d_ = D{id_, duration_, std::move(callback_), isCyclic_};
-  }
-  Duration remainTime() {
-    std::lock_guard lock(d_);
-    return d_->duration - elapseTime();
-  }
-
-  void reset() { d_.atomic()->startTime = system_clock::now(); }
-  bool expired() {
-    std::lock_guard lock(d_);
-    return elapseTime() >= d_->duration;
-  }
-  void invalidate() { d_.atomic()->callback = {}; }
-  bool valid() const { return bool(d_.atomic()->callback); }
-  Duration duration() const { return d_.atomic()->duration; }
-  JobID id() const { return d_->id; }
-  bool isCyclic() const { return d_.atomic()->isCyclic; }
-  void setCyclic(bool value) { d_.atomic()->isCyclic = value; }
-  TimeOutCallback callback() { return d_.atomic()->callback; }
-
-private:
-  Duration elapseTime() {
-    return duration_cast<milliseconds>(system_clock::now() - d_->startTime)
-        .count();
-  }
-  struct D {
-    D() = default;
-    D(JobID id_, Duration duration_, TimeOutCallback callback_,
-      bool isCyclic_ = false)
-        : id(id_), startTime(system_clock::now()), duration(duration_),
-          callback(callback_), isCyclic(isCyclic_) {}
-
-    JobID id;
-    system_clock::time_point startTime;
-    Duration duration;
-    TimeOutCallback callback;
-    bool isCyclic;
-  };
-
-  threading::Lockable<D> d_;
-};
-
-struct JobComp {
-  bool operator()(const TimerManagerImpl::JobDescRef &lhs,
-                  const TimerManagerImpl::JobDescRef &rhs) {
-    return lhs->remainTime() > rhs->remainTime();
-  }
-};
-
 TimerManagerImpl::~TimerManagerImpl() {
+  stop();
   if (thread_.joinable()) {
     thread_.join();
   }
@@ -93,169 +15,142 @@ TimerManagerImpl::~TimerManagerImpl() {
 
 bool TimerManagerImpl::start(JobID jid, Duration ms, TimeOutCallback callback,
                              bool cyclic) {
-  bool success = true;
-
-  if (!test(workerThreadIsRunning_)) {
-    startImmediately(jid, ms, callback, cyclic);
-  } else {
-    if (jobsCount() < MAX_JOBS_COUNT) {
-      storePendingJob(jid, ms, callback, cyclic);
-      condvar_.notify_one();
-    } else {
-      MAF_LOGGER_WARN("Cannot start timer for job ", jid,
-                      " Due to number of jobs exceeds the permited amount(",
-                      MAX_JOBS_COUNT, "), please try with other BusyTimer");
-      success = false;
-    }
-  }
-
-  if (success && test(shutdowned_)) {
-    set(shutdowned_, false);
-    run();
+  {
+    std::lock_guard lock(jmt_);
+    launchWorkerThreadIfNotYet__();
+    auto &job = jobs_[jid];
+    job.duration = ms;
+    job.callback = std::make_shared<TimeOutCallback>(std::move(callback));
+    job.cyclic = cyclic;
+    job.deadline = Clock::now() + std::chrono::milliseconds{ms};
+    schedule__(jid, job);
   }
-  return success;
+  condvar_.notify_one();
+  return true;
 }
 
 void TimerManagerImpl::restart(TimerManagerImpl::JobID jid) {
-  if (!test(shutdowned_)) {
-    std::unique_lock<JobsContainer> jobslock(runningJobs_);
-    auto itJob = findJob__(runningJobs_, jid);
-    if (itJob != runningJobs_->end()) {
-      MAF_LOGGER_INFO("Timer ", jid,
-                      " is restarted with duration = ", (*itJob)->duration());
-
-      (*itJob)->reset();
-      jobslock.unlock();
-      condvar_.notify_one();
-    }
+  std::unique_lock lock(jmt_);
+  if (auto itJob = jobs_.find(jid); itJob != jobs_.end()) {
+    auto &job = itJob->second;
+    MAF_LOGGER_INFO("Timer ", jid, " is restarted with duration = ",
+                    job.duration);
+    job.deadline = Clock::now() + std::chrono::milliseconds{job.duration};
+    schedule__(jid, job);
+    compactSchedules__();
+    lock.unlock();
+    condvar_.notify_one();
   }
 }
 
 void TimerManagerImpl::stop(TimerManagerImpl::JobID jid) {
-  if (!test(shutdowned_)) {
-    if (removeAndInvalidateJob(pendingJobs_, jid)) {
-      MAF_LOGGER_INFO("Job ", jid, " is canceled");
-    } else if (removeAndInvalidateJob(runningJobs_, jid)) {
-      MAF_LOGGER_INFO("Job ", jid, " is canceled");
-      condvar_.notify_one();
-    } else {
-      MAF_LOGGER_WARN("Job ", jid, " does not exist or is already canceled");
-    }
+  std::lock_guard lock(jmt_);
+  if (jobs_.erase(jid) != 0) {
+    MAF_LOGGER_INFO("Job ", jid, " is canceled");
+    compactSchedules__();
+  } else {
+    MAF_LOGGER_WARN("Job ", jid, " does not exist or is already canceled");
   }
 }
 
 bool TimerManagerImpl::isRunning(TimerManagerImpl::JobID jid) {
-  bool running = false;
-  if (!test(shutdowned_)) {
-    auto jobFoundOn = [&jid](const JobsContainer &jobs) -> bool {
-      std::lock_guard lock(jobs);
-      for (auto &job : *jobs) {
-        if (job->id() == jid) {
-          return true;
-        }
-      }
-      return false;
-    };
-
-    running = (jobFoundOn(pendingJobs_) || jobFoundOn(runningJobs_));
-  }
-
-  return running;
+  std::lock_guard lock(jmt_);
+  return jobs_.count(jid) != 0;
 }
 
 void TimerManagerImpl::setCyclic(TimerManagerImpl::JobID jid, bool cyclic) {
-  if (!test(shutdowned_)) {
-    auto setCyclic = [](JobsContainer &jobs, JobID jid, bool value) -> bool {
-      std::lock_guard lock(jobs);
-      auto itJob = findJob__(jobs, jid);
-      if (itJob != jobs->end()) {
-        (*itJob)->setCyclic(value);
-      }
-      return itJob != jobs->end();
-    };
-
-    if (!setCyclic(pendingJobs_, jid, cyclic)) {
-      setCyclic(runningJobs_, jid, cyclic);
-    }
+  std::lock_guard lock(jmt_);
+  if (auto itJob = jobs_.find(jid); itJob != jobs_.end()) {
+    itJob->second.cyclic = cyclic;
   }
 }
 
 void TimerManagerImpl::stop() {
-  set(shutdowned_, true);
+  {
+    std::lock_guard lock(jmt_);
+    shutdowned_ = true;
+    jobs_.clear();
+    schedules_.clear();
+  }
   condvar_.notify_one();
+  if (thread_.joinable() && thread_.get_id() != std::this_thread::get_id()) {
+    thread_.join();
+  }
 }
 
-size_t TimerManagerImpl::jobsCount() {
-  std::scoped_lock lock(pendingJobs_, runningJobs_);
-  return pendingJobs_->size() + runningJobs_->size();
+void TimerManagerImpl::launchWorkerThreadIfNotYet__() {
+  if (!thread_.joinable()) {
+    shutdowned_ = false;
+    thread_ = std::thread{&TimerManagerImpl::run, this};
+  }
 }
 
-void TimerManagerImpl::startImmediately(JobID jid, Duration ms,
-                                        TimeOutCallback callback,
-                                        bool cyclic) noexcept {
-  addOrReplace(runningJobs_,
-               std::make_shared<JobDesc>(jid, ms, callback, cyclic));
+void TimerManagerImpl::schedule__(JobID jid, JobDesc &job) {
+  job.generation = ++generationCounter_;
+  schedules_.push_back({job.deadline, jid, job.generation});
+  std::push_heap(schedules_.begin(), schedules_.end(), scheduleGreater);
 }
 
-void TimerManagerImpl::reorderRunningJobs__() noexcept {
-  std::make_heap(runningJobs_->begin(), runningJobs_->end(), JobComp());
+bool TimerManagerImpl::isStale__(const Schedule &s) const {
+  auto itJob = jobs_.find(s.jid);
+  return itJob == jobs_.end() || itJob->second.generation != s.generation;
 }
 
-void TimerManagerImpl::adoptPendingJobs__() noexcept {
-  if (!pendingJobs_->empty()) {
-    for (auto &job : *pendingJobs_) {
-      addOrReplace(runningJobs_, std::move(job), false);
-    }
-    pendingJobs_->clear();
+void TimerManagerImpl::compactSchedules__() {
+  // Frequently restarted or stopped jobs leave stale entries behind, drop them
+  // once they outnumber the live ones
+  if (schedules_.size() > 2 * jobs_.size() + 64) {
+    schedules_.erase(std::remove_if(schedules_.begin(), schedules_.end(),
+                                    [this](const Schedule &s) {
+                                      return isStale__(s);
+                                    }),
+                     schedules_.end());
+    std::make_heap(schedules_.begin(), schedules_.end(), scheduleGreater);
   }
 }
 
-void TimerManagerImpl::storePendingJob(JobID jid, Duration ms,
-                                       TimeOutCallback callback,
-                                       bool cyclic) noexcept {
-  storePendingJob(std::make_shared<JobDesc>(jid, ms, callback, cyclic));
-}
-
-void TimerManagerImpl::storePendingJob(JobDescRef job) noexcept {
-  addOrReplace(pendingJobs_, std::move(job));
-}
-
-TimerManagerImpl::JobDescRef
-TimerManagerImpl::removeAndInvalidateJob(JobsContainer &jobs, JobID jid) {
-  JobDescRef job;
-  std::lock_guard lock(jobs);
-  for (auto &j : *jobs) {
-    if (j->id() == jid) {
-      job = std::move(j);
-      job->invalidate();
+void TimerManagerImpl::run() noexcept {
+  MAF_LOGGER_INFO("TimerManager thread is running!");
+  std::unique_lock lock(jmt_);
+  while (!shutdowned_) {
+    if (schedules_.empty()) {
+      condvar_.wait(lock,
+                    [this] { return !schedules_.empty() || shutdowned_; });
+      continue;
+    }
 
-      std::swap(j, jobs->back());
-      jobs->pop_back();
+    auto next = schedules_.front();
+    if (isStale__(next)) {
+      std::pop_heap(schedules_.begin(), schedules_.end(), scheduleGreater);
+      schedules_.pop_back();
+      continue;
+    }
 
-      break;
+    if (next.deadline > Clock::now()) {
+      condvar_.wait_until(lock, next.deadline);
+      continue;
     }
-  }
-  return job;
-}
 
-TimerManagerImpl::JobsIterator TimerManagerImpl::findJob__(JobsContainer &jobs,
-                                                           JobID jid) {
-  for (auto itJob = jobs->begin(); itJob != jobs->end(); ++itJob) {
-    if ((*itJob)->id() == jid) {
-      return itJob;
+    std::pop_heap(schedules_.begin(), schedules_.end(), scheduleGreater);
+    schedules_.pop_back();
+
+    auto itJob = jobs_.find(next.jid);
+    auto &job = itJob->second;
+    auto cyclic = job.cyclic;
+    auto callback = job.callback;
+    if (cyclic) {
+      // keep the cadence, but don't try catching up missed periods
+      job.deadline = std::max(job.deadline + std::chrono::milliseconds{
+                                                 job.duration},
+                              Clock::now());
+      schedule__(next.jid, job);
+    } else {
+      jobs_.erase(itJob);
     }
-  }
-  return jobs->end();
-}
 
-bool TimerManagerImpl::runJobIfExpired__(TimerManagerImpl::JobDescRef job) {
-  bool executed = false;
-  if (job->expired()) {
+    lock.unlock();
     try {
-      // for case of job has been stopped when waiting to be expired
-      if (job->valid()) {
-        this->doJob__(job);
-      }
+      (*callback)(next.jid, cyclic);
     } catch (const std::exception &e) {
       MAF_LOGGER_INFO("Catch exception when executing job's callback: ",
                       e.what());
@@ -263,117 +158,7 @@ bool TimerManagerImpl::runJobIfExpired__(TimerManagerImpl::JobDescRef job) {
       MAF_LOGGER_INFO(
           "Uncaught exception occurred when executing job's callback");
     }
-    executed = true;
-  }
-  return executed;
-}
-
-void TimerManagerImpl::run() noexcept {
-  thread_ = std::thread([this] {
-    set(workerThreadIsRunning_, true);
-    MAF_LOGGER_INFO("TimerManager thread is running!");
-    do {
-      ConcurrentMutex<JobsContainer> ccMutex(pendingJobs_, runningJobs_);
-      std::unique_lock<decltype(ccMutex)> jobsLock(ccMutex);
-
-      this->reorderRunningJobs__();
-      auto job = getShorttestDurationJob__(runningJobs_);
-
-      if (job) {
-        if (runJobIfExpired__(job)) {
-          this->scheduleShorttestJob__();
-        } else {
-          if (test(shutdowned_)) {
-            break;
-          }
-          // TBD: _shutdowned might be set here
-          condvar_.wait_for(jobsLock, milliseconds(job->remainTime()));
-
-          if (test(shutdowned_)) {
-            break;
-          }
-
-          if (runJobIfExpired__(job)) {
-            this->scheduleShorttestJob__();
-          }
-        }
-      } else // there's no job to do
-      {
-        condvar_.wait(ccMutex, [this] {
-          return (this->pendingJobs_->size() > 0) ||
-                 (test(shutdowned_) == true);
-        });
-      }
-
-      this->adoptPendingJobs__();
-
-    } while (!test(shutdowned_));
-    this->cleanup();
-  });
-}
-
-TimerManagerImpl::JobDescRef TimerManagerImpl::getShorttestDurationJob__(
-    const JobsContainer &jobs) noexcept {
-  if (jobs->empty()) {
-    return nullptr;
-  } else {
-    return jobs->front();
-  }
-}
-
-void TimerManagerImpl::doJob__(TimerManagerImpl::JobDescRef job) {
-  job->callback()(job->id(), job->isCyclic());
-}
-
-TimerManagerImpl::JobDescRef
-TimerManagerImpl::scheduleShorttestJob__() noexcept {
-  JobDescRef job;
-  if (!runningJobs_->empty()) {
-    std::pop_heap(runningJobs_->begin(), runningJobs_->end(), JobComp());
-
-    if (runningJobs_->back()->isCyclic()) {
-      runningJobs_->back()->reset();
-      job = runningJobs_->back();
-      std::push_heap(runningJobs_->begin(), runningJobs_->end());
-    } else // Remove job when it expired
-    {
-      job = std::move(runningJobs_->back());
-      runningJobs_->pop_back();
-    }
-  }
-  return job;
-}
-
-void TimerManagerImpl::cleanup() {
-
-  std::scoped_lock(pendingJobs_, runningJobs_);
-  set(workerThreadIsRunning_, false);
-  if (test(shutdowned_)) {
-    pendingJobs_->clear();
-    runningJobs_->clear();
-  } else {
-    // due to the worker thread is no longer running, then _shutdowned flag must
-    // be set to launch new worker thread later if client code invoke start
-    // function again
-    set(shutdowned_, true);
-  }
-}
-
-void TimerManagerImpl::addOrReplace(TimerManagerImpl::JobsContainer &jobs,
-                                    TimerManagerImpl::JobDescRef newJob,
-                                    bool sync) {
-  if (newJob) {
-    std::unique_ptr<std::lock_guard<JobsContainer>> lock;
-    if (sync) {
-      lock = std::make_unique<std::lock_guard<JobsContainer>>(jobs);
-    }
-
-    auto itJob = findJob__(jobs, newJob->id());
-    if (itJob != jobs->end()) {
-      *itJob = std::move(newJob);
-    } else {
-      jobs->emplace_back(std::move(newJob));
-    }
+    lock.lock();
   }
 }
 
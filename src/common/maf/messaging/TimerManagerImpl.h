@@ -1,25 +1,23 @@
 #pragma once
 
 #include "TimerManager.h"
-#include <atomic>
 #include <chrono>
 #include <condition_variable>
-#include <maf/threading/Lockable.h>
 #include <memory>
+#include <mutex>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 namespace maf {
 namespace messaging {
 
-struct JobDesc;
 struct TimerManagerImpl {
   using JobID = TimerManager::JobID;
   using Duration = TimerManager::Duration;
   using TimeOutCallback = std::function<void(JobID, bool)>;
-  static constexpr size_t MAX_JOBS_COUNT = 1000;
 
-  TimerManagerImpl() : shutdowned_(true), workerThreadIsRunning_(false) {}
+  TimerManagerImpl() = default;
   ~TimerManagerImpl();
   bool start(JobID jid, Duration ms, TimeOutCallback callback, bool cyclic);
   void restart(JobID jid);
@@ -29,45 +27,42 @@ struct TimerManagerImpl {
   void stop();
 
 private:
-  using JobDescRef = std::shared_ptr<JobDesc>;
-  using JobsContainer = threading::Lockable<std::vector<JobDescRef>>;
-  using JobsIterator = JobsContainer::DataType::iterator;
-  using JobsCIterator = JobsContainer::DataType::const_iterator;
-  friend struct JobComp;
-  friend struct JobDesc;
+  using Clock = std::chrono::steady_clock;
+  using Generation = unsigned long long;
 
-  size_t jobsCount();
-  void run() noexcept;
-  void startImmediately(JobID jid, Duration ms, TimeOutCallback callback,
-                        bool cyclic) noexcept;
+  struct JobDesc {
+    Duration duration;
+    std::shared_ptr<TimeOutCallback> callback;
+    Clock::time_point deadline;
+    Generation generation;
+    bool cyclic;
+  };
 
-  void storePendingJob(JobID jid, Duration ms, TimeOutCallback callback,
-                       bool cyclic) noexcept;
+  // Entries are never removed from the middle of the heap, a stopped or
+  // restarted job just leaves an entry whose generation no longer matches
+  struct Schedule {
+    Clock::time_point deadline;
+    JobID jid;
+    Generation generation;
+  };
 
-  void storePendingJob(JobDescRef job) noexcept;
-  void doJob__(JobDescRef job);
-  void adoptPendingJobs__() noexcept;
-  static JobDescRef
-  getShorttestDurationJob__(const JobsContainer &jobs) noexcept;
-  void reorderRunningJobs__() noexcept;
-  JobDescRef scheduleShorttestJob__() noexcept;
-  bool runJobIfExpired__(JobDescRef job);
-  void cleanup();
+  static bool scheduleGreater(const Schedule &s1, const Schedule &s2) {
+    return s1.deadline > s2.deadline;
+  }
 
-  static std::lock_guard<JobsContainer> autolock(JobsContainer &jobs,
-                                                 bool sync = true);
-  static void addOrReplace(JobsContainer &jobs, JobDescRef newJob,
-                           bool sync = true);
-  static JobDescRef removeAndInvalidateJob(JobsContainer &jobs, JobID jid);
-  static JobsIterator findJob__(JobsContainer &jobs, JobID jid);
+  void run() noexcept;
+  void schedule__(JobID jid, JobDesc &job);
+  bool isStale__(const Schedule &s) const;
+  void compactSchedules__();
+  void launchWorkerThreadIfNotYet__();
 
+  std::unordered_map<JobID, JobDesc> jobs_;
+  std::vector<Schedule> schedules_;
+  Generation generationCounter_ = 0;
   std::thread thread_;
-  JobsContainer runningJobs_;
-  JobsContainer pendingJobs_;
   std::mutex jmt_;
-  std::condition_variable_any condvar_;
-  std::atomic_bool shutdowned_;
-  std::atomic_bool workerThreadIsRunning_;
+  std::condition_variable condvar_;
+  bool shutdowned_ = false;
 };
 } // namespace messaging
 } // namespace maf
@@ -47,5 +47,13 @@ void CSMessage::setPayload(CSPayloadIFPtr content) {
   payload_ = std::move(content);
 }
 
+const SubscriptionFilters &CSMessage::subscriptionFilters() const {
+  return subscriptionFilters_;
+}
+
+void CSMessage::setSubscriptionFilters(SubscriptionFilters filters) {
+  subscriptionFilters_ = std::move(filters);
+}
+
 } // namespace messaging
 } // namespace maf
@@ -2,16 +2,16 @@
 #include <maf/messaging/client-server/CSMgmt.h>
 
 #include "ClientFactory.h"
-#include "SingleThreadPool.h"
 #include "ServerFactory.h"
+#include "ShardedThreadPool.h"
 
 namespace maf {
 namespace messaging {
 namespace csmgmt {
 
 struct CSInit {
-  CSInit() { single_threadpool::init(); }
-  ~CSInit() { single_threadpool::deinit(); }
+  CSInit() { sharded_threadpool::init(); }
+  ~CSInit() { sharded_threadpool::deinit(); }
 };
 
 static void csinit() { static CSInit _; }
@@ -44,6 +44,14 @@ ServiceProviderIFPtr getServiceProvider(const ConnectionType &conntype,
   return {};
 }
 
+bool setDispatcherThreadCount(size_t count) noexcept {
+  return sharded_threadpool::setThreadCount(count);
+}
+
+size_t dispatcherThreadCount() noexcept {
+  return sharded_threadpool::threadCount();
+}
+
 }  // namespace csmgmt
 }  // namespace messaging
 }  // namespace maf
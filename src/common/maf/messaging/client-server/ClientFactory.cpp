@@ -2,10 +2,13 @@
 
 #include <maf/logging/Logger.h>
 #include <maf/messaging/client-server/ipc/local/ConnectionType.h>
+#include <maf/messaging/client-server/ipc/local_shm/ConnectionType.h>
 #include <maf/messaging/client-server/itc/ConnectionType.h>
 #include <maf/utils/containers/Map2D.h>
 
 #include "ipc/LocalIPCClient.h"
+#include "ipc/ShmBufferReceiver.h"
+#include "ipc/ShmBufferSender.h"
 #include "itc/Client.h"
 
 namespace maf {
@@ -35,6 +38,10 @@ class ClientFactoryImpl {
       return itc::Client::instance();
     } else if (connectionType == ipc::local::connection_type) {
       return std::make_shared<ipc::local::LocalIPCClient>();
+    } else if (connectionType == ipc::local_shm::connection_type) {
+      return std::make_shared<ipc::local::LocalIPCClient>(
+          std::make_unique<ipc::local::ShmBufferSender>(),
+          std::make_unique<ipc::local::ShmBufferReceiver>());
     } else {
       MAF_LOGGER_ERROR("Request creating with non-exist connection type [",
                        connectionType, "]");
@@ -0,0 +1,68 @@
+#include "DirectRequest.h"
+
+#include <maf/logging/Logger.h>
+
+namespace maf {
+namespace messaging {
+
+DirectRequest::DirectRequest(OpID opID, RequestID requestID,
+                             CSPayloadIFPtr input,
+                             CSPayloadProcessCallback onResponse)
+    : opID_{std::move(opID)},
+      requestID_{requestID},
+      input_{std::move(input)},
+      onResponse_{std::move(onResponse)} {}
+
+bool DirectRequest::valid() const {
+  std::lock_guard lock(mutex_);
+  return valid_;
+}
+
+ActionCallStatus DirectRequest::respond(const CSPayloadIFPtr &answer) {
+  CSPayloadProcessCallback onResponse;
+  {
+    std::lock_guard lock(mutex_);
+    if (!valid_) {
+      MAF_LOGGER_ERROR("Request is no longer valid, might be the operation id [",
+                       opID_, "]");
+      return ActionCallStatus::InvalidCall;
+    }
+    valid_ = false;
+    onResponse = std::move(onResponse_);
+  }
+  if (onResponse) {
+    onResponse(answer);
+  }
+  return ActionCallStatus::Success;
+}
+
+void DirectRequest::onAborted(AbortRequestCallback abortCallback) {
+  std::unique_lock lock(mutex_);
+  if (!valid_) {
+    lock.unlock();
+    abortCallback();
+  } else {
+    abortCallback_ = std::move(abortCallback);
+  }
+}
+
+bool DirectRequest::abort() {
+  CSPayloadProcessCallback onResponse;
+  AbortRequestCallback abortCallback;
+  {
+    std::lock_guard lock(mutex_);
+    if (!valid_) {
+      return false;
+    }
+    valid_ = false;
+    onResponse = std::move(onResponse_);
+    abortCallback = std::move(abortCallback_);
+  }
+  if (abortCallback) {
+    abortCallback();
+  }
+  return true;
+}
+
+}  // namespace messaging
+}  // namespace maf
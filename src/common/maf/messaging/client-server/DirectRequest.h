@@ -0,0 +1,40 @@
+#pragma once
+
+#include <maf/messaging/client-server/CSShared.h>
+#include <maf/messaging/client-server/RequestIF.h>
+
+#include <mutex>
+
+namespace maf {
+namespace messaging {
+
+// Request from a proxy to a stub of the same process, the response goes
+// straight to the proxy's callback without a message
+class DirectRequest : public RequestIF {
+ public:
+  DirectRequest(OpID opID, RequestID requestID, CSPayloadIFPtr input,
+                CSPayloadProcessCallback onResponse);
+
+  OpCode getOperationCode() const override { return OpCode::Request; }
+  const OpID &getOperationID() const override { return opID_; }
+  RequestID getRequestID() const override { return requestID_; }
+  bool valid() const override;
+  ActionCallStatus respond(const CSPayloadIFPtr &answer) override;
+  CSPayloadIFPtr getInput() override { return input_; }
+  void onAborted(AbortRequestCallback abortCallback) override;
+
+  // The response callback is dropped, the handler's abort callback runs
+  bool abort();
+
+ private:
+  const OpID opID_;
+  const RequestID requestID_;
+  const CSPayloadIFPtr input_;
+  mutable std::mutex mutex_;
+  CSPayloadProcessCallback onResponse_;
+  AbortRequestCallback abortCallback_;
+  bool valid_ = true;
+};
+
+}  // namespace messaging
+}  // namespace maf
@@ -0,0 +1,98 @@
+#include <maf/logging/Logger.h>
+#include <maf/messaging/client-server/CSTypes.h>
+
+#include <deque>
+#include <iomanip>
+#include <shared_mutex>
+#include <sstream>
+#include <unordered_map>
+
+namespace maf {
+namespace messaging {
+
+namespace {
+
+// Names live as long as the process, IDs refer to them
+struct NameTable {
+  std::shared_mutex mutex;
+  std::unordered_map<InternedID::Hash, std::string_view> names;
+  std::deque<std::string> copies;
+
+  NameTable() {
+    for (auto &id : {InternedID{OpIDInvalid}, InternedID{OpID_ServiceAvailable},
+                     InternedID{OpID_ServiceUnavailable}}) {
+      names.emplace(id.hash(), id.name());
+    }
+  }
+
+  // Returns the name kept for hash, empty if the hash is taken by another one
+  std::string_view find(InternedID::Hash hash, std::string_view name,
+                        bool &found) {
+    auto it = names.find(hash);
+    found = it != names.end();
+    if (found && it->second != name) {
+      MAF_LOGGER_ERROR("IDs '", it->second, "' and '", name,
+                       "' have the same hash, they cannot be told apart");
+    }
+    return found ? it->second : std::string_view{};
+  }
+};
+
+NameTable &nameTable() {
+  static NameTable table;
+  return table;
+}
+
+}  // namespace
+
+InternedID::InternedID(std::string_view name) : hash_{hashOf(name)} {
+  auto &table = nameTable();
+  bool found = false;
+  {
+    std::shared_lock lock(table.mutex);
+    name_ = table.find(hash_, name, found);
+  }
+  if (!found) {
+    std::lock_guard lock(table.mutex);
+    if (name_ = table.find(hash_, name, found); !found) {
+      name_ = table.copies.emplace_back(name);
+      table.names.emplace(hash_, name_);
+    }
+  }
+}
+
+InternedID InternedID::fromHash(Hash hash) {
+  auto &table = nameTable();
+  std::shared_lock lock(table.mutex);
+  if (auto it = table.names.find(hash); it != table.names.end()) {
+    return {it->second, hash};
+  }
+  return {std::string_view{}, hash};
+}
+
+bool InternedID::publish(const InternedID &literal) {
+  if (literal.name_.empty()) {
+    return true;
+  }
+  auto &table = nameTable();
+  std::lock_guard lock(table.mutex);
+  auto [it, inserted] = table.names.emplace(literal.hash_, literal.name_);
+  if (!inserted && it->second != literal.name_) {
+    MAF_LOGGER_ERROR("IDs '", it->second, "' and '", literal.name_,
+                     "' have the same hash, they cannot be told apart");
+    return false;
+  }
+  return true;
+}
+
+std::string InternedID::str() const {
+  if (!name_.empty() || empty()) {
+    return std::string{name_};
+  }
+  std::ostringstream oss;
+  oss << '#' << std::hex << std::setw(16) << std::setfill('0') << hash_;
+  return oss.str();
+}
+
+}  // namespace messaging
+}  // namespace maf
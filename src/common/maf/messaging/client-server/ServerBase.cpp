@@ -21,6 +21,11 @@ bool ServerBase::hasServiceProvider(const ServiceID &sid) {
   return providers_.atomic()->count(sid) != 0;
 }
 
+ServiceProviderIFPtr ServerBase::findServiceProvider(const ServiceID &sid) {
+  std::lock_guard lock(providers_);
+  return util::get(*providers_, sid);
+}
+
 bool ServerBase::onIncomingMessage(const CSMessagePtr &csMsg) {
   std::unique_lock lock(providers_);
   if (auto provider = util::get(*providers_, csMsg->serviceID())) {
@@ -14,6 +14,7 @@ class ServerBase : public ServerIF,
  public:
   ServiceProviderIFPtr getServiceProvider(const ServiceID &sid) override;
   bool hasServiceProvider(const ServiceID &sid) override;
+  ServiceProviderIFPtr findServiceProvider(const ServiceID &sid);
   virtual bool init(const Address &serverAddr) override;
   void deinit() override;
 
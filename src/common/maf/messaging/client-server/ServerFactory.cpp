@@ -2,10 +2,13 @@
 
 #include <maf/logging/Logger.h>
 #include <maf/messaging/client-server/ipc/local/ConnectionType.h>
+#include <maf/messaging/client-server/ipc/local_shm/ConnectionType.h>
 #include <maf/messaging/client-server/itc/ConnectionType.h>
 #include <maf/utils/containers/Map2D.h>
 
 #include "ipc/LocalIPCServer.h"
+#include "ipc/ShmBufferReceiver.h"
+#include "ipc/ShmBufferSender.h"
 #include "itc/Server.h"
 
 namespace maf {
@@ -34,6 +37,10 @@ class ServerFactoryImpl {
       return itc::Server::instance();
     } else if (connectionType == ipc::local::connection_type) {
       return std::make_shared<ipc::local::LocalIPCServer>();
+    } else if (connectionType == ipc::local_shm::connection_type) {
+      return std::make_shared<ipc::local::LocalIPCServer>(
+          std::make_unique<ipc::local::ShmBufferSender>(),
+          std::make_unique<ipc::local::ShmBufferReceiver>());
     } else {
       MAF_LOGGER_ERROR("Request creating with non-exist connection type [",
                        connectionType, "]");
@@ -4,13 +4,17 @@
 #include <maf/messaging/client-server/CSError.h>
 #include <maf/messaging/client-server/ServerIF.h>
 
+#include <algorithm>
 #include <cassert>
 
 #include "Request.h"
+#include "ShardedThreadPool.h"
 
 namespace maf {
 namespace messaging {
 
+static constexpr size_t StatusSnapshotInterval = 32;
+
 bool ServiceProvider::onIncomingMessage(const CSMessagePtr &msg) {
   MAF_LOGGER_INFO(
       "ServiceProvider - Received Incoming Message: ",
@@ -50,8 +54,12 @@ bool ServiceProvider::onIncomingMessage(const CSMessagePtr &msg) {
 }
 
 ServiceProvider::ServiceProvider(ServiceID sid, std::weak_ptr<ServerIF> server)
-    : sid_{std::move(sid)}, server_(std::move(server)) {
+    : sid_{std::move(sid)},
+      subscriberIndex_{std::make_shared<const SubscriberIndex>()},
+      server_(std::move(server)) {
   assert(server_.lock() && "Server must not be null");
+  // Clients send the hash only, the name is for the logs
+  InternedID::publish(sid_);
 }
 
 ServiceProvider::~ServiceProvider() {
@@ -70,59 +78,132 @@ ActionCallStatus ServiceProvider::respondToRequest(const CSMessagePtr &csMsg) {
   }
 }
 
+bool ServiceProvider::dispatchRequest(const std::shared_ptr<RequestIF> &request) {
+  if (auto handler = getRequestHandlerCallback(request->getOperationID())) {
+    handler(request);
+    return true;
+  }
+  return false;
+}
+
 ActionCallStatus ServiceProvider::setStatus(const OpID &propertyID,
                                             const CSPayloadIFPtr &newProperty) {
   std::lock_guard lock(propertyMap_);
 
   auto &currentProperty = (*propertyMap_)[propertyID];
-  if (!currentProperty || !currentProperty->equal(newProperty.get())) {
-    currentProperty = newProperty;
-    return broadcast(propertyID, OpCode::StatusRegister, newProperty);
-  } else {
+  if (currentProperty && currentProperty->equal(newProperty.get())) {
     MAF_LOGGER_INFO("Don't set status of property `", propertyID,
                     "` due to unchanged!");
     return ActionCallStatus::NoAction;
   }
+  currentProperty = newProperty;
+
+  auto &publishing = publishing_[propertyID];
+  if (auto due = publishing.lastPublished + publishing.minInterval;
+      publishing.minInterval.count() != 0 && Clock::now() < due) {
+    // The flush at the end of the interval sends whatever is latest by then
+    if (!publishing.flushTimer) {
+      publishing.flushTimer = std::make_unique<SyncTimer>();
+    }
+    if (!publishing.flushTimer->running()) {
+      auto wait = std::chrono::ceil<std::chrono::milliseconds>(
+          due - Clock::now());
+      // The timer thread is shared by every timer of the process, it only
+      // hands the flush to the service's dispatching thread
+      publishing.flushTimer->start(
+          wait, [weakSelf = weak_from_this(), propertyID,
+                 key = sharded_threadpool::shardKeyOf(serviceID())] {
+            auto flush = [weakSelf, propertyID] {
+              if (auto self = weakSelf.lock()) {
+                self->flushStatus(propertyID);
+              }
+            };
+            if (!sharded_threadpool::submit(key, flush)) {
+              flush();
+            }
+          });
+    }
+    return ActionCallStatus::Success;
+  }
+  return publishStatus(propertyID, publishing, newProperty);
+}
+
+void ServiceProvider::setStatusPublishInterval(
+    const OpID &propertyID, std::chrono::milliseconds minInterval) {
+  std::lock_guard lock(propertyMap_);
+  publishing_[propertyID].minInterval = minInterval;
+}
+
+// Must be called with propertyMap_ locked
+ActionCallStatus ServiceProvider::publishStatus(const OpID &propertyID,
+                                                Publishing &publishing,
+                                                const PropertyPtr &status) {
+  // Subscribers hold the published status, they get what changed. A full
+  // one goes now and then for those which missed an update
+  auto update = status;
+  if (publishing.published &&
+      ++publishing.updatesSinceSnapshot < StatusSnapshotInterval) {
+    if (auto changes = status->changesSince(publishing.published.get())) {
+      update = std::move(changes);
+    }
+  } else {
+    publishing.updatesSinceSnapshot = 0;
+  }
+  publishing.published = status;
+  publishing.lastPublished = Clock::now();
+  return broadcast(propertyID, OpCode::StatusRegister, update, status);
+}
+
+void ServiceProvider::flushStatus(const OpID &propertyID) {
+  std::lock_guard lock(propertyMap_);
+  auto itStatus = propertyMap_->find(propertyID);
+  auto itPublishing = publishing_.find(propertyID);
+  if (itStatus != propertyMap_->end() && itPublishing != publishing_.end() &&
+      itStatus->second != itPublishing->second.published) {
+    publishStatus(propertyID, itPublishing->second, itStatus->second);
+  }
+}
+
+// New subscribers start from what the others hold, the pending update then
+// reaches all of them as the same changes. Must be called with propertyMap_
+// locked
+CSPayloadIFPtr ServiceProvider::publishedStatus(const OpID &propertyID) {
+  if (auto it = publishing_.find(propertyID);
+      it != publishing_.end() && it->second.published) {
+    return it->second.published;
+  }
+  return {};
 }
 
 ActionCallStatus ServiceProvider::broadcastSignal(
     const OpID &signalID, const CSPayloadIFPtr &signal) {
-  return broadcast(signalID, OpCode::SignalRegister, signal);
+  return broadcast(signalID, OpCode::SignalRegister, signal, signal);
 }
 
 ActionCallStatus ServiceProvider::broadcast(const OpID &propertyID,
                                             OpCode opCode,
-                                            const CSPayloadIFPtr &content) {
+                                            const CSPayloadIFPtr &content,
+                                            const CSPayloadIFPtr &fullContent) {
   using AddressList = std::vector<Address>;
   bool success = false;
-  AddressList addresses;
-
-  {  // locking _regEntriesMap block
-    std::lock_guard lock(regEntriesMap_);
-    for (const auto &[clientAddress, registeredPropertyIDs] : *regEntriesMap_) {
-      if (registeredPropertyIDs.find(propertyID) !=
-          registeredPropertyIDs.end()) {
-        addresses.push_back(clientAddress);
-      }
-    }
-  }  // locking _regEntriesMap block
 
-  if (addresses.empty()) {
+  if (auto subscribers = subscribersOf(propertyID); !subscribers) {
     MAF_LOGGER_WARN("There's no register for property: ", propertyID);
   } else {
-    auto csMsg = createCSMessage(serviceID(), propertyID, opCode,
-                                 RequestIDInvalid, content);
-
     auto trySendToDestinations =
-        [this, &csMsg](AddressList &addresses) -> AddressList {
+        [this](const CSMessagePtr &csMsg,
+               const AddressList &addresses) -> AddressList {
       AddressList busyReceivers;
-      for (const auto &addr : addresses) {
-        auto errCode = sendMessage(csMsg, addr);
+      // Serialized once for all the destinations
+      auto errCodes = sendMessage(csMsg, addresses);
+      for (size_t i = 0; i < addresses.size(); ++i) {
+        const auto &addr = addresses[i];
+        auto errCode = errCodes[i];
         if (errCode == ActionCallStatus::Success) {
           MAF_LOGGER_INFO("Sent message id: ", csMsg->operationID(),
                           " from server side!");
         } else if (errCode == ActionCallStatus::ReceiverBusy) {
-          busyReceivers.emplace_back(std::move(addr));
+          busyReceivers.push_back(addr);
         } else {
           this->removeRegistersOfAddress(addr);
           MAF_LOGGER_WARN(
@@ -136,21 +217,76 @@ ActionCallStatus ServiceProvider::broadcast(const OpID &propertyID,
       }
       return busyReceivers;
     };
+    auto trySending = [&](const CSPayloadIFPtr &payload,
+                          const AddressList &addresses) {
+      if (addresses.empty()) {
+        return true;
+      }
+      auto csMsg = createCSMessage(serviceID(), propertyID, opCode,
+                                   RequestIDInvalid, payload);
+      auto busyReceivers = trySendToDestinations(csMsg, addresses);
+      if (!busyReceivers.empty()) {
+        // If someones are busy, try with them once
+        MAF_LOGGER_WARN("Trying to send message to busy addresses once again!");
+        busyReceivers = trySendToDestinations(csMsg, busyReceivers);
+      }
+      // success when succeeded to send msg to at least one receiver
+      return busyReceivers.size() != addresses.size();
+    };
 
-    auto busyReceivers = trySendToDestinations(addresses);
-    if (!busyReceivers.empty()) {
-      // If someones are busy, try with them once
-      MAF_LOGGER_WARN("Trying to send message to busy addresses once again!");
-      busyReceivers = trySendToDestinations(busyReceivers);
+    // Filtered subscribers skip updates, so they always get the full content
+    AddressList unfiltered, passed;
+    if (!filterSubscribers(propertyID, *subscribers, fullContent, unfiltered,
+                           passed)) {
+      success = trySending(content, *subscribers);
+    } else if (content == fullContent) {
+      unfiltered.insert(unfiltered.end(), passed.begin(), passed.end());
+      success = trySending(content, unfiltered);
+    } else {
+      success = trySending(content, unfiltered);
+      success = trySending(fullContent, passed) || success;
     }
-
-    // success when succeeded to send msg to at least one receiver
-    success = (busyReceivers.size() != addresses.size());
   }
   return success ? ActionCallStatus::ReceiverUnavailable
                  : ActionCallStatus::Success;
 }
 
+// Returns false if no subscriber of opID has filters, the lists are not
+// filled then
+bool ServiceProvider::filterSubscribers(const OpID &opID,
+                                        const std::vector<Address> &all,
+                                        const CSPayloadIFPtr &fullContent,
+                                        std::vector<Address> &unfiltered,
+                                        std::vector<Address> &passed) {
+  std::lock_guard lock(subscriberFilters_);
+  auto itFilters = subscriberFilters_->find(opID);
+  if (itFilters == subscriberFilters_->end()) {
+    return false;
+  }
+  auto &filters = itFilters->second;
+  for (const auto &addr : all) {
+    if (auto it = filters.find(addr); it == filters.end()) {
+      unfiltered.push_back(addr);
+    } else if (it->second.pass(fullContent.get())) {
+      passed.push_back(addr);
+    }
+  }
+  return true;
+}
+
+bool ServiceProvider::passesFilter(const Address &addr, const OpID &opID,
+                                   const CSPayloadIFPtr &content) {
+  std::lock_guard lock(subscriberFilters_);
+  if (auto itFilters = subscriberFilters_->find(opID);
+      itFilters != subscriberFilters_->end()) {
+    if (auto it = itFilters->second.find(addr);
+        it != itFilters->second.end()) {
+      return it->second.pass(content.get());
+    }
+  }
+  return true;
+}
+
 CSPayloadIFPtr ServiceProvider::getStatus(const OpID &propertyID) {
   std::lock_guard lock(propertyMap_);
   if (auto itStatus = propertyMap_->find(propertyID);
@@ -188,12 +324,25 @@ ActionCallStatus ServiceProvider::sendMessage(const CSMessagePtr &csMsg,
   }
 }
 
+std::vector<ActionCallStatus> ServiceProvider::sendMessage(
+    const CSMessagePtr &csMsg, const std::vector<Address> &toAddrs) {
+  if (auto server = server_.lock()) {
+    return server->sendMessageToClients(csMsg, toAddrs);
+  } else {
+    return std::vector<ActionCallStatus>(toAddrs.size(),
+                                         ActionCallStatus::ReceiverUnavailable);
+  }
+}
+
 ActionCallStatus ServiceProvider::sendBackMessageToClient(
     const CSMessagePtr &csMsg) {
   return sendMessage(csMsg, csMsg->sourceAddress());
 }
 
 void ServiceProvider::onStatusChangeRegister(const CSMessagePtr &msg) {
+  // Held until the latest status is sent, an update published in between
+  // would reach the new subscriber as changes without the status they apply to
+  std::lock_guard lock(propertyMap_);
   // Do this for notifying status when changed
   saveRegisterInfo(msg);
   // Do this for server to update latest status for new registered client
@@ -241,23 +390,97 @@ void ServiceProvider::invalidateAndRemoveAllRequests() {
       }
     }
   }
-  regEntriesMap_->clear();
+  removeAllRegisterInfo();
 }
 
 void ServiceProvider::saveRegisterInfo(const CSMessagePtr &msg) {
-  (*regEntriesMap_.atomic())[msg->sourceAddress()].insert(msg->operationID());
+  std::lock_guard lock(regEntriesMap_);
+  auto &addr = msg->sourceAddress();
+  // Registering again replaces the filters, a client drops them when its
+  // callbacks want different ones
+  if (auto &filters = msg->subscriptionFilters(); filters.empty()) {
+    removeFilterOf(addr, msg->operationID());
+  } else {
+    std::lock_guard filtersLock(subscriberFilters_);
+    (*subscriberFilters_)[msg->operationID()].insert_or_assign(
+        addr, SubscriberFilter{filters});
+  }
+  if ((*regEntriesMap_)[addr].insert(msg->operationID()).second) {
+    updateSubscribers(addr, {msg->operationID()}, true);
+  }
 }
 
 void ServiceProvider::removeRegisterInfo(const CSMessagePtr &msg) {
-  (*regEntriesMap_.atomic())[msg->sourceAddress()].erase(msg->operationID());
+  std::lock_guard lock(regEntriesMap_);
+  auto &addr = msg->sourceAddress();
+  if (auto it = regEntriesMap_->find(addr);
+      it != regEntriesMap_->end() && it->second.erase(msg->operationID())) {
+    updateSubscribers(addr, {msg->operationID()}, false);
+  }
 }
 
 void ServiceProvider::removeAllRegisterInfo() {
-  regEntriesMap_.atomic()->clear();
+  std::lock_guard lock(regEntriesMap_);
+  regEntriesMap_->clear();
+  subscriberFilters_.atomic()->clear();
+  std::atomic_store(&subscriberIndex_,
+                    std::make_shared<const SubscriberIndex>());
 }
 
 void ServiceProvider::removeRegistersOfAddress(const Address &addr) {
-  regEntriesMap_.atomic()->erase(addr);
+  std::lock_guard lock(regEntriesMap_);
+  if (auto it = regEntriesMap_->find(addr); it != regEntriesMap_->end()) {
+    // Only the lists of what the client registered are rebuilt
+    updateSubscribers(addr, it->second, false);
+    regEntriesMap_->erase(it);
+  }
+}
+
+// Must be called with regEntriesMap_ locked
+void ServiceProvider::updateSubscribers(const Address &addr,
+                                        const std::set<OpID> &opIDs,
+                                        bool subscribed) {
+  auto index =
+      std::make_shared<SubscriberIndex>(*std::atomic_load(&subscriberIndex_));
+  for (const auto &opID : opIDs) {
+    auto updated = std::make_shared<std::vector<Address>>();
+    if (auto it = index->find(opID); it != index->end()) {
+      *updated = *it->second;
+    }
+    auto itAddr = std::find(updated->begin(), updated->end(), addr);
+    if (subscribed && itAddr == updated->end()) {
+      updated->push_back(addr);
+    } else if (!subscribed && itAddr != updated->end()) {
+      updated->erase(itAddr);
+      removeFilterOf(addr, opID);
+    }
+
+    if (updated->empty()) {
+      index->erase(opID);
+    } else {
+      (*index)[opID] = std::move(updated);
+    }
+  }
+  std::atomic_store(&subscriberIndex_,
+                    std::shared_ptr<const SubscriberIndex>{std::move(index)});
+}
+
+void ServiceProvider::removeFilterOf(const Address &addr, const OpID &opID) {
+  std::lock_guard lock(subscriberFilters_);
+  if (auto it = subscriberFilters_->find(opID);
+      it != subscriberFilters_->end() && it->second.erase(addr) &&
+      it->second.empty()) {
+    subscriberFilters_->erase(it);
+  }
+}
+
+ServiceProvider::Subscribers ServiceProvider::subscribersOf(
+    const OpID &opID) const {
+  auto index = std::atomic_load(&subscriberIndex_);
+  if (auto it = index->find(opID); it != index->end()) {
+    return it->second;
+  }
+  return {};
 }
 
 void ServiceProvider::onRequestAborted(const CSMessagePtr &msg) {
@@ -285,7 +508,7 @@ void ServiceProvider::onActionRequest(const CSMessagePtr &msg) {
 }
 
 void ServiceProvider::onClientGoesOff(const CSMessagePtr &msg) {
-  regEntriesMap_.atomic()->erase(msg->sourceAddress());
+  removeRegistersOfAddress(msg->sourceAddress());
 }
 
 bool ServiceProvider::registerRequestHandler(
@@ -306,7 +529,9 @@ bool ServiceProvider::unregisterRequestHandler(const OpID &opID) {
 }
 
 void ServiceProvider::updateLatestStatus(const CSMessagePtr &registerMsg) {
-  if (auto currentStatus = getStatus(registerMsg->operationID())) {
+  if (auto currentStatus = publishedStatus(registerMsg->operationID());
+      currentStatus && passesFilter(registerMsg->sourceAddress(),
+                                    registerMsg->operationID(), currentStatus)) {
     registerMsg->setPayload(currentStatus);
     sendBackMessageToClient(registerMsg);
   }
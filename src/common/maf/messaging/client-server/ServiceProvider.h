@@ -1,11 +1,16 @@
 #pragma once
+#include <maf/messaging/SyncTimer.h>
 #include <maf/messaging/client-server/ServiceProviderIF.h>
 #include <maf/threading/Lockable.h>
 
 #include <atomic>
+#include <chrono>
 #include <list>
 #include <map>
 #include <set>
+#include <vector>
+
+#include "SubscriberFilter.h"
 
 namespace maf {
 namespace messaging {
@@ -25,7 +30,20 @@ class ServiceProvider : public ServiceProviderIF,
   using PropertyMap            = OpIDMap<PropertyPtr>;
   using RequestHandlerMap      = OpIDMap<RequestHandlerFunction>;
   using Address2OpIDsMap       = threading::Lockable<std::map<Address, std::set<OpID>>>;
+  using Subscribers            = std::shared_ptr<const std::vector<Address>>;
+  using SubscriberIndex        = std::map<OpID, Subscribers>;
+  using SubscriberFilters      = OpIDMap<std::map<Address, SubscriberFilter>>;
+  using Clock                  = std::chrono::steady_clock;
   // clang-format on
+
+  // What the subscribers of a status last received
+  struct Publishing {
+    PropertyPtr published;
+    size_t updatesSinceSnapshot = 0;
+    std::chrono::milliseconds minInterval{0};
+    Clock::time_point lastPublished;
+    std::unique_ptr<SyncTimer> flushTimer;
+  };
  public:
   ServiceProvider(ServiceID sid, std::weak_ptr<ServerIF> server);
 
@@ -35,10 +53,13 @@ class ServiceProvider : public ServiceProviderIF,
   Availability availability() const override;
 
   ActionCallStatus respondToRequest(const CSMessagePtr &csMsg) override;
+  bool dispatchRequest(const std::shared_ptr<RequestIF> &request) override;
 
   CSPayloadIFPtr getStatus(const OpID &propertyID) override;
   ActionCallStatus setStatus(const OpID &propertyID,
                              const CSPayloadIFPtr &newProperty) override;
+  void setStatusPublishInterval(const OpID &propertyID,
+                                std::chrono::milliseconds minInterval) override;
 
   ActionCallStatus broadcastSignal(const OpID &signalID,
                                    const CSPayloadIFPtr &signal) override;
@@ -53,10 +74,25 @@ class ServiceProvider : public ServiceProviderIF,
   bool onIncomingMessage(const CSMessagePtr &msg) override;
 
  private:
+  ActionCallStatus publishStatus(const OpID &propertyID,
+                                 Publishing &publishing,
+                                 const PropertyPtr &status);
+  void flushStatus(const OpID &propertyID);
+  CSPayloadIFPtr publishedStatus(const OpID &propertyID);
   ActionCallStatus broadcast(const OpID &propertyID, OpCode opCode,
-                             const CSPayloadIFPtr &content);
+                             const CSPayloadIFPtr &content,
+                             const CSPayloadIFPtr &fullContent);
+  bool filterSubscribers(const OpID &opID, const std::vector<Address> &all,
+                         const CSPayloadIFPtr &fullContent,
+                         std::vector<Address> &unfiltered,
+                         std::vector<Address> &passed);
+  bool passesFilter(const Address &addr, const OpID &opID,
+                    const CSPayloadIFPtr &content);
+  void removeFilterOf(const Address &addr, const OpID &opID);
   ActionCallStatus sendMessage(const CSMessagePtr &csMsg,
                                const Address &toAddr);
+  std::vector<ActionCallStatus> sendMessage(const CSMessagePtr &csMsg,
+                                            const std::vector<Address> &toAddrs);
   ActionCallStatus sendBackMessageToClient(const CSMessagePtr &csMsg);
   void onStatusChangeRegister(const CSMessagePtr &msg);
   void onStatusChangeUnregister(const CSMessagePtr &msg);
@@ -70,6 +106,9 @@ class ServiceProvider : public ServiceProviderIF,
   void removeRegisterInfo(const CSMessagePtr &msg);
   void removeAllRegisterInfo();
   void removeRegistersOfAddress(const Address &addr);
+  void updateSubscribers(const Address &addr, const std::set<OpID> &opIDs,
+                         bool subscribed);
+  Subscribers subscribersOf(const OpID &opID) const;
 
   void onRequestAborted(const CSMessagePtr &msg);
   void onClientGoesOff(const CSMessagePtr &msg);
@@ -83,9 +122,15 @@ class ServiceProvider : public ServiceProviderIF,
   // clang-format off
   ServiceID                    sid_;
   Address2OpIDsMap             regEntriesMap_;
+  // Same registrations by OpID, replaced as a whole under the regEntriesMap_
+  // lock so that broadcasts read it without locking
+  std::shared_ptr<const SubscriberIndex> subscriberIndex_;
+  SubscriberFilters            subscriberFilters_;
   RequestMap                   requestsMap_;
   std::weak_ptr<ServerIF>      server_;
   PropertyMap                  propertyMap_;
+  // Under the propertyMap_ lock
+  std::map<OpID, Publishing>   publishing_;
   RequestHandlerMap            requestHandlerMap_;
   std::atomic<Availability>    availability_ = Availability::Unavailable;
   // clang-format on
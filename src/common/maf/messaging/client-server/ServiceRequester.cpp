@@ -4,8 +4,13 @@
 #include <maf/messaging/client-server/CSError.h>
 #include <maf/messaging/client-server/ClientIF.h>
 #include <maf/messaging/client-server/Exceptions.h>
+#include <maf/messaging/client-server/ServiceProviderIF.h>
 #include <maf/utils/Pointers.h>
 
+#include <utility>
+
+#include "DirectRequest.h"
+
 #define SET_ERROR_AND_RETURN_IF(condition, pErrorStore, errorValue, \
                                 returnedValue)                      \
   do {                                                              \
@@ -34,6 +39,18 @@ bool ServiceRequester::onIncomingMessage(const CSMessagePtr &csMsg) {
         onRegistersUpdated(csMsg);
         break;
       case OpCode::StatusRegister: {
+        // Changes are patched onto the cached status, without it they wait
+        // for the next full status
+        if (auto status = csMsg->payload(); status && status->partial()) {
+          std::lock_guard lock(propertiesCache_);
+          auto itProp = propertiesCache_->find(csMsg->operationID());
+          if (itProp == propertiesCache_->end()) {
+            MAF_LOGGER_WARN("Dropped changes of status ",
+                            csMsg->operationID(), " not known yet");
+            break;
+          }
+          csMsg->setPayload(status->patchedOnto(itProp->second));
+        }
         if (onRegistersUpdated(csMsg)) {
           cachePropertyStatus(csMsg->operationID(), csMsg->payload());
         }
@@ -58,7 +75,9 @@ bool ServiceRequester::onIncomingMessage(const CSMessagePtr &csMsg) {
 
 ServiceRequester::ServiceRequester(const ServiceID &sid,
                                    std::weak_ptr<ClientIF> client)
-    : client_(std::move(client)), sid_(sid) {}
+    : client_(std::move(client)), sid_(sid) {
+  InternedID::publish(sid_);
+}
 
 ServiceRequester::~ServiceRequester() {
   MAF_LOGGER_INFO("Clean up service requester of service id: ", serviceID(),
@@ -83,6 +102,11 @@ void ServiceRequester::abortRequest(const RegID &regID,
       /*void*/
   );
 
+  if (abortDirectRequest(regID)) {
+    assign_ptr(callStatus, ActionCallStatus::Success);
+    return;
+  }
+
   bool found = false;
 
   {  // create {block} for releasing lock on _requestEntriesMap
@@ -168,6 +192,15 @@ RegID ServiceRequester::sendMessageAsync(const OpID &operationID,
                                          const CSPayloadIFPtr &msgContent,
                                          CSPayloadProcessCallback callback,
                                          ActionCallStatus *callStatus) {
+  if (operationCode == OpCode::Request) {
+    if (auto provider = std::atomic_load(&localProvider_)) {
+      if (auto regID = sendRequestDirectly(provider, operationID, msgContent,
+                                           callback, callStatus);
+          regID.valid()) {
+        return regID;
+      }
+    }
+  }
   auto csMsg = this->createCSMessage(operationID, operationCode, msgContent);
   return storeAndSendRequestToServer(requestEntriesMap_, csMsg,
                                      std::move(callback), callStatus);
@@ -231,15 +264,84 @@ CSPayloadIFPtr ServiceRequester::sendMessageSync(
   return {};
 }
 
+// Returns an invalid RegID if the provider has no handler, the request then
+// goes the usual way and gets the usual error
+RegID ServiceRequester::sendRequestDirectly(
+    const std::shared_ptr<ServiceProviderIF> &provider, const OpID &opID,
+    const CSPayloadIFPtr &msgContent, CSPayloadProcessCallback callback,
+    ActionCallStatus *callStatus) {
+  RegID regID;
+  RegID::allocateUniqueID(regID, idMgr_);
+  regID.opID = opID;
+
+  auto onResponse = [requests = std::weak_ptr<DirectRequests>{directRequests_},
+                     requestID = regID.requestID,
+                     callback = std::move(callback)](
+                        const CSPayloadIFPtr &answer) {
+    if (auto directRequests = requests.lock()) {
+      directRequests->atomic()->erase(requestID);
+    }
+    if (callback) {
+      callback(answer);
+    }
+  };
+  auto request = std::make_shared<DirectRequest>(
+      opID, regID.requestID, msgContent, std::move(onResponse));
+  directRequests_->atomic()->emplace(regID.requestID, request);
+
+  if (!provider->dispatchRequest(request)) {
+    directRequests_->atomic()->erase(regID.requestID);
+    RegID::reclaimID(regID, idMgr_);
+    return {};
+  }
+  assign_ptr(callStatus, ActionCallStatus::Success);
+  return regID;
+}
+
+bool ServiceRequester::abortDirectRequest(const RegID &regID) {
+  std::shared_ptr<DirectRequest> request;
+  {
+    std::lock_guard lock(*directRequests_);
+    if (auto it = (*directRequests_)->find(regID.requestID);
+        it != (*directRequests_)->end()) {
+      request = it->second.lock();
+      (*directRequests_)->erase(it);
+    } else {
+      return false;
+    }
+  }
+  if (request) {
+    request->abort();
+  }
+  RegID::reclaimID(regID, idMgr_);
+  return true;
+}
+
+void ServiceRequester::abortAllDirectRequests() {
+  std::map<RegID::RequestIDType, std::weak_ptr<DirectRequest>> requests;
+  directRequests_->atomic()->swap(requests);
+  for (auto &[requestID, request] : requests) {
+    if (auto directRequest = request.lock()) {
+      directRequest->abort();
+    }
+  }
+}
+
 void ServiceRequester::onServiceStatusChanged(const ServiceID &sid,
                                               Availability oldStatus,
                                               Availability newStatus) {
   MAF_LOGGER_INFO("Server status change from ", oldStatus, " to ", newStatus);
   if ((sid == serviceID()) && (newStatus != serviceStatus_)) {
     serviceStatus_ = newStatus;
-    if (newStatus == Availability::Unavailable) {
+    if (newStatus == Availability::Available) {
+      if (auto client = client_.lock()) {
+        std::atomic_store(&localProvider_, client->localServiceProvider(sid));
+      }
+    } else if (newStatus == Availability::Unavailable) {
       serviceStatus_ = Availability::Unavailable;
+      std::atomic_store(&localProvider_, {});
       clearAllRequests();
+      abortAllDirectRequests();
       clearAllRegisterEntries();
     }
     forwardServiceStatusToObservers(sid, oldStatus, newStatus);
@@ -276,17 +378,35 @@ void ServiceRequester::forwardServiceStatusToObservers(const ServiceID &sid,
 
 RegID ServiceRequester::registerNotification(const OpID &opID, OpCode opCode,
                                              CSPayloadProcessCallback callback,
-                                             ActionCallStatus *callStatus) {
+                                             ActionCallStatus *callStatus,
+                                             const SubscriptionFilters &filters,
+                                             FieldReader readField) {
   SET_ERROR_AND_RETURN_IF(!callback, callStatus, ActionCallStatus::InvalidParam,
                           {});
 
   RegID regID;
-  auto sameRegisterCount =
-      storeRegEntry(registerEntriesMap_, opID, callback, regID);
-  if (sameRegisterCount == 1) {
+  RegID::allocateUniqueID(regID, idMgr_);
+  regID.opID = opID;
+
+  RegEntry entry{regID.requestID, std::move(callback)};
+  entry.filters = filters;
+  entry.readField = readField ? std::move(readField)
+                              : [](const CSPayloadIFPtr &update, size_t index) {
+                                  return update ? update->numericField(index)
+                                                : std::optional<double>{};
+                                };
+  auto change = storeNotificationEntry(opID, entry);
+  if (change != SubscriptionChange::None) {
     auto registerMessage = createCSMessage(opID, opCode);
 
     registerMessage->setRequestID(regID.requestID);
+    if (change == SubscriptionChange::New) {
+      registerMessage->setSubscriptionFilters(filters);
+    } else {
+      // The cached status is the last one passing the dropped filters, the
+      // server sends the current one again
+      removeCachedProperty(opID);
+    }
 
     auto status = sendMessageToServer(registerMessage);
     if (status != ActionCallStatus::Success) {
@@ -296,8 +416,9 @@ RegID ServiceRequester::registerNotification(const OpID &opID, OpCode opCode,
 
     assign_ptr(callStatus, status);
   } else if (opCode == OpCode::StatusRegister) {
-    if (auto cachedProperty = getCachedProperty(opID)) {
-      callback(cachedProperty);
+    if (auto cachedProperty = getCachedProperty(opID);
+        cachedProperty && passesLocalFilter(entry, cachedProperty)) {
+      entry.callback(cachedProperty);
     }
     assign_ptr(callStatus, ActionCallStatus::Success);
   }
@@ -314,22 +435,28 @@ CSMessagePtr ServiceRequester::createCSMessage(
 
 RegID ServiceRequester::registerStatus(const OpID &propertyID,
                                        CSPayloadProcessCallback callback,
-                                       ActionCallStatus *callStatus) {
+                                       ActionCallStatus *callStatus,
+                                       const SubscriptionFilters &filters,
+                                       FieldReader readField) {
   SET_ERROR_AND_RETURN_IF(serviceUnavailable(), callStatus,
                           ActionCallStatus::ServiceUnavailable, {});
 
   return registerNotification(propertyID, OpCode::StatusRegister,
-                              std::move(callback), callStatus);
+                              std::move(callback), callStatus, filters,
+                              std::move(readField));
 }
 
 RegID ServiceRequester::registerSignal(const OpID &eventID,
                                        CSPayloadProcessCallback callback,
-                                       ActionCallStatus *callStatus) {
+                                       ActionCallStatus *callStatus,
+                                       const SubscriptionFilters &filters,
+                                       FieldReader readField) {
   SET_ERROR_AND_RETURN_IF(serviceUnavailable(), callStatus,
                           ActionCallStatus::ServiceUnavailable, {});
 
   return registerNotification(eventID, OpCode::SignalRegister,
-                              std::move(callback), callStatus);
+                              std::move(callback), callStatus, filters,
+                              std::move(readField));
 }
 
 ActionCallStatus ServiceRequester::unregister(const RegID &regID) {
@@ -398,30 +525,42 @@ ActionCallStatus ServiceRequester::getStatus(
 }
 
 bool ServiceRequester::onRegistersUpdated(const CSMessagePtr &msg) {
-  std::vector<decltype(RegEntry::callback)> callbacks;
+  std::vector<RegEntry> entries;
+  bool registered = false;
 
   {
     std::lock_guard lock(registerEntriesMap_);
     auto it = registerEntriesMap_->find(msg->operationID());
     if (it != registerEntriesMap_->end()) {
+      registered = true;
+      // The other callbacks got the status through the dropped filters
+      auto onlyRequestID = RequestIDInvalid;
+      if (auto itSub = subscriptions_.find(msg->operationID());
+          itSub != subscriptions_.end() &&
+          itSub->second.unfilteredBy != RequestIDInvalid &&
+          itSub->second.unfilteredBy == msg->requestID()) {
+        onlyRequestID = std::exchange(itSub->second.unfilteredBy,
+                                      RequestIDInvalid);
+      }
       for (auto &regEntry : it->second) {
-        callbacks.push_back(regEntry.callback);
+        if (onlyRequestID == RequestIDInvalid ||
+            regEntry.requestID == onlyRequestID) {
+          entries.push_back(regEntry);
+        }
       }
     }
   }
 
-  if (auto payload = msg->payload()) {
-    for (auto &callback : callbacks) {
-      // the payload must be cloned here due to state of
-      // IByteStream will change if deserialize it
-      callback(CSPayloadIFPtr(payload->clone()));
-    }
-  } else {
-    for (auto &callback : callbacks) {
-      callback(payload);
+  auto payload = msg->payload();
+  for (auto &entry : entries) {
+    // the payload must be cloned here due to state of
+    // IByteStream will change if deserialize it
+    auto update = payload ? CSPayloadIFPtr(payload->clone()) : payload;
+    if (passesLocalFilter(entry, update)) {
+      entry.callback(std::move(update));
     }
   }
-  return !callbacks.empty();
+  return registered;
 }
 
 void ServiceRequester::onRequestResult(const CSMessagePtr &msg) {
@@ -512,6 +651,45 @@ size_t ServiceRequester::storeRegEntry(RegEntriesMap &regInfoEntries,
   return regEntries.size();
 }
 
+// The server subscription of an operation carries the filters while all its
+// callbacks have the same ones, otherwise it is unfiltered and the callbacks
+// with filters check them here
+ServiceRequester::SubscriptionChange ServiceRequester::storeNotificationEntry(
+    const OpID &opID, RegEntry &entry) {
+  std::lock_guard lock(registerEntriesMap_);
+  auto &regEntries = (*registerEntriesMap_)[opID];
+  auto &subscription = subscriptions_[opID];
+  auto change = SubscriptionChange::None;
+  if (regEntries.empty()) {
+    subscription = Subscription{entry.filters};
+    change = SubscriptionChange::New;
+  } else if (entry.filters != subscription.filters) {
+    if (!subscription.filters.empty()) {
+      subscription.filters.clear();
+      subscription.unfilteredBy = entry.requestID;
+      change = SubscriptionChange::Unfiltered;
+    }
+    for (auto &regEntry : regEntries) {
+      if (!regEntry.filters.empty() && !regEntry.localFilter) {
+        regEntry.localFilter =
+            std::make_shared<SubscriberFilter>(regEntry.filters);
+      }
+    }
+    if (!entry.filters.empty()) {
+      entry.localFilter = std::make_shared<SubscriberFilter>(entry.filters);
+    }
+  }
+  regEntries.push_back(entry);
+  return change;
+}
+
+bool ServiceRequester::passesLocalFilter(const RegEntry &entry,
+                                         const CSPayloadIFPtr &update) {
+  return !entry.localFilter || entry.localFilter->pass([&](uint32_t field) {
+    return entry.readField(update, field);
+  });
+}
+
 size_t ServiceRequester::removeRegEntry(RegEntriesMap &regInfoEntriesMap,
                                         const RegID &regID) {
   std::lock_guard lock(regInfoEntriesMap);
@@ -559,7 +737,12 @@ void ServiceRequester::removeCachedProperty(const OpID &propertyID) {
 
 bool ServiceRequester::cachedPropertyUpToDate(const OpID &propertyID) const {
   std::lock_guard lock(registerEntriesMap_);
-  return registerEntriesMap_->find(propertyID) != registerEntriesMap_->end();
+  if (registerEntriesMap_->find(propertyID) == registerEntriesMap_->end()) {
+    return false;
+  }
+  // Filtered by the server, the cached status may be behind
+  auto itSub = subscriptions_.find(propertyID);
+  return itSub == subscriptions_.end() || itSub->second.filters.empty();
 }
 
 }  // namespace messaging
@@ -12,10 +12,14 @@
 #include <map>
 #include <set>
 
+#include "SubscriberFilter.h"
+
 namespace maf {
 namespace messaging {
 
 class ClientIF;
+class DirectRequest;
+class ServiceProviderIF;
 struct ServiceRequester : public ServiceRequesterIF {
   struct RegEntry {
     RegID::RequestIDType requestID;
@@ -24,6 +28,23 @@ struct ServiceRequester : public ServiceRequesterIF {
     RegEntry() = default;
     RegEntry(RegID::RequestIDType requestID, CSPayloadProcessCallback callback)
         : requestID(requestID), callback(std::move(callback)) {}
+
+    // Filters of a status or signal callback, checked here when the server
+    // subscription does not carry them
+    SubscriptionFilters filters;
+    FieldReader readField;
+    std::shared_ptr<SubscriberFilter> localFilter;
+  };
+
+  // What a new status or signal callback changes in the server subscription
+  enum class SubscriptionChange { None, New, Unfiltered };
+
+  // Server side subscription of an operation
+  struct Subscription {
+    SubscriptionFilters filters;
+    // Register message dropping the filters, the status answering it goes to
+    // the callback registering then only
+    RegID::RequestIDType unfilteredBy = RequestIDInvalid;
   };
 
   struct SyncRegEntry {
@@ -37,6 +58,8 @@ struct ServiceRequester : public ServiceRequesterIF {
   using RegEntriesMap = OpIDMap<std::list<RegEntry>>;
   using SyncRegEntriesMap = OpIDMap<std::list<SyncRegEntry>>;
   using CSMsgContentMap = OpIDMap<CSPayloadIFPtr>;
+  using DirectRequests = threading::Lockable<
+      std::map<RegID::RequestIDType, std::weak_ptr<DirectRequest>>>;
   using ServiceStatusObserverPtr = ServiceRequesterIF::ServiceStatusObserverPtr;
   using ServiceStatusObservers =
       threading::Lockable<std::list<ServiceStatusObserverPtr>>;
@@ -50,10 +73,14 @@ struct ServiceRequester : public ServiceRequesterIF {
 
   RegID registerStatus(const OpID &propertyID,
                        CSPayloadProcessCallback callback,
-                       ActionCallStatus *callStatus) override;
+                       ActionCallStatus *callStatus,
+                       const SubscriptionFilters &filters,
+                       FieldReader readField) override;
 
   RegID registerSignal(const OpID &eventID, CSPayloadProcessCallback callback,
-                       ActionCallStatus *callStatus) override;
+                       ActionCallStatus *callStatus,
+                       const SubscriptionFilters &filters,
+                       FieldReader readField) override;
 
   ActionCallStatus unregister(const RegID &regID) override;
   ActionCallStatus unregisterAll(const OpID &propertyID) override;
@@ -92,7 +119,9 @@ struct ServiceRequester : public ServiceRequesterIF {
 
   RegID registerNotification(const OpID &opID, OpCode opCode,
                              CSPayloadProcessCallback callback,
-                             ActionCallStatus *callStatus);
+                             ActionCallStatus *callStatus,
+                             const SubscriptionFilters &filters,
+                             FieldReader readField);
 
   // Helper functions
   RegID sendMessageAsync(const OpID &operationID, OpCode operationCode,
@@ -108,6 +137,13 @@ struct ServiceRequester : public ServiceRequesterIF {
   CSMessagePtr createCSMessage(const OpID &opID, OpCode opCode,
                                const CSPayloadIFPtr &msgContent = nullptr);
 
+  RegID sendRequestDirectly(const std::shared_ptr<ServiceProviderIF> &provider,
+                            const OpID &opID, const CSPayloadIFPtr &msgContent,
+                            CSPayloadProcessCallback callback,
+                            ActionCallStatus *callStatus);
+  bool abortDirectRequest(const RegID &regID);
+  void abortAllDirectRequests();
+
   bool onRegistersUpdated(const CSMessagePtr &msg);
   void onRequestResult(const CSMessagePtr &msg);
   void clearAllRequests();
@@ -124,16 +160,29 @@ struct ServiceRequester : public ServiceRequesterIF {
 
   size_t removeRegEntry(RegEntriesMap &regInfoEntriesMap, const RegID &regID);
 
+  SubscriptionChange storeNotificationEntry(const OpID &opID, RegEntry &entry);
+  static bool passesLocalFilter(const RegEntry &entry,
+                                const CSPayloadIFPtr &update);
+
   CSPayloadIFPtr getCachedProperty(const OpID &propertyID) const;
   void cachePropertyStatus(const OpID &propertyID, CSPayloadIFPtr &&property);
   void removeCachedProperty(const OpID &propertyID);
   bool cachedPropertyUpToDate(const OpID &propertyID) const;
 
   RegEntriesMap registerEntriesMap_;
+  // Guarded by the lock of registerEntriesMap_, an entry is left over when its
+  // operation has no callback anymore, the next registration resets it
+  std::map<OpID, Subscription> subscriptions_;
   RegEntriesMap requestEntriesMap_;
   ServiceStatusObservers serviceStatusObservers_;
   CSMsgContentMap propertiesCache_;
   std::weak_ptr<ClientIF> client_;
+  // Provider of the service when it runs in this process, set while the
+  // service is available
+  std::shared_ptr<ServiceProviderIF> localProvider_;
+  // Shared with the response callbacks, which may outlive this requester
+  std::shared_ptr<DirectRequests> directRequests_ =
+      std::make_shared<DirectRequests>();
   CSIDManager idMgr_;
   ServiceID sid_;
   AtomicAvailability serviceStatus_ = Availability::Unavailable;
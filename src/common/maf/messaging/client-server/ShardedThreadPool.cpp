@@ -0,0 +1,107 @@
+#include "ShardedThreadPool.h"
+
+#include <maf/messaging/ComponentEx.h>
+#include <maf/messaging/client-server/Address.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace maf {
+namespace messaging {
+namespace sharded_threadpool {
+
+namespace {
+
+class Shard : public ComponentExBase {
+  std::thread thread_;
+
+ public:
+  void launch() {
+    thread_ = std::thread{[this] { instance_->run(); }};
+  }
+
+  void stopAndWait() {
+    instance()->stop();
+    if (thread_.joinable()) {
+      thread_.join();
+    }
+  }
+};
+
+size_t defaultThreadCount() {
+  return std::clamp<size_t>(std::thread::hardware_concurrency(), 1, 4);
+}
+
+struct ThePool {
+  // Taken by init and setThreadCount, a count set while starting would be
+  // reported as applied but not used
+  std::mutex startMutex;
+  std::atomic<size_t> threadCount = defaultThreadCount();
+  std::atomic<bool> started = false;
+  std::vector<std::unique_ptr<Shard>> shards;
+};
+
+ThePool& thepool() {
+  static ThePool _;
+  return _;
+}
+
+}  // namespace
+
+void init() {
+  auto& pool = thepool();
+  std::lock_guard lock(pool.startMutex);
+  if (!pool.started.exchange(true)) {
+    for (size_t i = 0; i < pool.threadCount; ++i) {
+      pool.shards.emplace_back(new Shard)->launch();
+    }
+  }
+}
+
+void deinit() {
+  for (auto& shard : thepool().shards) {
+    shard->stopAndWait();
+  }
+}
+
+bool setThreadCount(size_t count) {
+  auto& pool = thepool();
+  std::lock_guard lock(pool.startMutex);
+  if (count == 0 || pool.started) {
+    return false;
+  }
+  pool.threadCount = count;
+  return true;
+}
+
+size_t threadCount() { return thepool().threadCount; }
+
+bool submit(TaskType task) { return submit(0, std::move(task)); }
+
+bool submit(ShardKey key, TaskType task) {
+  auto& shards = thepool().shards;
+  if (shards.empty()) {
+    return false;
+  }
+  return (*shards[key % shards.size()])->execute(std::move(task));
+}
+
+ShardKey shardKeyOf(const std::string& str) {
+  return std::hash<std::string>{}(str);
+}
+
+ShardKey shardKeyOf(const ServiceID& sid) {
+  return static_cast<ShardKey>(sid.hash());
+}
+
+ShardKey shardKeyOf(const Address& addr) {
+  return shardKeyOf(addr.get_name()) ^
+         std::hash<Address::Port>{}(addr.get_port());
+}
+
+}  // namespace sharded_threadpool
+}  // namespace messaging
+}  // namespace maf
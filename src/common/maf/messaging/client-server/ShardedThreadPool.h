@@ -0,0 +1,36 @@
+#pragma once
+
+#include <maf/messaging/client-server/CSTypes.h>
+
+#include <functional>
+#include <string>
+
+namespace maf {
+namespace messaging {
+
+class Address;
+
+// Threads decoding and dispatching incoming client-server messages.
+// Tasks submitted with the same key always run on the same thread in
+// submission order, tasks with different keys may run in parallel.
+namespace sharded_threadpool {
+
+using TaskType = std::function<void()>;
+using ShardKey = size_t;
+
+void init();
+void deinit();
+//! Takes effect only before init
+bool setThreadCount(size_t count);
+size_t threadCount();
+
+bool submit(TaskType task);
+bool submit(ShardKey key, TaskType task);
+
+ShardKey shardKeyOf(const std::string &str);
+ShardKey shardKeyOf(const ServiceID &sid);
+ShardKey shardKeyOf(const Address &addr);
+
+}  // namespace sharded_threadpool
+}  // namespace messaging
+}  // namespace maf
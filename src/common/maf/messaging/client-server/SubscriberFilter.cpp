@@ -0,0 +1,72 @@
+#include "SubscriberFilter.h"
+
+#include <cmath>
+
+namespace maf {
+namespace messaging {
+
+using Kind = SubscriptionFilter::Kind;
+
+SubscriberFilter::SubscriberFilter(SubscriptionFilters filters)
+    : filters_{std::move(filters)} {}
+
+bool SubscriberFilter::pass(const CSMsgPayloadIF *update) {
+  return pass([update](uint32_t field) {
+    return update ? update->numericField(field) : std::optional<double>{};
+  });
+}
+
+bool SubscriberFilter::pass(const FieldOf &readField) {
+  bool decimated = false;
+  for (const auto &filter : filters_) {
+    if (filter.kind == Kind::EveryNth) {
+      // Counted among the updates the other filters let through
+      decimated = true;
+      continue;
+    }
+    auto value = readField(filter.field);
+    if (!value) {
+      return false;
+    }
+    switch (filter.kind) {
+      case Kind::Equal:
+        if (*value != filter.low) {
+          return false;
+        }
+        break;
+      case Kind::Range:
+        if (*value < filter.low || *value > filter.high) {
+          return false;
+        }
+        break;
+      case Kind::ChangeAtLeast:
+        if (auto it = lastSent_.find(filter.field);
+            it != lastSent_.end() && std::abs(*value - it->second) < filter.low) {
+          return false;
+        }
+        break;
+      default:
+        break;
+    }
+  }
+
+  if (decimated) {
+    auto seen = updatesSeen_++;
+    for (const auto &filter : filters_) {
+      if (filter.kind == Kind::EveryNth && filter.low > 1 &&
+          seen % static_cast<size_t>(filter.low) != 0) {
+        return false;
+      }
+    }
+  }
+
+  for (const auto &filter : filters_) {
+    if (filter.kind == Kind::ChangeAtLeast) {
+      lastSent_[filter.field] = *readField(filter.field);
+    }
+  }
+  return true;
+}
+
+}  // namespace messaging
+}  // namespace maf
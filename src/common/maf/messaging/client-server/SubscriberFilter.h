@@ -0,0 +1,33 @@
+#pragma once
+
+#include <maf/messaging/client-server/CSMsgPayloadIF.h>
+#include <maf/messaging/client-server/SubscriptionFilter.h>
+
+#include <functional>
+#include <map>
+#include <optional>
+
+namespace maf {
+namespace messaging {
+
+// Filters of one subscriber, with what they need to remember between updates
+class SubscriberFilter {
+ public:
+  explicit SubscriberFilter(SubscriptionFilters filters);
+
+  // Whether the subscriber gets this update, a field the filters cannot read
+  // fails them
+  bool pass(const CSMsgPayloadIF *update);
+
+  // Same, with the fields read by readField
+  using FieldOf = std::function<std::optional<double>(uint32_t)>;
+  bool pass(const FieldOf &readField);
+
+ private:
+  SubscriptionFilters filters_;
+  std::map<uint32_t, double> lastSent_;
+  size_t updatesSeen_ = 0;
+};
+
+}  // namespace messaging
+}  // namespace maf
@@ -11,6 +11,10 @@ class BytesComeObserver {
 public:
   virtual ~BytesComeObserver() = default;
   virtual void onBytesCome(srz::Buffer &&bytes) = 0;
+  //! Bytes the sender shared instead of copying, copied here by default
+  virtual void onSharedBytesCome(srz::SharedBytes &&bytes) {
+    onBytesCome(srz::Buffer{bytes.bytes});
+  }
 };
 
 class BufferReceiverIF {
@@ -4,10 +4,16 @@
 #include <maf/messaging/client-server/CSStatus.h>
 #include <maf/utils/serialization/Buffer.h>
 
+#include <functional>
+#include <memory>
+
 namespace maf {
 namespace messaging {
 namespace ipc {
 
+using ReceiverStatusCallback = std::function<void(Availability)>;
+using ReceiverGoneCallback = std::function<void(const Address &)>;
+
 class BufferSenderIF {
  public:
   virtual ~BufferSenderIF() = default;
@@ -15,6 +21,25 @@ class BufferSenderIF {
                                 const Address &destination) = 0;
   virtual Availability checkReceiverStatus(
       const Address &destination) const = 0;
+  //! Sends bytes that may be queued for several destinations at once, a
+  //! sender that keeps them holds a reference instead of a copy
+  virtual ActionCallStatus sendShared(
+      const std::shared_ptr<const srz::Buffer> &ba,
+      const Address &destination) {
+    return send(*ba, destination);
+  }
+  //! Tells the receivers found gone, for senders which keep connections to
+  //! them. The callback may come on the sender's own thread
+  virtual void setReceiverGoneCallback(ReceiverGoneCallback /*callback*/) {}
+  //! Reports the availability changes of destination as they happen, an
+  //! empty callback stops watching it and waits for a running callback.
+  //! Callbacks may share one thread for all the destinations, they must not
+  //! block. Returns false if the sender cannot, then checkReceiverStatus()
+  //! must be polled
+  virtual bool watchReceiver(const Address & /*destination*/,
+                             ReceiverStatusCallback /*callback*/) {
+    return false;
+  }
 };
 
 }  // namespace ipc
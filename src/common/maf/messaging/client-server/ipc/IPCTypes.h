@@ -1,5 +1,9 @@
 #pragma once
 
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
 namespace maf {
 namespace messaging {
 namespace ipc {
@@ -11,6 +15,64 @@ enum class IPCType : unsigned char {
   Invalid
 };
 
+enum class ConnectionMode : unsigned char {
+  // Connect, send one message then close
+  OneShot,
+  // Keep one connection per destination open and reconnect when it breaks
+  Persistent,
+  // Persistent, plus the messages queued for a destination are written
+  // together within the BatchLimits. send() only tells whether the receiver
+  // was reachable, a batch failing later is logged
+  Batched
+};
+
+struct BatchLimits {
+  std::chrono::microseconds maxDelay{200};
+  size_t maxBytes = 64 * 1024;
+};
+
+struct LivenessOptions {
+  // Longest wait before trying an unavailable receiver again, the first
+  // retries come sooner. Nothing listens there, so it costs the receiver
+  // nothing
+  std::chrono::milliseconds retryInterval{500};
+  // Empty frames written on an idle connection to check the receiver still
+  // takes them, 0 relies on the connection hangup only
+  std::chrono::milliseconds heartbeatInterval{0};
+};
+
+// Counted since the sender or receiver was created
+struct TransferStats {
+  uint64_t messages = 0;
+  uint64_t syscalls = 0;
+  uint64_t bytes = 0;
+};
+
+// What a queued sender does with a message for a receiver whose queue is full
+enum class SlowReceiverPolicy : unsigned char {
+  // Discard the oldest queued message not being written yet
+  DropOldest,
+  // Close the connection and drop the queue, the send fails
+  DropClient,
+  // Wait until the receiver takes a message
+  Block
+};
+
+struct SendQueueStats {
+  size_t depth = 0;
+  size_t maxDepth = 0;
+  uint64_t sent = 0;
+  uint64_t dropped = 0;
+};
+
+inline constexpr size_t DefaultSendQueueLimit = 1024;
+
+// Payloads from this size on are passed to a local receiver as a sealed memfd
+// it maps, instead of being copied through the socket. Below it, copying into
+// reused heap buffers is cheaper than allocating fresh shared pages; above it
+// malloc maps fresh pages for every buffer anyway
+inline constexpr size_t DefaultSharedPayloadThreshold = 32 * 1024 * 1024;
+
 } // namespace ipc
 } // namespace messaging
 } // namespace maf
@@ -31,7 +31,16 @@ const Address &LocalIPCBufferReceiver::address() const {
 
 void LocalIPCBufferReceiver::setObserver(BytesComeObserver *observer) {
   _impl->setObserver(
-      [observer](auto &&bytes) { observer->onBytesCome(std::move(bytes)); });
+      [observer](auto &&bytes) { observer->onBytesCome(std::move(bytes)); },
+      [observer](auto &&bytes) {
+        observer->onSharedBytesCome(std::move(bytes));
+      });
+}
+
+TransferStats LocalIPCBufferReceiver::stats() const {
+  auto &counters = _impl->counters();
+  return {counters.messages.load(), counters.syscalls.load(),
+          counters.bytes.load()};
 }
 
 }  // namespace local
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "BufferReceiverIF.h"
+#include "IPCTypes.h"
 #include <memory>
 
 namespace maf {
@@ -19,6 +20,7 @@ class LocalIPCBufferReceiver : public BufferReceiverIF {
   void deinit() override;
   const Address &address() const override;
   void setObserver(BytesComeObserver *observer) override;
+  TransferStats stats() const;
 
  private:
   std::unique_ptr<class LocalIPCBufferReceiverImpl> _impl;
@@ -7,8 +7,18 @@ namespace messaging {
 namespace ipc {
 namespace local {
 
-LocalIPCBufferSender::LocalIPCBufferSender() {
-  _pImpl = std::make_unique<LocalIPCBufferSenderImpl>();
+LocalIPCBufferSender::LocalIPCBufferSender(ConnectionMode mode,
+                                           size_t sharedPayloadThreshold,
+                                           BatchLimits batchLimits,
+                                           LivenessOptions liveness) {
+  using Mode = LocalIPCBufferSenderImpl::Mode;
+  auto implMode = mode == ConnectionMode::OneShot   ? Mode::OneShot
+                  : mode == ConnectionMode::Batched ? Mode::Batched
+                                                    : Mode::Persistent;
+  _pImpl = std::make_unique<LocalIPCBufferSenderImpl>(
+      implMode, sharedPayloadThreshold, batchLimits.maxDelay,
+      batchLimits.maxBytes, liveness.retryInterval,
+      liveness.heartbeatInterval);
 }
 
 LocalIPCBufferSender::~LocalIPCBufferSender() {}
@@ -23,6 +33,17 @@ Availability LocalIPCBufferSender::checkReceiverStatus(
   return _pImpl->checkReceiverStatus(destination);
 }
 
+bool LocalIPCBufferSender::watchReceiver(const Address &destination,
+                                         ReceiverStatusCallback callback) {
+  return _pImpl->watchReceiver(destination, std::move(callback));
+}
+
+TransferStats LocalIPCBufferSender::stats() const {
+  auto &counters = _pImpl->counters();
+  return {counters.messages.load(), counters.syscalls.load(),
+          counters.bytes.load()};
+}
+
 }  // namespace local
 }  // namespace ipc
 }  // namespace messaging
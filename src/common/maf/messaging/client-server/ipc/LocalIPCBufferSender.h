@@ -3,6 +3,7 @@
 #include <memory>
 
 #include "BufferSenderIF.h"
+#include "IPCTypes.h"
 
 namespace maf {
 namespace messaging {
@@ -13,11 +14,17 @@ class NamedPipeSender;
 
 class LocalIPCBufferSender : public maf::messaging::ipc::BufferSenderIF {
  public:
-  LocalIPCBufferSender();
+  LocalIPCBufferSender(
+      ConnectionMode mode = ConnectionMode::Persistent,
+      size_t sharedPayloadThreshold = DefaultSharedPayloadThreshold,
+      BatchLimits batchLimits = {}, LivenessOptions liveness = {});
   ~LocalIPCBufferSender() override;
   ActionCallStatus send(const maf::srz::Buffer &ba,
                         const Address &destination) override;
   Availability checkReceiverStatus(const Address &destination) const override;
+  bool watchReceiver(const Address &destination,
+                     ReceiverStatusCallback callback) override;
+  TransferStats stats() const;
 
  private:
   std::unique_ptr<class LocalIPCBufferSenderImpl> _pImpl;
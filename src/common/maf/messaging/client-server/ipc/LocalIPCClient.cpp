@@ -5,7 +5,7 @@
 
 #include <cassert>
 
-#include "../SingleThreadPool.h"
+#include "../ShardedThreadPool.h"
 #include "BufferSenderIF.h"
 #include "LocalIPCBufferReceiver.h"
 #include "LocalIPCBufferSender.h"
@@ -17,8 +17,14 @@ namespace ipc {
 namespace local {
 
 LocalIPCClient::LocalIPCClient()
-    : pSender_{new local::LocalIPCBufferSender},
-      pReceiver_{new LocalIPCBufferReceiver} {}
+    : LocalIPCClient(std::make_unique<LocalIPCBufferSender>(),
+                     std::make_unique<LocalIPCBufferReceiver>()) {}
+
+LocalIPCClient::LocalIPCClient(std::unique_ptr<BufferSenderIF> sender,
+                               std::unique_ptr<BufferReceiverIF> receiver)
+    : pSender_{std::move(sender)}, pReceiver_{std::move(receiver)} {
+  serverMonitorTimer_.setSlack(std::chrono::milliseconds{serverMonitorSlack});
+}
 
 bool LocalIPCClient::init(const Address &serverAddress) {
   assert(serverAddress.valid());
@@ -36,11 +42,25 @@ bool LocalIPCClient::init(const Address &serverAddress) {
 
 bool LocalIPCClient::start() {
   receiverThread_ = std::thread{[this] { pReceiver_->start(); }};
-  single_threadpool::submit([this] { monitorServerStatus(); });
+  // The sender tells when the connection to the server comes and goes,
+  // polling is left for senders which cannot. Its watching thread serves
+  // every destination, the messages sent on a change go from the pool,
+  // keyed by the server so that the changes stay in order
+  auto key = sharded_threadpool::shardKeyOf(myServerAddress_);
+  if (!pSender_->watchReceiver(myServerAddress_, [this,
+                                                  key](Availability status) {
+        if (!sharded_threadpool::submit(
+                key, [this, status] { updateServerStatus(status); })) {
+          updateServerStatus(status);
+        }
+      })) {
+    sharded_threadpool::submit([this] { monitorServerStatus(); });
+  }
   return true;
 }
 
 void LocalIPCClient::stop() {
+  pSender_->watchReceiver(myServerAddress_, {});
   pReceiver_->stop();
   serverMonitorTimer_.stop();
   if (receiverThread_.joinable()) {
@@ -55,10 +75,13 @@ LocalIPCClient::~LocalIPCClient() { deinit(); }
 ActionCallStatus LocalIPCClient::sendMessageToServer(const CSMessagePtr &msg) {
   assert(msg != nullptr);
   try {
+    auto ipcMsg = std::static_pointer_cast<LocalIPCMessage>(msg);
+    if (auto session = session_.load(); session != SessionHandleInvalid) {
+      return pSender_->send(ipcMsg->toBytes(HeaderVersion::Compact, session),
+                            myServerAddress_);
+    }
     msg->setSourceAddress(pReceiver_->address());
-    return pSender_->send(
-        std::static_pointer_cast<LocalIPCMessage>(msg)->toBytes(),
-        myServerAddress_);
+    return pSender_->send(ipcMsg->toBytes(), myServerAddress_);
   } catch (const std::bad_alloc &e) {
     MAF_LOGGER_ERROR("Message is too large to be serialized: ", e.what());
     return ActionCallStatus::FailedUnknown;
@@ -67,8 +90,26 @@ ActionCallStatus LocalIPCClient::sendMessageToServer(const CSMessagePtr &msg) {
 
 void LocalIPCClient::onServerStatusChanged(Availability oldStatus,
                                            Availability newStatus) noexcept {
-  ClientBase::onServerStatusChanged(oldStatus, newStatus);
-  if (newStatus == Availability::Available) {
+  if (newStatus != Availability::Available) {
+    // A restarted server knows nothing of the session
+    session_ = SessionHandleInvalid;
+    // Deliver on each service's dispatching thread, after the messages of
+    // that service which are already queued there
+    _serviceStatusMap.atomic()->clear();
+    std::lock_guard lock(_requestersMap);
+    for (auto &[sid, requester] : *_requestersMap) {
+      sharded_threadpool::submit(
+          sharded_threadpool::shardKeyOf(sid),
+          [sid = sid, requester = requester, oldStatus, newStatus] {
+            requester->onServiceStatusChanged(sid, oldStatus, newStatus);
+          });
+    }
+  } else {
+    // Older servers ignore it and keep getting the full header
+    auto negotiateMsg = messaging::createCSMessage<LocalIPCMessage>(
+        ServiceIDInvalid, OpIDInvalid, OpCode::NegotiateHeader,
+        static_cast<RequestID>(HeaderVersion::Compact));
+    sendMessageToServer(negotiateMsg);
     auto registeredMsg = messaging::createCSMessage<LocalIPCMessage>(
         ServiceIDInvalid, OpIDInvalid, OpCode::RegisterServiceStatus);
     if (sendMessageToServer(registeredMsg) == ActionCallStatus::Success) {
@@ -85,9 +126,7 @@ void LocalIPCClient::monitorServerStatus(long long tunedInterval) {
   if (auto newStatus = pSender_->checkReceiverStatus(myServerAddress_);
       currentServerStatus_ != newStatus) {
     tunedInterval = serverMonitorInterval;
-    this->onServerStatusChanged(currentServerStatus_, newStatus);
-    currentServerStatus_ = newStatus;
-
+    updateServerStatus(newStatus);
   } else if (tunedInterval < serverMonitorInterval) {
     tunedInterval += 5;
   }
@@ -96,16 +135,42 @@ void LocalIPCClient::monitorServerStatus(long long tunedInterval) {
   });
 }
 
+void LocalIPCClient::updateServerStatus(Availability newStatus) {
+  if (currentServerStatus_ != newStatus) {
+    this->onServerStatusChanged(currentServerStatus_, newStatus);
+    currentServerStatus_ = newStatus;
+  }
+}
+
 void LocalIPCClient::onBytesCome(srz::Buffer &&buff) {
-  single_threadpool::submit([this, buff = std::move(buff)]() mutable {
-    std::shared_ptr<LocalIPCMessage> csMsg =
-        std::make_shared<LocalIPCMessage>();
-    if (csMsg->fromBytes(std::move(buff))) {
-      onIncomingMessage(csMsg);
-    } else {
-      MAF_LOGGER_ERROR("incoming message is not wellformed");
+  auto csMsg = std::make_shared<LocalIPCMessage>();
+  if (csMsg->fromBytes(std::move(buff))) {
+    onMessageCome(std::move(csMsg));
+  } else {
+    MAF_LOGGER_ERROR("incoming message is not wellformed");
+  }
+}
+
+void LocalIPCClient::onSharedBytesCome(srz::SharedBytes &&bytes) {
+  auto csMsg = std::make_shared<LocalIPCMessage>();
+  if (csMsg->fromBytes(std::move(bytes))) {
+    onMessageCome(std::move(csMsg));
+  } else {
+    MAF_LOGGER_ERROR("incoming message is not wellformed");
+  }
+}
+
+void LocalIPCClient::onMessageCome(std::shared_ptr<LocalIPCMessage> csMsg) {
+  if (csMsg->operationCode() == OpCode::NegotiateHeader) {
+    if (csMsg->headerVersion() == HeaderVersion::Compact) {
+      session_ = csMsg->session();
     }
-  });
+    return;
+  }
+  // Only the header is decoded here, messages of one service stay in order
+  auto key = sharded_threadpool::shardKeyOf(csMsg->serviceID());
+  sharded_threadpool::submit(
+      key, [this, csMsg = std::move(csMsg)] { onIncomingMessage(csMsg); });
 }
 
 }  // namespace local
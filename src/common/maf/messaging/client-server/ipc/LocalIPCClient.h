@@ -2,12 +2,14 @@
 
 #include <maf/messaging/Timer.h>
 
+#include <atomic>
 #include <future>
 #include <thread>
 
 #include "../ClientBase.h"
 #include "BufferReceiverIF.h"
 #include "IPCTypes.h"
+#include "LocalIPCMessage.h"
 
 namespace maf {
 namespace messaging {
@@ -21,6 +23,8 @@ namespace local {
 class LocalIPCClient : public ClientBase, public BytesComeObserver {
  public:
   LocalIPCClient();
+  LocalIPCClient(std::unique_ptr<BufferSenderIF> sender,
+                 std::unique_ptr<BufferReceiverIF> receiver);
   ~LocalIPCClient() override;
 
   bool init(const Address &serverAddress) override;
@@ -35,7 +39,10 @@ class LocalIPCClient : public ClientBase, public BytesComeObserver {
 
  protected:
   void monitorServerStatus(long long intervalMs = 0);
+  void updateServerStatus(Availability newStatus);
   void onBytesCome(srz::Buffer &&buff) override;
+  void onSharedBytesCome(srz::SharedBytes &&bytes) override;
+  void onMessageCome(std::shared_ptr<LocalIPCMessage> csMsg);
 
   Address myServerAddress_;
 
@@ -46,7 +53,11 @@ class LocalIPCClient : public ClientBase, public BytesComeObserver {
   std::unique_ptr<BufferReceiverIF> pReceiver_;
 
   Availability currentServerStatus_ = Availability::Unavailable;
+  // Given by the server along with the compact header, sent in place of the
+  // receiver address
+  std::atomic<SessionHandle> session_ = SessionHandleInvalid;
   int serverMonitorInterval = 500;
+  int serverMonitorSlack = 50;
 };
 
 }  // namespace local
@@ -8,6 +8,9 @@
 #include <maf/utils/serialization/OByteStream.h>
 #include <maf/utils/serialization/Serializer.h>
 
+#include <cstring>
+#include <limits>
+
 namespace maf {
 namespace messaging {
 namespace ipc {
@@ -16,7 +19,6 @@ namespace local {
 using namespace maf::srz;
 
 using Serializer = SR<OByteStream>;
-using Deserializer = DSR<IByteStream>;
 static const Buffer &emptyBytes() {
   static Buffer empty;
   return empty;
@@ -29,6 +31,7 @@ static Serializer &encodeAsError(Serializer &sr,
   return sr << error->description() << error->code();
 }
 
+template <class Deserializer>
 static std::shared_ptr<CSError> decodeAsError(Deserializer &ds) {
   auto desc = std::string{};
   auto code = CSError::ErrorCode::Unknown;
@@ -36,23 +39,139 @@ static std::shared_ptr<CSError> decodeAsError(Deserializer &ds) {
   return std::shared_ptr<CSError>{new CSError{std::move(desc), code}};
 }
 
-srz::Buffer LocalIPCMessage::toBytes() noexcept {
+static Serializer &encodeFilters(Serializer &sr,
+                                 const SubscriptionFilters &filters) {
+  sr << static_cast<uint32_t>(filters.size());
+  for (const auto &filter : filters) {
+    sr.serializeBatch(filter.kind, filter.field, filter.low, filter.high);
+  }
+  return sr;
+}
+
+template <class Deserializer>
+static SubscriptionFilters decodeFilters(Deserializer &ds) {
+  uint32_t count = 0;
+  ds >> count;
+  SubscriptionFilters filters;
+  for (uint32_t i = 0; i < count; ++i) {
+    SubscriptionFilter filter;
+    ds >> filter.kind >> filter.field >> filter.low >> filter.high;
+    if (filter.kind > SubscriptionFilter::Kind::EveryNth) {
+      throw std::runtime_error("Unknown subscription filter");
+    }
+    filters.push_back(filter);
+  }
+  return filters;
+}
+
+// Starts every compact header. A full header starts with the size of the
+// service ID, which is never anywhere near this
+static constexpr char CompactMagic[4] = {'\xfe', 'M', 'A', 'F'};
+
+struct CompactHeader {
+  char magic[sizeof(CompactMagic)];
+  HeaderVersion version;
+  OpCode opCode;
+  ContentType contentType;
+  uint8_t reserved;
+  OpID::Hash serviceID;
+  OpID::Hash operationID;
+};
+static_assert(sizeof(CompactHeader) == 24, "Compact header must not be padded");
+
+static void writeVarint(OByteStream &os, uint64_t value) {
+  char bytes[10];
+  size_t count = 0;
+  do {
+    bytes[count] = static_cast<char>(value & 0x7f);
+    value >>= 7;
+    if (value != 0) {
+      bytes[count] |= static_cast<char>(0x80);
+    }
+    ++count;
+  } while (value != 0);
+  os.write(bytes, count);
+}
+
+// Laid out as a serialized std::string, the full header stays readable by
+// peers from before the IDs were interned. An ID known only by its hash has
+// no name to send, its peer talks the compact header anyway
+static void writeName(OByteStream &os, const InternedID &id) {
+  auto name = id.name();
+  auto size = static_cast<SizeType>(name.size());
+  os.write(reinterpret_cast<const char *>(&size), sizeof(size));
+  os.write(name.data(), name.size());
+}
+
+static bool readExactly(IByteStreamView &is, char *buf, size_t size) {
+  auto pos = is.readingPos();
+  is.read(buf, size);
+  return is.readingPos() == pos + size;
+}
+
+static bool readVarint(IByteStreamView &is, uint64_t &value) {
+  value = 0;
+  for (unsigned shift = 0; shift < 64; shift += 7) {
+    char byte;
+    if (!readExactly(is, &byte, 1)) {
+      return false;
+    }
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+srz::Buffer LocalIPCMessage::toBytes(HeaderVersion version,
+                                     SessionHandle session) noexcept {
   srz::OByteStream oss;
   Serializer sr(oss);
 
-  sr.serializeBatch(serviceID(), operationID(), operationCode(), requestID(),
-                    sourceAddress(),
-                    (payload_ ? payload_->type() : ContentType::NA));
+  auto contentType = payload_ ? payload_->type() : ContentType::NA;
+  // Only peers with the compact header keep the previous status to patch
+  auto changesOnly =
+      version == HeaderVersion::Compact &&
+      contentType == ContentType::OutgoingData &&
+      static_cast<OutgoingPayload *>(payload_.get())->hasChanges();
+  if (changesOnly) {
+    contentType = ContentType::Changes;
+  } else if (!payload_ && !subscriptionFilters_.empty()) {
+    contentType = ContentType::Filters;
+  }
+  if (version == HeaderVersion::Compact) {
+    CompactHeader header{};
+    memcpy(header.magic, CompactMagic, sizeof(header.magic));
+    header.version = version;
+    header.opCode = operationCode();
+    header.contentType = contentType;
+    header.serviceID = serviceID().hash();
+    header.operationID = operationID().hash();
+    oss.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    // RequestIDInvalid wraps to 0 and takes a single byte
+    writeVarint(oss, requestID() + 1);
+    writeVarint(oss, session);
+  } else {
+    writeName(oss, serviceID());
+    writeName(oss, operationID());
+    sr.serializeBatch(operationCode(), requestID(), sourceAddress(),
+                      contentType);
+  }
 
   if (payload_) {
     if (payload_->type() == ContentType::Error) {
       encodeAsError(sr, payload_);
+    } else if (changesOnly) {
+      static_cast<OutgoingPayload *>(payload_.get())->serializeChanges(oss);
     } else if (payload_->type() != ContentType::NA) {
       auto ipcContent = static_cast<OutgoingPayload *>(payload_.get());
       ipcContent->serialize(oss);
     } else {
       sr << emptyBytes();
     }
+  } else if (contentType == ContentType::Filters) {
+    encodeFilters(sr, subscriptionFilters_);
   } else {
     sr << emptyBytes();
   }
@@ -61,17 +180,41 @@ srz::Buffer LocalIPCMessage::toBytes() noexcept {
 }
 
 bool LocalIPCMessage::fromBytes(Buffer &&bytes) noexcept {
+  auto iss = std::make_shared<IByteStream>(std::move(bytes));
+  return decode(IByteStreamView{*iss}, iss);
+}
+
+bool LocalIPCMessage::fromBytes(SharedBytes &&bytes) noexcept {
+  return decode(IByteStreamView{bytes.bytes}, std::move(bytes.owner));
+}
+
+bool LocalIPCMessage::decode(IByteStreamView is,
+                             std::shared_ptr<const void> bytesOwner) noexcept {
   using namespace std;
-  auto iss = make_shared<IByteStream>(std::move(bytes));
-  Deserializer ds(*iss);
+  DSR<IByteStreamView> ds(is);
   try {
     ContentType contentType = ContentType::NA;
-    ds >> serviceID_ >> operationID_ >> operationCode_ >> requestID_ >>
-        sourceAddress_ >> contentType;
+    if (auto start = is; !decodeCompactHeader(is, contentType)) {
+      is = start;
+      std::string serviceName;
+      std::string operationName;
+      ds >> serviceName >> operationName >> operationCode_ >> requestID_ >>
+          sourceAddress_ >> contentType;
+      serviceID_ = ServiceID{serviceName};
+      operationID_ = OpID{operationName};
+      headerVersion_ = HeaderVersion::Full;
+      session_ = SessionHandleInvalid;
+    }
+    subscriptionFilters_.clear();
     if (contentType == ContentType::Error) {
       setPayload(decodeAsError(ds));
+    } else if (contentType == ContentType::Filters) {
+      setPayload({});
+      subscriptionFilters_ = decodeFilters(ds);
     } else {
-      setPayload(make_shared<IncomingPayload>(std::move(iss)));
+      // The view is taken after the header, where the payload starts
+      setPayload(make_shared<IncomingPayload>(
+          std::move(bytesOwner), is, contentType == ContentType::Changes));
     }
     return true;
   } catch (const exception &e) {
@@ -83,6 +226,33 @@ bool LocalIPCMessage::fromBytes(Buffer &&bytes) noexcept {
   return false;
 }
 
+bool LocalIPCMessage::decodeCompactHeader(IByteStreamView &is,
+                                          ContentType &contentType) {
+  CompactHeader header;
+  uint64_t requestID = 0;
+  uint64_t session = 0;
+  if (!readExactly(is, reinterpret_cast<char *>(&header), sizeof(header)) ||
+      memcmp(header.magic, CompactMagic, sizeof(header.magic)) != 0 ||
+      header.version != HeaderVersion::Compact ||
+      static_cast<unsigned char>(header.opCode) >=
+          static_cast<unsigned char>(OpCode::Invalid) ||
+      static_cast<unsigned char>(header.contentType) >
+          static_cast<unsigned char>(ContentType::Filters) ||
+      !readVarint(is, requestID) || !readVarint(is, session) ||
+      session > std::numeric_limits<SessionHandle>::max()) {
+    return false;
+  }
+  serviceID_ = ServiceID::fromHash(header.serviceID);
+  operationID_ = OpID::fromHash(header.operationID);
+  operationCode_ = header.opCode;
+  requestID_ = requestID - 1;
+  sourceAddress_ = {};
+  headerVersion_ = HeaderVersion::Compact;
+  session_ = static_cast<SessionHandle>(session);
+  contentType = header.contentType;
+  return true;
+}
+
 }  // namespace local
 }  // namespace ipc
 }  // namespace messaging
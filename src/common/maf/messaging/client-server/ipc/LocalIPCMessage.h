@@ -2,17 +2,44 @@
 
 #include <maf/messaging/client-server/CSMessage.h>
 #include <maf/utils/serialization/Buffer.h>
+#include <maf/utils/serialization/IByteStream.h>
 
 namespace maf {
 namespace messaging {
 namespace ipc {
 namespace local {
 
+//! Full writes every header field through the serializer, the IDs by name
+//! and the source address included, as every version of the library does.
+//! Compact is a fixed-size struct with the ID hashes followed by varints, a
+//! session handle given by the receiver stands for the source address. A
+//! peer gets Compact only once it asked for it with OpCode::NegotiateHeader
+enum class HeaderVersion : uint8_t { Full, Compact };
+
+using SessionHandle = uint32_t;
+inline constexpr SessionHandle SessionHandleInvalid = 0;
+
 class LocalIPCMessage : public CSMessage {
  public:
   using CSMessage::CSMessage;
-  srz::Buffer toBytes() noexcept;
+  srz::Buffer toBytes(HeaderVersion version = HeaderVersion::Full,
+                      SessionHandle session = SessionHandleInvalid) noexcept;
   bool fromBytes(srz::Buffer &&bytes) noexcept;
+  //! The payload keeps reading the shared bytes, they are not copied
+  bool fromBytes(srz::SharedBytes &&bytes) noexcept;
+
+  //! Header the message came with and the session handle it carried
+  HeaderVersion headerVersion() const noexcept { return headerVersion_; }
+  SessionHandle session() const noexcept { return session_; }
+
+ private:
+  bool decode(srz::IByteStreamView is,
+              std::shared_ptr<const void> bytesOwner) noexcept;
+  bool decodeCompactHeader(srz::IByteStreamView &is,
+                           CSPayloadType &contentType);
+
+  HeaderVersion headerVersion_ = HeaderVersion::Full;
+  SessionHandle session_ = SessionHandleInvalid;
 };
 
 }  // namespace local
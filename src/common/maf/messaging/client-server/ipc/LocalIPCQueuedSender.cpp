@@ -0,0 +1,57 @@
+#include "LocalIPCQueuedSender.h"
+
+#include <maf/messaging/client-server/ipc/LocalIPCQueuedSenderImpl.h>
+
+namespace maf {
+namespace messaging {
+namespace ipc {
+namespace local {
+
+LocalIPCQueuedSender::LocalIPCQueuedSender(SlowReceiverPolicy policy,
+                                           size_t maxQueued,
+                                           size_t sharedPayloadThreshold) {
+  using Policy = LocalIPCQueuedSenderImpl::Policy;
+  auto implPolicy = policy == SlowReceiverPolicy::DropOldest
+                        ? Policy::DropOldest
+                    : policy == SlowReceiverPolicy::DropClient
+                        ? Policy::DropClient
+                        : Policy::Block;
+  _pImpl = std::make_unique<LocalIPCQueuedSenderImpl>(implPolicy, maxQueued,
+                                                      sharedPayloadThreshold);
+}
+
+LocalIPCQueuedSender::~LocalIPCQueuedSender() {}
+
+ActionCallStatus LocalIPCQueuedSender::send(const srz::Buffer &ba,
+                                            const Address &destination) {
+  return _pImpl->send(std::make_shared<const srz::Buffer>(ba), destination);
+}
+
+ActionCallStatus LocalIPCQueuedSender::sendShared(
+    const std::shared_ptr<const srz::Buffer> &ba, const Address &destination) {
+  return _pImpl->send(ba, destination);
+}
+
+Availability LocalIPCQueuedSender::checkReceiverStatus(
+    const Address &destination) const {
+  return _pImpl->checkReceiverStatus(destination);
+}
+
+void LocalIPCQueuedSender::setReceiverGoneCallback(
+    ReceiverGoneCallback callback) {
+  _pImpl->setReceiverGoneCallback(std::move(callback));
+}
+
+std::map<Address, SendQueueStats> LocalIPCQueuedSender::queueStats() const {
+  std::map<Address, SendQueueStats> stats;
+  for (auto &[address, counters] : _pImpl->queueCounters()) {
+    stats[address] = {counters.depth, counters.maxDepth, counters.sent,
+                      counters.dropped};
+  }
+  return stats;
+}
+
+}  // namespace local
+}  // namespace ipc
+}  // namespace messaging
+}  // namespace maf
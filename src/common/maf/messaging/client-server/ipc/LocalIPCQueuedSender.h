@@ -0,0 +1,38 @@
+#pragma once
+
+#include <map>
+#include <memory>
+
+#include "BufferSenderIF.h"
+#include "IPCTypes.h"
+
+namespace maf {
+namespace messaging {
+namespace ipc {
+namespace local {
+
+//! Queues the messages per destination and returns, an I/O thread writes
+//! them. A receiver that does not read fills only its own queue
+class LocalIPCQueuedSender : public maf::messaging::ipc::BufferSenderIF {
+ public:
+  LocalIPCQueuedSender(
+      SlowReceiverPolicy policy = SlowReceiverPolicy::Block,
+      size_t maxQueued = DefaultSendQueueLimit,
+      size_t sharedPayloadThreshold = DefaultSharedPayloadThreshold);
+  ~LocalIPCQueuedSender() override;
+  ActionCallStatus send(const maf::srz::Buffer &ba,
+                        const Address &destination) override;
+  ActionCallStatus sendShared(const std::shared_ptr<const srz::Buffer> &ba,
+                              const Address &destination) override;
+  Availability checkReceiverStatus(const Address &destination) const override;
+  void setReceiverGoneCallback(ReceiverGoneCallback callback) override;
+  std::map<Address, SendQueueStats> queueStats() const;
+
+ private:
+  std::unique_ptr<class LocalIPCQueuedSenderImpl> _pImpl;
+};
+
+}  // namespace local
+}  // namespace ipc
+}  // namespace messaging
+}  // namespace maf
@@ -4,26 +4,48 @@
 #include <maf/messaging/client-server/ServiceProviderIF.h>
 
 #include <cassert>
+#include <random>
 
-#include "../SingleThreadPool.h"
+#include "../ShardedThreadPool.h"
 #include "LocalIPCBufferReceiver.h"
-#include "LocalIPCBufferSender.h"
 #include "LocalIPCMessage.h"
+#include "LocalIPCQueuedSender.h"
 
 namespace maf {
 namespace messaging {
 namespace ipc {
 namespace local {
 
+// A client that does not read must not hold up the stubs and other clients
 LocalIPCServer::LocalIPCServer()
-    : pSender_{new LocalIPCBufferSender},
-      pReceiver_{new LocalIPCBufferReceiver} {}
+    : LocalIPCServer(std::make_unique<LocalIPCQueuedSender>(),
+                     std::make_unique<LocalIPCBufferReceiver>()) {}
+
+LocalIPCServer::LocalIPCServer(std::unique_ptr<BufferSenderIF> sender,
+                               std::unique_ptr<BufferReceiverIF> receiver)
+    : pSender_{std::move(sender)}, pReceiver_{std::move(receiver)} {
+  // Handles start anywhere, a stale one from before a restart should not
+  // name another client
+  sessions_->last = std::random_device{}();
+}
 
 LocalIPCServer::~LocalIPCServer() = default;
 
 bool LocalIPCServer::init(const Address &serverAddress) {
   if (pReceiver_->init(serverAddress)) {
     pReceiver_->setObserver(this);
+    // Handled on the client's dispatching thread, the sender's thread must
+    // not wait for the locks held around sending
+    pSender_->setReceiverGoneCallback([thisw = weak_from_this()](
+                                          const Address &clAddr) {
+      sharded_threadpool::submit(
+          sharded_threadpool::shardKeyOf(clAddr), [thisw, clAddr] {
+            if (auto this_ = thisw.lock()) {
+              std::static_pointer_cast<LocalIPCServer>(this_)->onClientGone(
+                  clAddr);
+            }
+          });
+    });
     return true;
   }
   return false;
@@ -50,8 +72,11 @@ ActionCallStatus LocalIPCServer::sendMessageToClient(const CSMessagePtr &msg,
   assert(msg != nullptr);
   if (pSender_) {
     try {
-      return pSender_->send(
-          std::static_pointer_cast<LocalIPCMessage>(msg)->toBytes(), addr);
+      return pSender_->sendShared(
+          std::make_shared<const srz::Buffer>(
+              std::static_pointer_cast<LocalIPCMessage>(msg)->toBytes(
+                  headerVersionOf(addr))),
+          addr);
     } catch (const std::bad_alloc &e) {
       MAF_LOGGER_ERROR("Message is too large to be serialized: ", e.what());
       return ActionCallStatus::FailedUnknown;
@@ -64,6 +89,31 @@ ActionCallStatus LocalIPCServer::sendMessageToClient(const CSMessagePtr &msg,
   }
 }
 
+std::vector<ActionCallStatus> LocalIPCServer::sendMessageToClients(
+    const CSMessagePtr &msg, const std::vector<Address> &addrs) {
+  assert(msg != nullptr);
+  auto ipcMsg = std::static_pointer_cast<LocalIPCMessage>(msg);
+  std::vector<ActionCallStatus> results;
+  results.reserve(addrs.size());
+  // Every client gets the same bytes, serialized once per header version
+  std::shared_ptr<const srz::Buffer> full;
+  std::shared_ptr<const srz::Buffer> compact;
+  try {
+    for (const auto &addr : addrs) {
+      auto version = headerVersionOf(addr);
+      auto &bytes = version == HeaderVersion::Compact ? compact : full;
+      if (!bytes) {
+        bytes = std::make_shared<const srz::Buffer>(ipcMsg->toBytes(version));
+      }
+      results.push_back(pSender_->sendShared(bytes, addr));
+    }
+  } catch (const std::bad_alloc &e) {
+    MAF_LOGGER_ERROR("Message is too large to be serialized: ", e.what());
+    results.resize(addrs.size(), ActionCallStatus::FailedUnknown);
+  }
+  return results;
+}
+
 void LocalIPCServer::notifyServiceStatusToClient(const ServiceID &sid,
                                                  Availability oldStatus,
                                                  Availability newStatus) {
@@ -75,15 +125,15 @@ void LocalIPCServer::notifyServiceStatusToClient(const ServiceID &sid,
         OpCode::ServiceStatusUpdate);
 
     std::lock_guard lock(registedClAddrs_);
-    for (auto itAddr = registedClAddrs_->begin();
-         itAddr != registedClAddrs_->end();) {
-      auto ec = sendMessageToClient(serviceStatusMsg, *itAddr);
-      if ((ec == ActionCallStatus::ReceiverUnavailable) ||
-          (ec == ActionCallStatus::FailedUnknown)) {
+    std::vector<Address> addrs{registedClAddrs_->begin(),
+                               registedClAddrs_->end()};
+    auto results = sendMessageToClients(serviceStatusMsg, addrs);
+    for (size_t i = 0; i < addrs.size(); ++i) {
+      if ((results[i] == ActionCallStatus::ReceiverUnavailable) ||
+          (results[i] == ActionCallStatus::FailedUnknown)) {
         // Client has been off, then don't keep their contact anymore
-        itAddr = registedClAddrs_->erase(itAddr);
-      } else {
-        ++itAddr;
+        registedClAddrs_->erase(addrs[i]);
+        closeSession(addrs[i]);
       }
     }
   }
@@ -108,15 +158,33 @@ bool LocalIPCServer::onIncomingMessage(const CSMessagePtr &csMsg) {
     case OpCode::UnregisterServiceStatus:
       if (csMsg->serviceID() == ServiceIDInvalid) {
         registedClAddrs_.atomic()->erase(csMsg->sourceAddress());
-        std::lock_guard lock(providers_);
-        for (auto &[sid, provider] : *providers_) {
-          csMsg->setServiceID(sid);
-          provider->onIncomingMessage(csMsg);
+        {
+          std::lock_guard lock(providers_);
+          for (auto &[sid, provider] : *providers_) {
+            csMsg->setServiceID(sid);
+            provider->onIncomingMessage(csMsg);
+          }
         }
+        closeSession(csMsg->sourceAddress());
         return true;
       } else {
         break;
       }
+
+    case OpCode::NegotiateHeader:
+      // The request ID tells the newest header the client reads. The reply
+      // already comes with the compact one and carries the handle the
+      // client sends instead of its address
+      if (csMsg->requestID() >=
+          static_cast<RequestID>(HeaderVersion::Compact)) {
+        auto reply = createCSMessage<LocalIPCMessage>(
+            ServiceIDInvalid, OpIDInvalid, OpCode::NegotiateHeader);
+        auto session = openSession(csMsg->sourceAddress());
+        pSender_->send(reply->toBytes(HeaderVersion::Compact, session),
+                       csMsg->sourceAddress());
+      }
+      return true;
+
     default:
       break;
   }
@@ -125,17 +193,42 @@ bool LocalIPCServer::onIncomingMessage(const CSMessagePtr &csMsg) {
 }
 
 void LocalIPCServer::onBytesCome(srz::Buffer &&buff) {
-  single_threadpool::submit(
-      [thisw = weak_from_this(), buff = std::move(buff)]() mutable {
+  auto csMsg = std::make_shared<LocalIPCMessage>();
+  if (csMsg->fromBytes(std::move(buff))) {
+    onMessageCome(std::move(csMsg));
+  } else {
+    MAF_LOGGER_ERROR("incoming message is not wellformed");
+  }
+}
+
+void LocalIPCServer::onSharedBytesCome(srz::SharedBytes &&bytes) {
+  auto csMsg = std::make_shared<LocalIPCMessage>();
+  if (csMsg->fromBytes(std::move(bytes))) {
+    onMessageCome(std::move(csMsg));
+  } else {
+    MAF_LOGGER_ERROR("incoming message is not wellformed");
+  }
+}
+
+void LocalIPCServer::onMessageCome(std::shared_ptr<LocalIPCMessage> csMsg) {
+  if (csMsg->headerVersion() == HeaderVersion::Compact) {
+    std::lock_guard lock(sessions_);
+    auto it = sessions_->addresses.find(csMsg->session());
+    if (it == sessions_->addresses.end()) {
+      MAF_LOGGER_ERROR("Dropped message from unknown session ",
+                       csMsg->session());
+      return;
+    }
+    csMsg->setSourceAddress(it->second);
+  }
+  // Only the header is decoded here, the payload is decoded on the
+  // dispatching thread. Messages of one client stay in order
+  auto key = sharded_threadpool::shardKeyOf(csMsg->sourceAddress());
+  sharded_threadpool::submit(
+      key, [thisw = weak_from_this(), csMsg = std::move(csMsg)] {
         if (auto this_ = thisw.lock()) {
-          std::shared_ptr<LocalIPCMessage> csMsg =
-              std::make_shared<LocalIPCMessage>();
-          if (csMsg->fromBytes(std::move(buff))) {
-            std::static_pointer_cast<LocalIPCServer>(this_)->onIncomingMessage(
-                csMsg);
-          } else {
-            MAF_LOGGER_ERROR("incoming message is not wellformed");
-          }
+          std::static_pointer_cast<LocalIPCServer>(this_)->onIncomingMessage(
+              csMsg);
         }
       });
 }
@@ -160,6 +253,44 @@ void LocalIPCServer::notifyServiceStatusToClient(const Address &clAddr,
   }
 }
 
+SessionHandle LocalIPCServer::openSession(const Address &clAddr) {
+  std::lock_guard lock(sessions_);
+  auto &handle = sessions_->handles[clAddr];
+  if (handle == SessionHandleInvalid) {
+    do {
+      handle = ++sessions_->last;
+    } while (handle == SessionHandleInvalid ||
+             sessions_->addresses.count(handle) != 0);
+    sessions_->addresses.emplace(handle, clAddr);
+  }
+  return handle;
+}
+
+bool LocalIPCServer::closeSession(const Address &clAddr) {
+  std::lock_guard lock(sessions_);
+  if (auto it = sessions_->handles.find(clAddr);
+      it != sessions_->handles.end()) {
+    sessions_->addresses.erase(it->second);
+    sessions_->handles.erase(it);
+    return true;
+  }
+  return false;
+}
+
+// Only a client with a session keeps its connection open, one from before
+// the sessions hangs up after each message and stays registered
+void LocalIPCServer::onClientGone(const Address &clAddr) {
+  if (closeSession(clAddr)) {
+    registedClAddrs_.atomic()->erase(clAddr);
+  }
+}
+
+HeaderVersion LocalIPCServer::headerVersionOf(const Address &clAddr) {
+  return sessions_.atomic()->handles.count(clAddr) != 0
+             ? HeaderVersion::Compact
+             : HeaderVersion::Full;
+}
+
 }  // namespace local
 }  // namespace ipc
 }  // namespace messaging
@@ -1,11 +1,13 @@
 #pragma once
 
+#include <map>
 #include <set>
 #include <thread>
 
 #include "../ServerBase.h"
 #include "BufferReceiverIF.h"
 #include "IPCTypes.h"
+#include "LocalIPCMessage.h"
 
 namespace maf {
 namespace messaging {
@@ -19,6 +21,8 @@ namespace local {
 class LocalIPCServer : public ServerBase, public BytesComeObserver {
  public:
   LocalIPCServer();
+  LocalIPCServer(std::unique_ptr<BufferSenderIF> sender,
+                 std::unique_ptr<BufferReceiverIF> receiver);
   ~LocalIPCServer() override;
   bool init(const Address &serverAddress) override;
   bool start() override;
@@ -27,17 +31,33 @@ class LocalIPCServer : public ServerBase, public BytesComeObserver {
 
   ActionCallStatus sendMessageToClient(const CSMessagePtr &msg,
                                        const Address &addr) override;
+  std::vector<ActionCallStatus> sendMessageToClients(
+      const CSMessagePtr &msg, const std::vector<Address> &addrs) override;
   void notifyServiceStatusToClient(const ServiceID &sid, Availability oldStatus,
                                    Availability newStatus) override;
   bool onIncomingMessage(const CSMessagePtr &csMsg) override;
 
  protected:
   void onBytesCome(srz::Buffer &&buff) override;
+  void onSharedBytesCome(srz::SharedBytes &&bytes) override;
+  void onMessageCome(std::shared_ptr<LocalIPCMessage> csMsg);
   void notifyServiceStatusToClient(const Address &clAddr, const ServiceID &sid,
                                    Availability oldStatus,
                                    Availability newStatus);
+  SessionHandle openSession(const Address &clAddr);
+  bool closeSession(const Address &clAddr);
+  void onClientGone(const Address &clAddr);
+  HeaderVersion headerVersionOf(const Address &clAddr);
+
   using RegistedClientAddresses = threading::Lockable<std::set<Address>>;
   RegistedClientAddresses registedClAddrs_;
+  // Clients which negotiated the compact header, by the handle given to them
+  struct Sessions {
+    std::map<SessionHandle, Address> addresses;
+    std::map<Address, SessionHandle> handles;
+    SessionHandle last = SessionHandleInvalid;
+  };
+  threading::Lockable<Sessions> sessions_;
   std::unique_ptr<BufferSenderIF> pSender_;
   std::unique_ptr<BufferReceiverIF> pReceiver_;
   std::thread listeningThread_;
@@ -0,0 +1,40 @@
+#include "ShmBufferReceiver.h"
+
+#include <maf/messaging/client-server/ipc/ShmBufferReceiverImpl.h>
+
+namespace maf {
+namespace messaging {
+namespace ipc {
+namespace local {
+
+ShmBufferReceiver::ShmBufferReceiver() {
+  _impl = std::make_unique<ShmBufferReceiverImpl>();
+}
+
+ShmBufferReceiver::~ShmBufferReceiver() {}
+
+bool ShmBufferReceiver::init(const Address &address) {
+  return _impl->init(address);
+}
+
+bool ShmBufferReceiver::start() { return _impl->start(); }
+
+void ShmBufferReceiver::stop() { _impl->stop(); }
+
+bool ShmBufferReceiver::running() const { return _impl->running(); }
+
+void ShmBufferReceiver::deinit() { _impl->deinit(); }
+
+const Address &ShmBufferReceiver::address() const {
+  return _impl->address();
+}
+
+void ShmBufferReceiver::setObserver(BytesComeObserver *observer) {
+  _impl->setObserver(
+      [observer](auto &&bytes) { observer->onBytesCome(std::move(bytes)); });
+}
+
+}  // namespace local
+}  // namespace ipc
+}  // namespace messaging
+}  // namespace maf
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "BufferReceiverIF.h"
+#include <memory>
+
+namespace maf {
+namespace messaging {
+namespace ipc {
+namespace local {
+
+class ShmBufferReceiver : public BufferReceiverIF {
+ public:
+  ShmBufferReceiver();
+  ~ShmBufferReceiver() override;
+  bool init(const Address &address) override;
+  bool start() override;
+  bool running() const override;
+  void stop() override;
+  void deinit() override;
+  const Address &address() const override;
+  void setObserver(BytesComeObserver *observer) override;
+
+ private:
+  std::unique_ptr<class ShmBufferReceiverImpl> _impl;
+};
+}  // namespace local
+}  // namespace ipc
+}  // namespace messaging
+}  // namespace maf
@@ -0,0 +1,29 @@
+#include "ShmBufferSender.h"
+
+#include <maf/messaging/client-server/ipc/ShmBufferSenderImpl.h>
+
+namespace maf {
+namespace messaging {
+namespace ipc {
+namespace local {
+
+ShmBufferSender::ShmBufferSender() {
+  _pImpl = std::make_unique<ShmBufferSenderImpl>();
+}
+
+ShmBufferSender::~ShmBufferSender() {}
+
+ActionCallStatus ShmBufferSender::send(const srz::Buffer &ba,
+                                       const Address &destination) {
+  return _pImpl->send(ba, destination);
+}
+
+Availability ShmBufferSender::checkReceiverStatus(
+    const Address &destination) const {
+  return _pImpl->checkReceiverStatus(destination);
+}
+
+}  // namespace local
+}  // namespace ipc
+}  // namespace messaging
+}  // namespace maf
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <memory>
+
+#include "BufferSenderIF.h"
+#include "IPCTypes.h"
+
+namespace maf {
+namespace messaging {
+namespace ipc {
+namespace local {
+
+class ShmBufferSender : public maf::messaging::ipc::BufferSenderIF {
+ public:
+  ShmBufferSender();
+  ~ShmBufferSender() override;
+  ActionCallStatus send(const maf::srz::Buffer &ba,
+                        const Address &destination) override;
+  Availability checkReceiverStatus(const Address &destination) const override;
+
+ private:
+  std::unique_ptr<class ShmBufferSenderImpl> _pImpl;
+};
+
+}  // namespace local
+}  // namespace ipc
+}  // namespace messaging
+}  // namespace maf
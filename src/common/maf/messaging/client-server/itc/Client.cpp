@@ -1,4 +1,7 @@
 #include "Client.h"
+
+#include <maf/messaging/client-server/itc/Proxy.h>
+
 #include "Server.h"
 
 namespace maf {
@@ -20,6 +23,15 @@ ActionCallStatus Client::sendMessageToServer(const CSMessagePtr &msg) {
   }
 }
 
+ServiceProviderIFPtr Client::localServiceProvider(const ServiceID &sid) {
+  return directRequests_ ? Server::instance()->findServiceProvider(sid)
+                         : nullptr;
+}
+
+void setDirectRequests(bool enabled) {
+  Client::instance()->setDirectRequests(enabled);
+}
+
 } // namespace itc
 } // namespace messaging
 } // namespace maf
@@ -3,6 +3,8 @@
 #include "../ClientBase.h"
 #include <maf/patterns/Patterns.h>
 
+#include <atomic>
+
 namespace maf {
 namespace messaging {
 namespace itc {
@@ -16,6 +18,13 @@ public:
   void deinit() override {}
   static std::shared_ptr<Client> instance();
   ActionCallStatus sendMessageToServer(const CSMessagePtr &msg) override;
+  ServiceProviderIFPtr localServiceProvider(const ServiceID &sid) override;
+  // Requests of services becoming available later go through messages, for
+  // measuring or debugging that path
+  void setDirectRequests(bool enabled) { directRequests_ = enabled; }
+
+private:
+  std::atomic_bool directRequests_ = true;
 };
 } // namespace itc
 } // namespace messaging
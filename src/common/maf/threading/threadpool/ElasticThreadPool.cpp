@@ -0,0 +1,265 @@
+#include <maf/logging/Logger.h>
+#include <maf/threading/ElasticThreadPool.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <thread>
+
+namespace maf {
+namespace threading {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct PendingTask {
+  Runnable *task;
+  Clock::time_point enqueued;
+};
+
+struct ElasticWorker {
+  std::thread thread;
+  Runnable *running = nullptr;
+};
+
+using Workers = std::list<ElasticWorker>;
+
+unsigned int effectiveMax(unsigned int maxThreads) {
+  if (maxThreads == 0) {
+    maxThreads = std::thread::hardware_concurrency();
+  }
+  return maxThreads != 0 ? maxThreads : 1;
+}
+
+} // namespace
+
+struct ElasticImpl {
+  using Config = ElasticThreadPool::Config;
+  using Stats = ElasticThreadPool::Stats;
+
+  ElasticImpl(Config cfg) : config{std::move(cfg)} {
+    config.maxThreads = effectiveMax(config.maxThreads);
+    config.minThreads = std::min(config.minThreads, config.maxThreads);
+    std::lock_guard lock(mutex);
+    while (alive < config.minThreads && spawn__()) {
+    }
+  }
+
+  void run(Runnable *const *runners, size_t count) {
+    Workers exited;
+    {
+      std::unique_lock lock(mutex);
+      if (stopped) {
+        lock.unlock();
+        for (size_t i = 0; i < count; ++i) {
+          threading::done(runners[i]);
+        }
+        return;
+      }
+      auto now = Clock::now();
+      for (size_t i = 0; i < count; ++i) {
+        tasks.push_back({runners[i], now});
+      }
+      while (shouldGrow__() && spawn__()) {
+      }
+      if (idle != 0) {
+        count == 1 ? taskAvailable.notify_one() : taskAvailable.notify_all();
+      }
+      exited.splice(exited.end(), exitedWorkers);
+    }
+    join(exited);
+  }
+
+  void setMaxThreadCount(unsigned int nThreadCount) {
+    std::lock_guard lock(mutex);
+    config.maxThreads = effectiveMax(nThreadCount);
+    config.minThreads = std::min(config.minThreads, config.maxThreads);
+    if (alive > config.maxThreads) {
+      taskAvailable.notify_all();
+    }
+  }
+
+  Stats stats() const {
+    std::lock_guard lock(mutex);
+    return {spawned, retired, alive, idle, tasks.size()};
+  }
+
+  void shutdown() {
+    Workers all;
+    std::deque<PendingTask> dropped;
+    {
+      std::lock_guard lock(mutex);
+      if (stopped) {
+        return;
+      }
+      stopped = true;
+      for (auto &w : workers) {
+        threading::stop(w.running);
+      }
+      dropped.swap(tasks);
+      taskAvailable.notify_all();
+    }
+
+    for (auto &t : dropped) {
+      threading::done(t.task);
+    }
+
+    // Workers leave the list themselves on exit, join until none is left
+    std::unique_lock lock(mutex);
+    while (true) {
+      all.splice(all.end(), exitedWorkers);
+      if (workers.empty()) {
+        break;
+      }
+      if (workers.size() == 1 &&
+          workers.front().thread.get_id() == std::this_thread::get_id()) {
+        // Shut down from its own task, the last thread can't join itself
+        workers.front().thread.detach();
+        break;
+      }
+      workerExited.wait(lock, [this] { return !exitedWorkers.empty(); });
+    }
+    lock.unlock();
+    join(all);
+  }
+
+  static void join(Workers &exited) {
+    for (auto &w : exited) {
+      if (w.thread.joinable() &&
+          w.thread.get_id() != std::this_thread::get_id()) {
+        w.thread.join();
+      } else if (w.thread.joinable()) {
+        w.thread.detach();
+      }
+    }
+  }
+
+  bool shouldGrow__() const {
+    if (alive >= config.maxThreads) {
+      return false;
+    }
+    if (alive < config.minThreads || alive == 0) {
+      return true;
+    }
+    if (tasks.size() > idle + static_cast<size_t>(alive) *
+                                  config.queueDepthPerThread) {
+      return true;
+    }
+    return !tasks.empty() &&
+           Clock::now() - tasks.front().enqueued > config.maxQueueLatency;
+  }
+
+  bool spawn__() {
+    auto it = workers.emplace(workers.end());
+    try {
+      it->thread = std::thread{&ElasticImpl::coptRunPendingTasks, this, it};
+    } catch (const std::system_error &err) {
+      MAF_LOGGER_WARN("Cannot launch new thread due to: ", err.what());
+      workers.erase(it);
+      return false;
+    }
+    ++alive;
+    ++spawned;
+    return true;
+  }
+
+  // copt = Called On Pool Threads
+  void coptRunPendingTasks(Workers::iterator self) {
+    std::unique_lock lock(mutex);
+    while (!stopped && alive <= config.maxThreads) {
+      if (tasks.empty()) {
+        ++idle;
+        auto status = taskAvailable.wait_for(lock, config.idleTimeout);
+        --idle;
+        if (status == std::cv_status::timeout && tasks.empty() &&
+            alive > config.minThreads) {
+          break;
+        }
+        continue;
+      }
+
+      auto pending = tasks.front();
+      tasks.pop_front();
+      self->running = pending.task;
+      // Workers can't keep up while the producer is quiet, the latency check
+      // in run() won't fire then
+      if (!tasks.empty() &&
+          Clock::now() - pending.enqueued > config.maxQueueLatency &&
+          shouldGrow__()) {
+        spawn__();
+      }
+      lock.unlock();
+
+      threading::run(pending.task);
+
+      lock.lock();
+      self->running = nullptr;
+      lock.unlock();
+      threading::done(pending.task);
+      lock.lock();
+    }
+
+    --alive;
+    if (!stopped) {
+      ++retired;
+      MAF_LOGGER_INFO("Elastic pool retired a thread, ", alive, " left");
+    }
+    exitedWorkers.splice(exitedWorkers.end(), workers, self);
+    workerExited.notify_all();
+  }
+
+  Config config;
+  mutable std::mutex mutex;
+  std::condition_variable taskAvailable;
+  std::condition_variable workerExited;
+  std::deque<PendingTask> tasks;
+  Workers workers;
+  Workers exitedWorkers;
+  unsigned int alive = 0;
+  unsigned int idle = 0;
+  unsigned long long spawned = 0;
+  unsigned long long retired = 0;
+  bool stopped = false;
+};
+
+ElasticThreadPool::ElasticThreadPool(Config config)
+    : _pImpl(new ElasticImpl{std::move(config)}) {}
+
+ElasticThreadPool::ElasticThreadPool(unsigned int maxThreadCount)
+    : ElasticThreadPool(Config{0, maxThreadCount}) {}
+
+ElasticThreadPool::~ElasticThreadPool() {
+  shutdown();
+  delete _pImpl;
+}
+
+void ElasticThreadPool::run(Runnable *pRuner, unsigned int /*priority*/) {
+  if (pRuner) {
+    _pImpl->run(&pRuner, 1);
+  }
+}
+
+void ElasticThreadPool::runBatch(Runnable *const *runners, size_t count,
+                                 unsigned int /*priority*/) {
+  _pImpl->run(runners, count);
+}
+
+void ElasticThreadPool::setMaxThreadCount(unsigned int nThreadCount) {
+  _pImpl->setMaxThreadCount(nThreadCount);
+}
+
+unsigned int ElasticThreadPool::activeThreadCount() {
+  return _pImpl->stats().alive;
+}
+
+void ElasticThreadPool::shutdown() { _pImpl->shutdown(); }
+
+ElasticThreadPool::Stats ElasticThreadPool::stats() const {
+  return _pImpl->stats();
+}
+
+} // namespace threading
+} // namespace maf
@@ -1,55 +1,270 @@
-#include "PriorityThreadPool.h"
-#include <maf/threading/Queue.h>
-#include <maf/threading/ThreadPoolImplBase.h>
+#include <maf/logging/Logger.h>
+#include <maf/threading/MPMCRing.h>
+#include <maf/threading/PriorityThreadPool.h>
+
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 namespace maf {
 namespace threading {
 
-struct PrioritizableRunner {
-public:
-  Runnable *_pRunner;
-  unsigned int _priority;
-  PrioritizableRunner(Runnable *pRunner = nullptr, unsigned int priority = 0)
-      : _pRunner(pRunner), _priority(priority) {}
-  friend bool operator<(const PrioritizableRunner &p1,
-                        const PrioritizableRunner &p2) {
-    return p1._priority < p2._priority;
+namespace {
+
+constexpr unsigned int BAND_COUNT = PriorityThreadPool::BAND_COUNT;
+constexpr size_t BAND_RING_CAPACITY = 1024;
+constexpr unsigned int SCHEDULE_LENGTH = (1u << BAND_COUNT) - 1;
+
+// Smooth weighted round robin over weights 2^band, the top band gets every
+// other turn and the lowest one 1 out of SCHEDULE_LENGTH
+std::array<unsigned char, SCHEDULE_LENGTH> makeSchedule() {
+  std::array<unsigned char, SCHEDULE_LENGTH> schedule{};
+  std::array<int, BAND_COUNT> current{};
+  for (auto &turn : schedule) {
+    unsigned int best = 0;
+    for (unsigned int b = 0; b < BAND_COUNT; ++b) {
+      current[b] += 1 << b;
+      if (current[b] > current[best]) {
+        best = b;
+      }
+    }
+    current[best] -= static_cast<int>(SCHEDULE_LENGTH);
+    turn = static_cast<unsigned char>(best);
   }
-  friend bool operator==(const PrioritizableRunner &p1,
-                         const PrioritizableRunner &p2) {
-    return p1._pRunner == p2._pRunner && p1._priority == p2._priority;
+  return schedule;
+}
+
+const std::array<unsigned char, SCHEDULE_LENGTH> &schedule() {
+  static const auto s = makeSchedule();
+  return s;
+}
+
+// Lock-free ring first, a locked deque takes over while the ring is full.
+// Once the deque is in use new tasks keep going there until it drains, so
+// tasks of one band still come out in submission order
+struct Band {
+  void push(Runnable *task) {
+    submitted.fetch_add(1, std::memory_order_relaxed);
+    if (overflowCount.load(std::memory_order_acquire) == 0 &&
+        ring.tryPush(task)) {
+      return;
+    }
+    std::lock_guard lock(overflowMutex);
+    overflow.push_back(task);
+    overflowCount.fetch_add(1, std::memory_order_release);
   }
+
+  bool pop(Runnable *&task) {
+    if (ring.tryPop(task)) {
+      executed.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+    if (overflowCount.load(std::memory_order_acquire) == 0) {
+      return false;
+    }
+
+    std::lock_guard lock(overflowMutex);
+    // A producer may have been in the middle of pushing to the ring when the
+    // overflow started
+    if (!ring.tryPop(task)) {
+      if (overflow.empty()) {
+        return false;
+      }
+      task = overflow.front();
+      overflow.pop_front();
+      overflowCount.fetch_sub(1, std::memory_order_release);
+    }
+    while (!overflow.empty() && ring.tryPush(overflow.front())) {
+      overflow.pop_front();
+      overflowCount.fetch_sub(1, std::memory_order_release);
+    }
+    executed.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  MPMCRing<Runnable *> ring{BAND_RING_CAPACITY};
+  std::mutex overflowMutex;
+  std::deque<Runnable *> overflow;
+  std::atomic<size_t> overflowCount{0};
+  std::atomic<unsigned long long> submitted{0};
+  std::atomic<unsigned long long> executed{0};
 };
 
-#define prAct(func)                                                            \
-  [](PrioritizableRunner &runner) { threading::func(runner._pRunner); }
+struct PriorityWorker {
+  // Only contended when the pool shuts down and stops the running task
+  std::mutex runningMutex;
+  Runnable *running = nullptr;
+  std::thread thread;
+};
+
+} // namespace
 
 struct TheImpl {
-  TheImpl(unsigned int threadCount = 0)
-      : thePool{threadCount, prAct(run), prAct(stop), prAct(done)} {
-    for (unsigned int i = 0; i < thePool.maxThreadCount(); ++i) {
-      thePool.tryLaunchNewThread();
+  TheImpl(unsigned int threadCount) {
+    if (threadCount == 0) {
+      threadCount = std::thread::hardware_concurrency();
+    }
+    if (threadCount == 0) {
+      threadCount = 1;
+    }
+    workers.reserve(threadCount);
+    for (unsigned int i = 0; i < threadCount; ++i) {
+      workers.emplace_back(new PriorityWorker);
+    }
+    for (auto &w : workers) {
+      try {
+        w->thread = std::thread{&TheImpl::coptRunPendingTasks, this, w.get()};
+      } catch (const std::system_error &err) {
+        MAF_LOGGER_WARN("Cannot launch new thread due to: ", err.what());
+      }
+    }
+  }
+
+  void run(Runnable *task, unsigned int priority) {
+    if (stopped.load(std::memory_order_acquire)) {
+      threading::done(task);
+      return;
+    }
+    bands[std::min(priority, BAND_COUNT - 1)].push(task);
+    pending.fetch_add(1, std::memory_order_relaxed);
+    // Pairs with the fence in coptPark
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleepers.load(std::memory_order_relaxed) != 0) {
+      std::lock_guard lock(parkMutex);
+      parkCondition.notify_one();
+    }
+    if (stopped.load(std::memory_order_acquire)) {
+      // Raced with shutdown, which may have drained the bands already
+      dropPendingTasks();
     }
   }
 
-  ThreadPoolImplBase<PriorityQueue<PrioritizableRunner>> thePool;
+  void dropPendingTasks() {
+    Runnable *task = nullptr;
+    while (tryPop(task)) {
+      threading::done(task);
+    }
+  }
+
+  bool tryPop(Runnable *&task) {
+    auto turn = nextTurn.fetch_add(1, std::memory_order_relaxed);
+    auto preferred = schedule()[turn % SCHEDULE_LENGTH];
+    if (bands[preferred].pop(task)) {
+      return true;
+    }
+    for (auto b = BAND_COUNT; b-- > 0;) {
+      if (b != preferred && bands[b].pop(task)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void shutdown() {
+    std::call_once(shutdowned, &TheImpl::stopThePool, this);
+  }
+
+  void stopThePool() {
+    stopped.store(true, std::memory_order_release);
+    for (auto &w : workers) {
+      std::lock_guard lock(w->runningMutex);
+      threading::stop(w->running);
+    }
+    {
+      std::lock_guard lock(parkMutex);
+      parkCondition.notify_all();
+    }
+    for (auto &w : workers) {
+      if (w->thread.joinable() &&
+          w->thread.get_id() != std::this_thread::get_id()) {
+        w->thread.join();
+      }
+    }
+    dropPendingTasks();
+  }
+
+  // copt = Called On Pool Threads
+  void coptRunPendingTasks(PriorityWorker *self) {
+    Runnable *task = nullptr;
+    while (!stopped.load(std::memory_order_acquire)) {
+      if (!tryPop(task)) {
+        coptPark();
+        continue;
+      }
+      pending.fetch_sub(1, std::memory_order_relaxed);
+      {
+        std::lock_guard lock(self->runningMutex);
+        self->running = task;
+      }
+      threading::run(task);
+      {
+        std::lock_guard lock(self->runningMutex);
+        self->running = nullptr;
+      }
+      threading::done(task);
+    }
+  }
+
+  void coptPark() {
+    std::unique_lock lock(parkMutex);
+    sleepers.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (pending.load(std::memory_order_relaxed) == 0 &&
+        !stopped.load(std::memory_order_relaxed)) {
+      parkCondition.wait(lock);
+    }
+    sleepers.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  std::array<Band, BAND_COUNT> bands;
+  std::atomic<unsigned int> nextTurn{0};
+  // Pushed but not yet popped, may briefly lag behind the bands
+  std::atomic<long long> pending{0};
+
+  std::vector<std::unique_ptr<PriorityWorker>> workers;
+  std::mutex parkMutex;
+  std::condition_variable parkCondition;
+  std::atomic<unsigned int> sleepers{0};
+  std::atomic<bool> stopped{false};
+  std::once_flag shutdowned;
 };
 
 PriorityThreadPool::PriorityThreadPool(unsigned int threadCount) {
   _pImpl = new TheImpl(threadCount);
 }
 
-PriorityThreadPool::~PriorityThreadPool() { delete _pImpl; }
+PriorityThreadPool::~PriorityThreadPool() {
+  shutdown();
+  delete _pImpl;
+}
 
 void PriorityThreadPool::run(Runnable *pRuner, unsigned int priority) {
-  _pImpl->thePool.run({pRuner, priority});
+  if (pRuner) {
+    _pImpl->run(pRuner, priority);
+  }
 }
 
 unsigned int PriorityThreadPool::activeThreadCount() {
-  return _pImpl->thePool.activeThreadCount();
+  return static_cast<unsigned int>(_pImpl->workers.size());
 }
 
-void PriorityThreadPool::shutdown() { _pImpl->thePool.shutdown(); }
+void PriorityThreadPool::shutdown() { _pImpl->shutdown(); }
+
+PriorityThreadPool::BandStats
+PriorityThreadPool::bandStats(unsigned int band) const {
+  BandStats stats;
+  if (band < BAND_COUNT) {
+    auto &b = _pImpl->bands[band];
+    stats.executed = b.executed.load(std::memory_order_relaxed);
+    stats.submitted = b.submitted.load(std::memory_order_relaxed);
+    stats.pending = static_cast<size_t>(stats.submitted - stats.executed);
+  }
+  return stats;
+}
 
 } // namespace threading
 } // namespace maf
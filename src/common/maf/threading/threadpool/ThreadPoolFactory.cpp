@@ -1,6 +1,7 @@
-#include "DynamicCountThreadPool.h"
-#include "PriorityThreadPool.h"
 #include "StableThreadPool.h"
+#include "WorkStealingThreadPool.h"
+#include <maf/threading/ElasticThreadPool.h>
+#include <maf/threading/PriorityThreadPool.h>
 #include <maf/threading/ThreadPoolFactory.h>
 
 namespace maf {
@@ -17,7 +18,10 @@ ThreadPoolFactory::createPool(PoolType type, unsigned int poolSize) {
     pPool.reset(new StableThreadPool(poolSize));
     break;
   case DynamicCount:
-    pPool.reset(new VaryCountThreadPool(poolSize));
+    pPool.reset(new ElasticThreadPool(poolSize));
+    break;
+  case WorkStealing:
+    pPool.reset(new WorkStealingThreadPool(poolSize));
     break;
   }
   return pPool;
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace maf {
+namespace threading {
+
+/*! \brief Chase-Lev work-stealing deque
+ * The owner thread pushes and pops at the bottom without locking, other
+ * threads steal from the top. Memory orderings follow Le et al., "Correct and
+ * Efficient Work-Stealing for Weak Memory Models" (PPoPP 2013).
+ * Arrays replaced by growing are kept until the deque is destroyed because a
+ * thief might still be reading from them.
+ */
+template <class T> class WorkStealingDeque {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "WorkStealingDeque only holds trivially copyable items");
+
+  class Array {
+  public:
+    explicit Array(int64_t capacity)
+        : _capacity(capacity), _mask(capacity - 1),
+          _items(new std::atomic<T>[static_cast<size_t>(capacity)]) {}
+
+    int64_t capacity() const { return _capacity; }
+
+    T get(int64_t i) const {
+      return _items[i & _mask].load(std::memory_order_relaxed);
+    }
+
+    void put(int64_t i, T item) {
+      _items[i & _mask].store(item, std::memory_order_relaxed);
+    }
+
+    Array *grow(int64_t bottom, int64_t top) const {
+      auto bigger = new Array{_capacity * 2};
+      for (auto i = top; i != bottom; ++i) {
+        bigger->put(i, get(i));
+      }
+      return bigger;
+    }
+
+  private:
+    int64_t _capacity;
+    int64_t _mask;
+    std::unique_ptr<std::atomic<T>[]> _items;
+  };
+
+public:
+  explicit WorkStealingDeque(int64_t capacity = 256)
+      : _top(0), _bottom(0), _array(new Array{capacity}) {
+    _garbage.emplace_back(_array.load(std::memory_order_relaxed));
+  }
+
+  WorkStealingDeque(const WorkStealingDeque &) = delete;
+  WorkStealingDeque &operator=(const WorkStealingDeque &) = delete;
+
+  // Owner only
+  void push(T item) {
+    auto b = _bottom.load(std::memory_order_relaxed);
+    auto t = _top.load(std::memory_order_acquire);
+    auto a = _array.load(std::memory_order_relaxed);
+    if (b - t > a->capacity() - 1) {
+      a = a->grow(b, t);
+      _garbage.emplace_back(a);
+      _array.store(a, std::memory_order_release);
+    }
+    a->put(b, item);
+    std::atomic_thread_fence(std::memory_order_release);
+    _bottom.store(b + 1, std::memory_order_relaxed);
+  }
+
+  // Owner only
+  bool pop(T &item) {
+    auto b = _bottom.load(std::memory_order_relaxed) - 1;
+    auto a = _array.load(std::memory_order_relaxed);
+    _bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto t = _top.load(std::memory_order_relaxed);
+
+    if (t > b) {
+      _bottom.store(b + 1, std::memory_order_relaxed);
+      return false;
+    }
+
+    item = a->get(b);
+    if (t == b) {
+      // the last item, race against thieves
+      auto won = _top.compare_exchange_strong(
+          t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+      _bottom.store(b + 1, std::memory_order_relaxed);
+      return won;
+    }
+    return true;
+  }
+
+  // Any thread
+  bool steal(T &item) {
+    auto t = _top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto b = _bottom.load(std::memory_order_acquire);
+    if (t < b) {
+      auto a = _array.load(std::memory_order_acquire);
+      item = a->get(t);
+      return _top.compare_exchange_strong(
+          t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    }
+    return false;
+  }
+
+  bool empty() const {
+    auto b = _bottom.load(std::memory_order_relaxed);
+    auto t = _top.load(std::memory_order_relaxed);
+    return b <= t;
+  }
+
+private:
+  alignas(64) std::atomic<int64_t> _top;
+  alignas(64) std::atomic<int64_t> _bottom;
+  std::atomic<Array *> _array;
+  std::vector<std::unique_ptr<Array>> _garbage;
+};
+
+} // namespace threading
+} // namespace maf
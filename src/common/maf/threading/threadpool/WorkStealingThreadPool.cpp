@@ -0,0 +1,309 @@
+#include "WorkStealingThreadPool.h"
+#include "WorkStealingDeque.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <maf/logging/Logger.h>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace maf {
+namespace threading {
+
+namespace {
+
+// Number of rounds an idle thread keeps looking for work before parking
+constexpr int IDLE_SEARCH_ROUNDS = 64;
+// Max tasks moved from the injection queue to a worker's deque at once
+constexpr size_t INJECTION_BATCH_SIZE = 32;
+
+struct Worker {
+  WorkStealingDeque<Runnable *> tasks;
+  // Only contended when the pool shuts down and stops the running task
+  std::mutex runningMutex;
+  Runnable *running = nullptr;
+  std::thread thread;
+  uint32_t seed;
+};
+
+struct WorkerContext {
+  const WSImpl *pool = nullptr;
+  Worker *worker = nullptr;
+};
+
+thread_local WorkerContext tlsContext;
+
+} // namespace
+
+struct WSImpl {
+  WSImpl(unsigned int threadCount) {
+    if (threadCount == 0) {
+      threadCount = std::thread::hardware_concurrency();
+    }
+    if (threadCount == 0) {
+      threadCount = 1;
+    }
+
+    workers.reserve(threadCount);
+    for (unsigned int i = 0; i < threadCount; ++i) {
+      workers.emplace_back(new Worker);
+      workers.back()->seed = i + 1;
+    }
+
+    for (auto &w : workers) {
+      try {
+        w->thread = std::thread{&WSImpl::coptRunPendingTasks, this, w.get()};
+      } catch (const std::system_error &err) {
+        MAF_LOGGER_WARN("Cannot launch new thread due to: ", err.what());
+      }
+    }
+  }
+
+  void run(Runnable *task) {
+    if (auto &ctx = tlsContext; ctx.pool == this) {
+      ctx.worker->tasks.push(task);
+    } else {
+      std::unique_lock lock(injectedMutex);
+      if (stopped.load(std::memory_order_relaxed)) {
+        lock.unlock();
+        threading::done(task);
+        return;
+      }
+      injected.push_back(task);
+      injectedCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    wakeOne();
+  }
+
+  void runBatch(Runnable *const *runners, size_t count) {
+    if (auto &ctx = tlsContext; ctx.pool == this) {
+      for (size_t i = 0; i < count; ++i) {
+        ctx.worker->tasks.push(runners[i]);
+      }
+    } else {
+      std::unique_lock lock(injectedMutex);
+      if (stopped.load(std::memory_order_relaxed)) {
+        lock.unlock();
+        for (size_t i = 0; i < count; ++i) {
+          threading::done(runners[i]);
+        }
+        return;
+      }
+      injected.insert(injected.end(), runners, runners + count);
+      injectedCount.fetch_add(count, std::memory_order_relaxed);
+    }
+    wakeSome(count);
+  }
+
+  void shutdown() { std::call_once(shutdowned, &WSImpl::stopThePool, this); }
+
+  void stopThePool() {
+    {
+      std::lock_guard lock(injectedMutex);
+      stopped.store(true, std::memory_order_release);
+    }
+    for (auto &w : workers) {
+      std::lock_guard lock(w->runningMutex);
+      threading::stop(w->running);
+    }
+    {
+      std::lock_guard lock(parkMutex);
+      parkCondition.notify_all();
+    }
+    for (auto &w : workers) {
+      if (w->thread.joinable() &&
+          w->thread.get_id() != std::this_thread::get_id()) {
+        w->thread.join();
+      }
+    }
+
+    // Pool threads are gone, drop what they didn't get to run
+    Runnable *task = nullptr;
+    for (auto &w : workers) {
+      while (w->tasks.steal(task)) {
+        threading::done(task);
+      }
+    }
+    std::lock_guard lock(injectedMutex);
+    for (auto t : injected) {
+      threading::done(t);
+    }
+    injected.clear();
+    injectedCount.store(0, std::memory_order_relaxed);
+  }
+
+  // copt = Called On Pool Threads
+  void coptRunPendingTasks(Worker *self) {
+    tlsContext = {this, self};
+    Runnable *task = nullptr;
+    while (!stopped.load(std::memory_order_acquire)) {
+      if (coptFindTask(self, task)) {
+        coptRun(self, task);
+      } else {
+        coptPark();
+      }
+    }
+    tlsContext = {};
+  }
+
+  void coptRun(Worker *self, Runnable *task) {
+    {
+      std::lock_guard lock(self->runningMutex);
+      self->running = task;
+    }
+    threading::run(task);
+    {
+      std::lock_guard lock(self->runningMutex);
+      self->running = nullptr;
+    }
+    threading::done(task);
+  }
+
+  bool coptFindTask(Worker *self, Runnable *&task) {
+    if (self->tasks.pop(task)) {
+      return true;
+    }
+    for (int round = 0; round < IDLE_SEARCH_ROUNDS; ++round) {
+      if (coptTakeInjected(self, task) || coptSteal(self, task)) {
+        return true;
+      }
+      if (stopped.load(std::memory_order_relaxed)) {
+        return false;
+      }
+      std::this_thread::yield();
+    }
+    return false;
+  }
+
+  bool coptTakeInjected(Worker *self, Runnable *&task) {
+    if (injectedCount.load(std::memory_order_relaxed) == 0) {
+      return false;
+    }
+
+    std::unique_lock lock(injectedMutex);
+    if (injected.empty()) {
+      return false;
+    }
+    // Take a share of the backlog so the others can steal from us instead of
+    // queuing up on this mutex
+    auto count = std::min(
+        injected.size(),
+        std::max<size_t>(1, std::min(INJECTION_BATCH_SIZE,
+                                     injected.size() / workers.size())));
+    task = injected.front();
+    injected.pop_front();
+    for (size_t i = 1; i < count; ++i) {
+      self->tasks.push(injected.front());
+      injected.pop_front();
+    }
+    injectedCount.fetch_sub(count, std::memory_order_relaxed);
+    lock.unlock();
+    if (count > 1) {
+      wakeOne();
+    }
+    return true;
+  }
+
+  bool coptSteal(Worker *self, Runnable *&task) {
+    auto total = workers.size();
+    if (total < 2) {
+      return false;
+    }
+    // xorshift, just to spread thieves over different victims
+    self->seed ^= self->seed << 13;
+    self->seed ^= self->seed >> 17;
+    self->seed ^= self->seed << 5;
+    auto start = self->seed % total;
+    for (size_t i = 0; i < total; ++i) {
+      auto &victim = workers[(start + i) % total];
+      if (victim.get() != self && victim->tasks.steal(task)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void coptPark() {
+    std::unique_lock lock(parkMutex);
+    sleepers.fetch_add(1, std::memory_order_relaxed);
+    // Pairs with the fence in wakeOne: either the submitter sees this thread
+    // as a sleeper or this thread sees the submitted task
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!hasPendingTasks() && !stopped.load(std::memory_order_relaxed)) {
+      parkCondition.wait(lock);
+    }
+    sleepers.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  bool hasPendingTasks() const {
+    if (injectedCount.load(std::memory_order_relaxed) != 0) {
+      return true;
+    }
+    for (auto &w : workers) {
+      if (!w->tasks.empty()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void wakeOne() { wakeSome(1); }
+
+  void wakeSome(size_t count) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (auto parked = sleepers.load(std::memory_order_relaxed); parked != 0) {
+      std::lock_guard lock(parkMutex);
+      if (count >= parked) {
+        parkCondition.notify_all();
+      } else {
+        while (count-- != 0) {
+          parkCondition.notify_one();
+        }
+      }
+    }
+  }
+
+  std::vector<std::unique_ptr<Worker>> workers;
+
+  std::mutex injectedMutex;
+  std::deque<Runnable *> injected;
+  std::atomic<size_t> injectedCount{0};
+
+  std::mutex parkMutex;
+  std::condition_variable parkCondition;
+  std::atomic<unsigned int> sleepers{0};
+
+  std::atomic<bool> stopped{false};
+  std::once_flag shutdowned;
+};
+
+WorkStealingThreadPool::WorkStealingThreadPool(unsigned int threadCount)
+    : _pImpl(new WSImpl{threadCount}) {}
+
+WorkStealingThreadPool::~WorkStealingThreadPool() {
+  shutdown();
+  delete _pImpl;
+}
+
+void WorkStealingThreadPool::run(Runnable *pRuner, unsigned int /*priority*/) {
+  _pImpl->run(pRuner);
+}
+
+void WorkStealingThreadPool::runBatch(Runnable *const *runners, size_t count,
+                                      unsigned int /*priority*/) {
+  _pImpl->runBatch(runners, count);
+}
+
+void WorkStealingThreadPool::setMaxThreadCount(unsigned int /*nThreadCount*/) {
+}
+
+unsigned int WorkStealingThreadPool::activeThreadCount() {
+  return static_cast<unsigned int>(_pImpl->workers.size());
+}
+
+void WorkStealingThreadPool::shutdown() { _pImpl->shutdown(); }
+
+} // namespace threading
+} // namespace maf
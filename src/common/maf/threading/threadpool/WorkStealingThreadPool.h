@@ -0,0 +1,30 @@
+#pragma once
+
+#include <maf/threading/IThreadPool.h>
+
+namespace maf {
+namespace threading {
+
+/*! \brief Fixed size pool where each thread owns a Chase-Lev deque
+ * Tasks submitted from a pool thread go to that thread's deque without
+ * locking, tasks from other threads go through a shared injection queue.
+ * Idle threads steal from the others and park when there's nothing left.
+ * Priority is ignored.
+ */
+class WorkStealingThreadPool : public IThreadPool {
+public:
+  WorkStealingThreadPool(unsigned int threadCount = 0);
+  ~WorkStealingThreadPool() override;
+  virtual void run(Runnable *pRuner, unsigned int priority = 0) override;
+  virtual void runBatch(Runnable *const *runners, size_t count,
+                        unsigned int priority = 0) override;
+  virtual void setMaxThreadCount(unsigned int nThreadCount) override;
+  virtual unsigned int activeThreadCount() override;
+  virtual void shutdown() override;
+
+private:
+  struct WSImpl *_pImpl;
+};
+
+} // namespace threading
+} // namespace maf
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <maf/utils/serialization/Buffer.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "SharedPayload.h"
+
+namespace maf {
+namespace messaging {
+namespace ipc {
+namespace local {
+
+// Rebuilds size-prefixed frames from a byte stream that may arrive in
+// arbitrary pieces. Empty frames are heartbeats and are not delivered
+class FrameAssembler {
+ public:
+  template <class Deliver>
+  void consume(const char *data, size_t size, Deliver &&deliver) {
+    consume(data, size, deliver, [] {
+      MAF_LOGGER_ERROR("Shared payload frame is not expected here, ignored");
+    });
+  }
+
+  //! deliverShared() is called where a frame is announced as shared payload
+  template <class Deliver, class DeliverShared>
+  void consume(const char *data, size_t size, Deliver &&deliver,
+               DeliverShared &&deliverShared) {
+    while (size != 0) {
+      if (headerFilled_ < sizeof(SizeType)) {
+        auto n = std::min(size, sizeof(SizeType) - headerFilled_);
+        memcpy(header_ + headerFilled_, data, n);
+        headerFilled_ += n;
+        data += n;
+        size -= n;
+        if (headerFilled_ == sizeof(SizeType)) {
+          SizeType frameSize;
+          memcpy(&frameSize, header_, sizeof(SizeType));
+          if (frameSize == SHARED_PAYLOAD_FRAME) {
+            headerFilled_ = 0;
+            deliverShared();
+            continue;
+          }
+          frame_.resize(frameSize);
+          frameFilled_ = 0;
+        }
+      } else {
+        auto n = std::min(size, frame_.size() - frameFilled_);
+        memcpy(frame_.data() + frameFilled_, data, n);
+        frameFilled_ += n;
+        data += n;
+        size -= n;
+      }
+      deliverIfComplete(deliver);
+    }
+  }
+
+  //! Bytes still missing from the frame whose size is known, 0 otherwise
+  size_t frameRemaining() const {
+    return headerFilled_ == sizeof(SizeType) ? frame_.size() - frameFilled_
+                                              : 0;
+  }
+
+  //! Lets a big frame be filled in place, call filled() afterwards
+  char *frameTail() { return frame_.data() + frameFilled_; }
+
+  template <class Deliver> void filled(size_t size, Deliver &&deliver) {
+    frameFilled_ += size;
+    deliverIfComplete(deliver);
+  }
+
+ private:
+  template <class Deliver> void deliverIfComplete(Deliver &deliver) {
+    if (headerFilled_ == sizeof(SizeType) && frameFilled_ == frame_.size()) {
+      auto frame = std::move(frame_);
+      frame_ = {};
+      frameFilled_ = 0;
+      headerFilled_ = 0;
+      if (!frame.empty()) {
+        deliver(std::move(frame));
+      }
+    }
+  }
+
+  char header_[sizeof(SizeType)];
+  size_t headerFilled_ = 0;
+  srz::Buffer frame_;
+  size_t frameFilled_ = 0;
+};
+
+}  // namespace local
+}  // namespace ipc
+}  // namespace messaging
+}  // namespace maf
@@ -1,10 +1,8 @@
 #include "LocalIPCBufferReceiverImpl.h"
 
-#include <arpa/inet.h>
 #include <maf/logging/Logger.h>
-#include <netinet/in.h>
-#include <stdlib.h>
-#include <sys/stat.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 
 #include "SocketShared.h"
 
@@ -13,6 +11,23 @@ namespace messaging {
 namespace ipc {
 namespace local {
 
+namespace {
+
+static constexpr size_t READ_CHUNK_SIZE = 64 * 1024;
+static constexpr int MAX_EVENTS = 64;
+static constexpr auto relaxed = std::memory_order_relaxed;
+// A sender passes one fd per shared payload frame, more pending is abuse
+static constexpr size_t MAX_PENDING_SHARED_PAYLOADS = 8;
+
+static bool watch(FD epollFd, FD fd, uint32_t events) {
+  epoll_event ev{};
+  ev.events = events;
+  ev.data.fd = fd;
+  return epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) == 0;
+}
+
+} // namespace
+
 LocalIPCBufferReceiverImpl::~LocalIPCBufferReceiverImpl() { stop(); }
 
 bool LocalIPCBufferReceiverImpl::init(const Address &addr) {
@@ -24,18 +39,23 @@ bool LocalIPCBufferReceiverImpl::init(const Address &addr) {
     setState(State::Initialized);
     // Create the socket.
     int opt = true;
-    fdMySock_ = socket(AF_UNIX, SOCK_STREAM, 0);
-    if (fdMySock_ != INVALID_FD &&
-        (setsockopt(fdMySock_, SOL_SOCKET, SO_REUSEADDR,
-                    reinterpret_cast<char *>(&opt), sizeof(opt)) >= 0)) {
+    fdMySock_ = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    fdEpoll_ = epoll_create1(EPOLL_CLOEXEC);
+    fdStopEvent_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fdEpoll_ == INVALID_FD || fdStopEvent_ == INVALID_FD) {
+      MAF_SOCKET_ERROR("Could not create epoll instance");
+    } else if (fdMySock_ != INVALID_FD &&
+               (setsockopt(fdMySock_, SOL_SOCKET, SO_REUSEADDR,
+                           reinterpret_cast<char *>(&opt), sizeof(opt)) >= 0)) {
       if (bind(fdMySock_, _2sockAddr(&mySockAddr_), sizeof(mySockAddr_)) >= 0) {
-        // Max 5 pending connections
-        if (listen(fdMySock_, 5) == 0) {
+        if (listen(fdMySock_, SOMAXCONN) == 0 &&
+            watch(fdEpoll_, fdMySock_, EPOLLIN | EPOLLET) &&
+            watch(fdEpoll_, fdStopEvent_, EPOLLIN)) {
           MAF_LOGGER_INFO("Listening on address ", myaddr_.dump());
           setState(State::Initialized);
           startable = true;
         } else {
-          MAF_LOGGER_ERROR("Could not listen on socket");
+          MAF_SOCKET_ERROR("Could not listen on socket");
         }
       } else {
         MAF_LOGGER_ERROR("Coud not bind socket to address ", myaddr_.dump());
@@ -47,27 +67,33 @@ bool LocalIPCBufferReceiverImpl::init(const Address &addr) {
 }
 
 bool LocalIPCBufferReceiverImpl::start() {
+  auto expected = State::Initialized;
+  if (!state_.compare_exchange_strong(expected, State::Running)) {
+    return false;
+  }
+  bool ok = false;
   try {
-    if (getState() == State::Initialized) {
-      setState(State::Running);
-      waitAndProcessConnections();
-    } else {
-      return false;
-    }
-  } catch (StoppedInterruption) {
+    ok = waitAndProcessConnections();
   } catch (...) {
-    return false;
   }
-  return true;
+  setState(State::Stopped);
+  connections_.clear();
+  closeListeningSocket();
+  return ok;
+}
+
+void LocalIPCBufferReceiverImpl::closeListeningSocket() {
+  // Senders then see this receiver as unavailable instead of connecting to a
+  // socket nobody accepts on
+  fdMySock_.reset();
 }
 
 void LocalIPCBufferReceiverImpl::stop() {
-  if (running()) {
-    auto currentState = getState();
-    setState(State::Stopped);
-    // trying connect to socket to wake the running thread
-    if (currentState == State::WaitingConnection) {
-      connectToSocket(myaddr_.get_name());
+  auto current = getState();
+  while (current == State::Initialized || current == State::Running) {
+    if (state_.compare_exchange_weak(current, State::Stopped)) {
+      eventfd_write(fdStopEvent_, 1);
+      break;
     }
   }
 }
@@ -75,121 +101,165 @@ void LocalIPCBufferReceiverImpl::stop() {
 void LocalIPCBufferReceiverImpl::deinit() {}
 
 bool LocalIPCBufferReceiverImpl::running() const {
-  switch (getState()) {
-    case State::Running:
-    case State::WaitingConnection:
-      return true;
-    default:
-      return false;
-  }
+  return getState() == State::Running;
 }
 
 const Address &LocalIPCBufferReceiverImpl::address() const { return myaddr_; }
 
-void LocalIPCBufferReceiverImpl::setObserver(BytesComeCallback callback) {
+void LocalIPCBufferReceiverImpl::setObserver(
+    BytesComeCallback callback, SharedBytesComeCallback sharedCallback) {
   bytesComeCallback_ = std::move(callback);
+  sharedBytesComeCallback_ = std::move(sharedCallback);
 }
 
 bool LocalIPCBufferReceiverImpl::waitAndProcessConnections() {
-  auto maxSd = INVALID_FD;
-  socklen_t sockLen = sizeof(mySockAddr_);
-  std::vector<int> fdClientSocks(MAXCLIENTS, 0);
-  fd_set readfds;
-  do {
-    // clear the socket set
-    FD_ZERO(&readfds);
-
-    // add master socket to set
-    FD_SET(fdMySock_, &readfds);
-    maxSd = fdMySock_;
-
-    // add child sockets to set
-    for (size_t i = 0; i < MAXCLIENTS; i++) {
-      // socket descriptor
-      auto sd = fdClientSocks[i];
-
-      // if valid socket descriptor then add to read list
-      if (sd > 0) FD_SET(sd, &readfds);
-
-      // highest file descriptor number, need it for the select function
-      if (sd > maxSd) maxSd = sd;
+  epoll_event events[MAX_EVENTS];
+  SockFD listeningSock = fdMySock_;
+  FD stopEvent = fdStopEvent_;
+  while (getState() == State::Running) {
+    auto count = epoll_wait(fdEpoll_, events, MAX_EVENTS, -1);
+    counters_.syscalls.fetch_add(1, relaxed);
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      MAF_SOCKET_ERROR("Failed waiting for connections");
+      return false;
     }
 
-    timeval timeout = {1, 0};
-
-    changeCurrentStateAndInterruptIfStop(State::Running,
-                                         State::WaitingConnection);
-
-    auto totalSD = select(maxSd + 1, &readfds, nullptr, nullptr, &timeout);
+    for (int i = 0; i < count; ++i) {
+      auto fd = events[i].data.fd;
+      if (fd == stopEvent) {
+        MAF_LOGGER_INFO("Finish running due to stop request, address: ",
+                        myaddr_.dump());
+        return true;
+      } else if (fd == listeningSock) {
+        if (!acceptConnections()) {
+          return false;
+        }
+      } else if (auto it = connections_.find(fd); it != connections_.end()) {
+        if (!readConnection(it->second)) {
+          // Closing the fd also removes it from the epoll set
+          connections_.erase(it);
+        }
+      }
+    }
+  }
+  return true;
+}
 
-    changeCurrentStateAndInterruptIfStop(State::WaitingConnection,
-                                         State::Running);
+bool LocalIPCBufferReceiverImpl::acceptConnections() {
+  while (true) {
+    auto acceptedSD =
+        accept4(fdMySock_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (acceptedSD == INVALID_FD) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        return true;
+      } else if (errno == EINTR || errno == ECONNABORTED) {
+        continue;
+      } else if (errno == EMFILE || errno == ENFILE) {
+        // Keep serving the connected senders, retried on next connection
+        MAF_SOCKET_ERROR("Too many open files, cannot accept connection");
+        return true;
+      }
+      MAF_SOCKET_ERROR("Failed on accepting new socket connection");
+      return false;
+    }
 
-    if (totalSD <= 0) {
-      continue;
+    auto &conn = connections_[acceptedSD];
+    conn.fd = acceptedSD;
+    if (!watch(fdEpoll_, acceptedSD, EPOLLIN | EPOLLRDHUP | EPOLLET)) {
+      MAF_SOCKET_ERROR("Could not watch new connection");
+      connections_.erase(acceptedSD);
     }
+  }
+}
 
-    // If something happened on the master socket ,
-    // then its an incoming connection
-    if (FD_ISSET(fdMySock_, &readfds)) {
-      auto acceptedSD = accept(fdMySock_, _2sockAddr(&mySockAddr_), &sockLen);
-      if (acceptedSD < 0) {
-        MAF_LOGGER_ERROR("Failed on accepting new socket connection");
-        return false;
+bool LocalIPCBufferReceiverImpl::readConnection(Connection &conn) {
+  // Edge-triggered: read until the socket is drained
+  static thread_local char chunk[READ_CHUNK_SIZE];
+  auto deliver = [this](srz::Buffer &&bytes) {
+    counters_.messages.fetch_add(1, relaxed);
+    bytesComeCallback_(std::move(bytes));
+  };
+  auto deliverShared = [&conn, this] { deliverSharedPayload(conn); };
+  while (true) {
+    ssize_t bytesRead;
+    if (auto remaining = conn.frames.frameRemaining();
+        remaining >= READ_CHUNK_SIZE) {
+      // Large frame, read straight into it
+      bytesRead = receive(conn, conn.frames.frameTail(), remaining);
+      if (bytesRead > 0) {
+        conn.frames.filled(static_cast<size_t>(bytesRead), deliver);
+        continue;
       }
-
-      // add new socket to array of sockets
-      for (size_t i = 0; i < MAXCLIENTS; i++) {
-        // if position is empty
-        if (fdClientSocks[i] == 0) {
-          fdClientSocks[i] = acceptedSD;
-          break;
+    } else {
+      bytesRead = receive(conn, chunk, sizeof(chunk));
+      if (bytesRead > 0) {
+        conn.frames.consume(chunk, static_cast<size_t>(bytesRead), deliver,
+                            deliverShared);
+        if (conn.sharedPayloads.size() > MAX_PENDING_SHARED_PAYLOADS) {
+          MAF_LOGGER_ERROR("Sender passed fds that no frame refers to");
+          return false;
         }
+        continue;
       }
     }
 
-    // else its some IO operation on some other socket
-    for (size_t i = 0; i < MAXCLIENTS; i++) {
-      auto sd = fdClientSocks[i];
-      if (FD_ISSET(sd, &readfds)) {
-        SizeType messageLength = 0;
-        ssize_t totalRead = 0;
-        if (auto bytesRead = read(sd, reinterpret_cast<char *>(&messageLength),
-                                  sizeof(SizeType));
-            bytesRead == sizeof(SizeType)) {
-          auto payload = srz::Buffer{};
-          payload.resize(messageLength);
-          while (totalRead < messageLength) {
-            if (bytesRead = read(sd, payload.data() + totalRead, messageLength);
-                bytesRead != -1) {
-              totalRead += bytesRead;
-            } else {
-              MAF_SOCKET_ERROR("Could not read bytes from socket total read = ",
-                               totalRead, " total expected = ", messageLength);
-              break;
-            }
-          }
-          if (totalRead == messageLength) {
-            bytesComeCallback_(std::move(payload));
-          }
+    if (bytesRead == 0) {
+      // Sender closed the connection, a partial frame is dropped
+      return false;
+    } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      return true;
+    } else if (errno != EINTR) {
+      MAF_SOCKET_ERROR("Could not read from connection");
+      return false;
+    }
+  }
+}
+
+ssize_t LocalIPCBufferReceiverImpl::receive(Connection &conn, char *buf,
+                                            size_t size) {
+  // Room for the fd of a shared payload frame, the kernel stops a read after
+  // the bytes that carry fds
+  alignas(cmsghdr) char control[CMSG_SPACE(sizeof(FD) * 4)];
+  iovec iov{buf, size};
+  msghdr msg{};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+  auto n = recvmsg(conn.fd, &msg, MSG_CMSG_CLOEXEC);
+  counters_.syscalls.fetch_add(1, relaxed);
+  if (n > 0) {
+    counters_.bytes.fetch_add(static_cast<uint64_t>(n), relaxed);
+  }
+  if (n > 0 && msg.msg_controllen != 0) {
+    for (auto cmsg = CMSG_FIRSTHDR(&msg); cmsg;
+         cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+      if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+        auto count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(FD);
+        for (size_t i = 0; i < count; ++i) {
+          FD fd;
+          memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(FD), sizeof(FD));
+          conn.sharedPayloads.emplace_back(fd);
         }
-        close(sd);
-        fdClientSocks[i] = 0;
       }
     }
-  } while (true);
-
-  setState(State::Stopped);
-  return true;
+  }
+  return n;
 }
 
-void LocalIPCBufferReceiverImpl::changeCurrentStateAndInterruptIfStop(
-    State expectedCurrentSate, State newStateState) {
-  state_.compare_exchange_strong(expectedCurrentSate, newStateState);
-  if (expectedCurrentSate == State::Stopped) {
-    MAF_LOGGER_INFO("Finish running due to flag STOP was turned on, address: ",
-                    myaddr_.dump());
-    throw StoppedInterruption{};
+void LocalIPCBufferReceiverImpl::deliverSharedPayload(Connection &conn) {
+  if (conn.sharedPayloads.empty()) {
+    MAF_LOGGER_ERROR("Shared payload frame came without its fd, ignored");
+    return;
+  }
+  auto fd = std::move(conn.sharedPayloads.front());
+  conn.sharedPayloads.pop_front();
+  if (auto bytes = mapSharedPayload(fd); bytes.owner) {
+    counters_.messages.fetch_add(1, relaxed);
+    sharedBytesComeCallback_(std::move(bytes));
   }
 }
 
@@ -3,8 +3,11 @@
 #include <maf/utils/serialization/Buffer.h>
 
 #include <atomic>
+#include <deque>
 #include <future>
+#include <unordered_map>
 
+#include "FrameAssembler.h"
 #include "SocketShared.h"
 
 namespace maf {
@@ -14,7 +17,14 @@ namespace local {
 
 using ByteArrayPtr = std::shared_ptr<srz::Buffer>;
 using BytesComeCallback = std::function<void(srz::Buffer &&)>;
+using SharedBytesComeCallback = std::function<void(srz::SharedBytes &&)>;
 
+/*! \brief Receives frames from any number of connected senders
+ * One epoll loop, edge-triggered, over non-blocking sockets: each connection
+ * keeps the part of a frame received so far until the rest comes. stop()
+ * wakes the loop through an eventfd. Payloads passed as memfd are mapped
+ * and handed over without copying.
+ */
 class LocalIPCBufferReceiverImpl {
  public:
   ~LocalIPCBufferReceiverImpl();
@@ -24,29 +34,39 @@ class LocalIPCBufferReceiverImpl {
   void deinit();
   bool running() const;
   const Address &address() const;
-  void setObserver(BytesComeCallback callback);
+  void setObserver(BytesComeCallback callback,
+                   SharedBytesComeCallback sharedCallback);
+  const IOCounters &counters() const { return counters_; }
 
  private:
-  enum class State : char {
-    Uninitialized,
-    Initialized,
-    Running,
-    WaitingConnection,
-    Stopped
-  };
+  enum class State : char { Uninitialized, Initialized, Running, Stopped };
 
-  class StoppedInterruption {};
+  struct Connection {
+    AutoCloseFD<SockFD> fd;
+    FrameAssembler frames;
+    // Received with the frame bytes, taken when the frame is parsed
+    std::deque<AutoCloseFD<FD>> sharedPayloads;
+  };
 
   State getState() const { return state_.load(std::memory_order_acquire); }
   void setState(State state) { state_.store(state, std::memory_order_release); }
 
   bool waitAndProcessConnections();
-  void changeCurrentStateAndInterruptIfStop(State expectedCurrentSate, State newStateState);
+  bool acceptConnections();
+  bool readConnection(Connection &conn);
+  ssize_t receive(Connection &conn, char *buf, size_t size);
+  void deliverSharedPayload(Connection &conn);
+  void closeListeningSocket();
 
   BytesComeCallback bytesComeCallback_;
+  SharedBytesComeCallback sharedBytesComeCallback_;
   Address myaddr_;
   sockaddr_un mySockAddr_;
-  int fdMySock_;
+  AutoCloseFD<SockFD> fdMySock_;
+  AutoCloseFD<FD> fdEpoll_;
+  AutoCloseFD<FD> fdStopEvent_;
+  std::unordered_map<SockFD, Connection> connections_;
+  IOCounters counters_;
   std::atomic<State> state_ = State::Uninitialized;
 };
 
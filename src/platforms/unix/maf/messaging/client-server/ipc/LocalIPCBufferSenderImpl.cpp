@@ -1,6 +1,11 @@
 #include "LocalIPCBufferSenderImpl.h"
 
-#define ns_global
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#include <algorithm>
+
+#include "SharedPayload.h"
 
 namespace maf {
 namespace messaging {
@@ -9,20 +14,75 @@ namespace local {
 
 namespace {
 
-static bool connectable(sockaddr_un *sockaddr) {
-  AutoCloseFD<SockFD> fd;
-  if (fd = socket(AF_UNIX, SOCK_STREAM, 0); fd == INVALID_FD) {
-    MAF_SOCKET_ERROR("Cannot create socket");
-  } else {
-    if (connect(fd, _2sockAddr(sockaddr), sizeof(sockaddr_un)) == INVALID_FD) {
-      // MAF_SOCKET_ERROR("Cannot connect to socket");
-      fd.reset();
-    }
+static constexpr auto relaxed = std::memory_order_relaxed;
+// First wait before trying a receiver found unavailable again, doubled on
+// each failed attempt up to the retry interval
+static constexpr std::chrono::milliseconds FIRST_RETRY_DELAY{5};
+
+// Only the frame marker goes through the socket, the payload memfd rides
+// along with it
+static bool writeSharedFrame(SockFD fd, FD payloadFd, size_t &totalWritten) {
+  SizeType marker = SHARED_PAYLOAD_FRAME;
+  iovec iov{&marker, sizeof(marker)};
+  alignas(cmsghdr) char control[CMSG_SPACE(sizeof(FD))];
+  msghdr msg{};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+  auto cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(FD));
+  memcpy(CMSG_DATA(cmsg), &payloadFd, sizeof(FD));
+  ssize_t n;
+  do {
+    n = sendmsg(fd, &msg, MSG_NOSIGNAL);
+  } while (n < 0 && errno == EINTR);
+  if (n > 0) {
+    totalWritten += static_cast<size_t>(n);
   }
-  return fd != INVALID_FD;
+  return n == static_cast<ssize_t>(sizeof(marker));
 }
+
 }  // namespace
 
+LocalIPCBufferSenderImpl::LocalIPCBufferSenderImpl(
+    Mode mode, size_t sharedPayloadThreshold,
+    std::chrono::microseconds batchDelay, size_t batchBytes,
+    std::chrono::milliseconds retryInterval,
+    std::chrono::milliseconds heartbeatInterval)
+    : mode_{mode},
+      sharedPayloadThreshold_{sharedPayloadThreshold},
+      batchDelay_{batchDelay},
+      batchBytes_{batchBytes},
+      retryInterval_{retryInterval},
+      heartbeatInterval_{heartbeatInterval} {
+  if (mode_ == Mode::Batched) {
+    flusher_ = std::thread{[this] { runFlusher(); }};
+  }
+}
+
+LocalIPCBufferSenderImpl::~LocalIPCBufferSenderImpl() {
+  {
+    std::lock_guard lock(watchesMutex_);
+    watcherStopped_ = true;
+  }
+  if (watcher_.joinable()) {
+    eventfd_write(fdWatchWakeup_, 1);
+    watcher_.join();
+  }
+  {
+    std::lock_guard lock(flushMutex_);
+    stopped_ = true;
+  }
+  flushCondition_.notify_one();
+  if (flusher_.joinable()) {
+    // Flushes what is still queued before leaving
+    flusher_.join();
+  }
+}
+
 ActionCallStatus LocalIPCBufferSenderImpl::send(const Buffer &payload,
                                                 const Address &destination) {
   return send(payload, destination.get_name());
@@ -41,49 +101,376 @@ Availability LocalIPCBufferSenderImpl::checkReceiverStatus(
                                     : Availability::Unavailable;
 }
 
+bool LocalIPCBufferSenderImpl::watchReceiver(const Address &destination,
+                                             StatusCallback callback) {
+  auto sockpath = destination.get_name();
+  std::lock_guard lock(watchesMutex_);
+  if (auto it = watches_.find(sockpath); it != watches_.end()) {
+    // Callbacks run with the lock held, none is running from here
+    epoll_ctl(fdWatchEpoll_, EPOLL_CTL_DEL, it->second.fd, nullptr);
+    watches_.erase(it);
+  }
+  if (!callback) {
+    return true;
+  }
+
+  if (!watcher_.joinable()) {
+    fdWatchEpoll_ = epoll_create1(EPOLL_CLOEXEC);
+    fdWatchWakeup_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = fdWatchWakeup_;
+    if (fdWatchEpoll_ == INVALID_FD || fdWatchWakeup_ == INVALID_FD ||
+        epoll_ctl(fdWatchEpoll_, EPOLL_CTL_ADD, fdWatchWakeup_, &ev) != 0) {
+      MAF_SOCKET_ERROR("Could not set up watching of receivers");
+      fdWatchEpoll_.reset();
+      fdWatchWakeup_.reset();
+      return false;
+    }
+    watcher_ = std::thread{[this] { runWatcher(); }};
+  }
+  auto &watch = watches_[sockpath];
+  watch.callback = std::move(callback);
+  watch.nextCheck = Clock::now();
+  eventfd_write(fdWatchWakeup_, 1);
+  return true;
+}
+
 ActionCallStatus LocalIPCBufferSenderImpl::send(const Buffer &payload,
                                                 const SocketPath &sockpath) {
-  ActionCallStatus acs = ActionCallStatus::FailedUnknown;
+  counters_.messages.fetch_add(1, relaxed);
+  switch (mode_) {
+    case Mode::OneShot:
+      return sendOneShot(payload, sockpath);
+    case Mode::Batched:
+      return sendBatched(payload, sockpath);
+    default:
+      return sendPersistent(payload, sockpath);
+  }
+}
+
+ActionCallStatus LocalIPCBufferSenderImpl::sendOneShot(
+    const Buffer &payload, const SocketPath &sockpath) {
   if (auto fd = connectToSocket(sockpath); fd != INVALID_FD) {
-    SizeType totalWritten = 0;
+    size_t totalWritten = 0;
+    if (writeFrame(fd, payload, totalWritten)) {
+      return ActionCallStatus::Success;
+    }
+    MAF_SOCKET_ERROR("Failed to send payload of ", payload.length(),
+                     " bytes to receiver, sent was ", totalWritten);
+    return ActionCallStatus::FailedUnknown;
+  }
+  return ActionCallStatus::ReceiverUnavailable;
+}
+
+ActionCallStatus LocalIPCBufferSenderImpl::sendPersistent(
+    const Buffer &payload, const SocketPath &sockpath) {
+  auto connection = connectionTo(sockpath);
+  std::lock_guard lock(connection->mutex);
+  // The kept connection may have been closed by the receiver since the last
+  // message, then the message goes on a new one. If the frame was partly
+  // written the receiver drops it, so it is not resent
+  for (int attempt = 0; attempt < 2; ++attempt) {
+    auto reused = connection->fd != INVALID_FD;
+    if (!reused) {
+      connection->fd = connectToSocket(sockpath);
+      if (connection->fd == INVALID_FD) {
+        return ActionCallStatus::ReceiverUnavailable;
+      }
+    }
+
+    size_t totalWritten = 0;
+    if (writeFrame(connection->fd, payload, totalWritten)) {
+      return ActionCallStatus::Success;
+    }
+    connection->fd.reset();
+    if (!reused || totalWritten != 0) {
+      MAF_SOCKET_ERROR("Failed to send payload of ", payload.length(),
+                       " bytes to receiver, sent was ", totalWritten);
+      return ActionCallStatus::FailedUnknown;
+    }
+  }
+  return ActionCallStatus::FailedUnknown;
+}
+
+ActionCallStatus LocalIPCBufferSenderImpl::sendBatched(
+    const Buffer &payload, const SocketPath &sockpath) {
+  auto connection = connectionTo(sockpath);
+  std::lock_guard lock(connection->mutex);
+  // Connecting now tells right away whether the receiver is there, a batch
+  // failing later is only logged
+  if (connection->fd == INVALID_FD) {
+    connection->fd = connectToSocket(sockpath);
+    if (connection->fd == INVALID_FD) {
+      return ActionCallStatus::ReceiverUnavailable;
+    }
+  }
+
+  size_t totalWritten = 0;
+  if (payload.length() >= sharedPayloadThreshold_) {
+    // Queued frames go first to keep the order
+    if (flushBatch(*connection) &&
+        writeFrame(connection->fd, payload, totalWritten)) {
+      return ActionCallStatus::Success;
+    }
+  } else {
+    auto &batch = connection->batch;
+    auto firstQueued = batch.empty();
     SizeType payloadSize = static_cast<SizeType>(payload.length());
+    batch.append(reinterpret_cast<const char *>(&payloadSize),
+                 sizeof(SizeType));
+    batch.append(payload);
+    if (batch.size() < batchBytes_) {
+      if (firstQueued) {
+        scheduleFlush(connection);
+      }
+      return ActionCallStatus::Success;
+    } else if (flushBatch(*connection)) {
+      return ActionCallStatus::Success;
+    }
+  }
+  MAF_SOCKET_ERROR("Failed to send payload of ", payload.length(),
+                   " bytes to receiver");
+  connection->fd.reset();
+  return ActionCallStatus::FailedUnknown;
+}
+
+bool LocalIPCBufferSenderImpl::writeFrame(SockFD fd, const Buffer &payload,
+                                          size_t &totalWritten) {
+  if (payload.length() >= sharedPayloadThreshold_) {
+    if (auto payloadFd = createSharedPayload(payload);
+        payloadFd != INVALID_FD) {
+      counters_.syscalls.fetch_add(1, relaxed);
+      return writeSharedFrame(fd, payloadFd, totalWritten);
+    }
+    // Out of memfds, the socket still works
+  }
+  // A frame is the payload size followed by the payload, in one write
+  SizeType payloadSize = static_cast<SizeType>(payload.length());
+  iovec iov[] = {{&payloadSize, sizeof(SizeType)},
+                 {const_cast<char *>(payload.data()), payload.length()}};
+  return writeAll(fd, iov, 2, totalWritten);
+}
 
-    // First write is to send payload size to receiver to reserve a buffer
-    if (auto written = ns_global::write(
-            fd, reinterpret_cast<char *>(&payloadSize), sizeof(SizeType));
-        written == sizeof(SizeType)) {
-      // Second write is to send payload content
-      do {
-        if (written = ns_global::write(fd, payload.data() + totalWritten,
-                                       payloadSize - totalWritten);
-            written != -1) {
-          totalWritten += written;
-        } else {
-          MAF_SOCKET_ERROR("Failed to send bytes to receiver, total written = ",
-                           totalWritten);
-          acs = ActionCallStatus::FailedUnknown;
+bool LocalIPCBufferSenderImpl::writeAll(SockFD fd, iovec *iov, size_t count,
+                                        size_t &totalWritten) {
+  msghdr msg{};
+  while (count != 0) {
+    msg.msg_iov = iov;
+    msg.msg_iovlen = count;
+    // MSG_NOSIGNAL: a receiver gone away must not kill the process with
+    // SIGPIPE, the error is reported by EPIPE instead
+    auto n = sendmsg(fd, &msg, MSG_NOSIGNAL);
+    counters_.syscalls.fetch_add(1, relaxed);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    totalWritten += static_cast<size_t>(n);
+    counters_.bytes.fetch_add(static_cast<uint64_t>(n), relaxed);
+    // Skip what is written, the socket buffer may have taken only a part
+    auto written = static_cast<size_t>(n);
+    while (count != 0 && written >= iov->iov_len) {
+      written -= iov->iov_len;
+      ++iov;
+      --count;
+    }
+    if (count != 0) {
+      iov->iov_base = static_cast<char *>(iov->iov_base) + written;
+      iov->iov_len -= written;
+    }
+  }
+  return true;
+}
+
+bool LocalIPCBufferSenderImpl::flushBatch(Connection &connection) {
+  if (connection.batch.empty()) {
+    return true;
+  }
+  size_t totalWritten = 0;
+  iovec iov{connection.batch.data(), connection.batch.size()};
+  auto written = writeAll(connection.fd, &iov, 1, totalWritten);
+  // Keeps its capacity for the next batch
+  connection.batch.clear();
+  return written;
+}
+
+void LocalIPCBufferSenderImpl::scheduleFlush(ConnectionPtr connection) {
+  {
+    std::lock_guard lock(flushMutex_);
+    flushQueue_.emplace_back(Clock::now() + batchDelay_, std::move(connection));
+  }
+  flushCondition_.notify_one();
+}
+
+void LocalIPCBufferSenderImpl::runFlusher() {
+  std::unique_lock lock(flushMutex_);
+  while (true) {
+    if (flushQueue_.empty()) {
+      if (stopped_) {
+        return;
+      }
+      flushCondition_.wait(lock);
+      continue;
+    }
+    // Deadlines come in order since the delay is the same for all
+    if (auto due = flushQueue_.front().first; !stopped_ && Clock::now() < due) {
+      flushCondition_.wait_until(lock, due);
+      continue;
+    }
+    auto connection = std::move(flushQueue_.front().second);
+    flushQueue_.pop_front();
+    lock.unlock();
+    {
+      std::lock_guard connectionLock(connection->mutex);
+      if (!flushBatch(*connection)) {
+        MAF_SOCKET_ERROR("Failed to send batched frames to receiver");
+        connection->fd.reset();
+      }
+    }
+    lock.lock();
+  }
+}
+
+void LocalIPCBufferSenderImpl::runWatcher() {
+  static constexpr int MAX_EVENTS = 16;
+  epoll_event events[MAX_EVENTS];
+  int timeoutMs = 0;
+  while (true) {
+    auto count = epoll_wait(fdWatchEpoll_, events, MAX_EVENTS, timeoutMs);
+    counters_.syscalls.fetch_add(1, relaxed);
+    std::lock_guard lock(watchesMutex_);
+    if (watcherStopped_) {
+      return;
+    }
+    auto now = Clock::now();
+    for (int i = 0; i < count; ++i) {
+      auto fd = events[i].data.fd;
+      if (fd == fdWatchWakeup_) {
+        eventfd_t value;
+        eventfd_read(fdWatchWakeup_, &value);
+        continue;
+      }
+      for (auto &[sockpath, watch] : watches_) {
+        if (watch.fd == fd) {
+          setUnavailable(watch, now);
           break;
         }
-      } while (totalWritten < payloadSize);
+      }
+    }
 
-      acs = ActionCallStatus::Success;
+    auto nextCheck = Clock::time_point::max();
+    for (auto &[sockpath, watch] : watches_) {
+      if (watch.nextCheck <= now) {
+        checkWatch(sockpath, watch, now);
+      }
+      nextCheck = std::min(nextCheck, watch.nextCheck);
+    }
+    if (nextCheck == Clock::time_point::max()) {
+      timeoutMs = -1;
     } else {
-      MAF_SOCKET_ERROR("Failed to send payload size[", payloadSize,
-                       "] to receiver");
+      auto wait = std::chrono::ceil<std::chrono::milliseconds>(nextCheck -
+                                                               Clock::now());
+      timeoutMs = static_cast<int>(std::max<long long>(wait.count(), 0));
     }
+  }
+}
 
-    if (acs != ActionCallStatus::Success) {
-      if (totalWritten == 0) {
-      } else {
-        // ec = FailedUnknown, must provide more info for debugging purpose
-        MAF_LOGGER_ERROR("Failed to send payload to receiver, expected is ",
-                         sizeof(SizeType), ", sent was ", totalWritten);
-      }
+void LocalIPCBufferSenderImpl::checkWatch(const SocketPath &sockpath,
+                                          Watch &watch,
+                                          Clock::time_point now) {
+  if (watch.status == Availability::Available) {
+    // Only due when heartbeats are on
+    if (writeHeartbeat(sockpath, watch.fd)) {
+      watch.nextCheck = now + heartbeatInterval_;
+    } else {
+      setUnavailable(watch, now);
     }
-  } else {
-    acs = ActionCallStatus::ReceiverUnavailable;
+    return;
+  }
+
+  if (watch.fd = connectWatched(sockpath); watch.fd != INVALID_FD) {
+    epoll_event ev{};
+    ev.events = EPOLLRDHUP;
+    ev.data.fd = watch.fd;
+    if (epoll_ctl(fdWatchEpoll_, EPOLL_CTL_ADD, watch.fd, &ev) == 0) {
+      watch.status = Availability::Available;
+      watch.nextCheck = heartbeatInterval_.count() != 0
+                            ? now + heartbeatInterval_
+                            : Clock::time_point::max();
+      watch.callback(Availability::Available);
+      return;
+    }
+    MAF_SOCKET_ERROR("Could not watch connection to ", sockpath);
+    watch.fd.reset();
+  }
+  watch.retryDelay =
+      std::min(std::max(watch.retryDelay * 2, FIRST_RETRY_DELAY),
+               retryInterval_);
+  watch.nextCheck = now + watch.retryDelay;
+}
+
+void LocalIPCBufferSenderImpl::setUnavailable(Watch &watch,
+                                              Clock::time_point now) {
+  // The sending side may still hold the connection, then closing this fd
+  // alone would not remove it from the epoll set
+  epoll_ctl(fdWatchEpoll_, EPOLL_CTL_DEL, watch.fd, nullptr);
+  watch.fd.reset();
+  watch.retryDelay = FIRST_RETRY_DELAY;
+  watch.nextCheck = now + watch.retryDelay;
+  if (watch.status == Availability::Available) {
+    watch.status = Availability::Unavailable;
+    watch.callback(Availability::Unavailable);
+  }
+}
+
+AutoCloseFD<SockFD> LocalIPCBufferSenderImpl::connectWatched(
+    const SocketPath &sockpath) {
+  // Failing to connect is expected here, the receiver is not up yet
+  if (mode_ == Mode::OneShot) {
+    // No connection is kept for sending, the watch holds its own
+    return connectToSocket(sockpath, false);
+  }
+  // Watch the connection messages go through instead of opening another
+  auto connection = connectionTo(sockpath);
+  std::lock_guard lock(connection->mutex);
+  if (connection->fd != INVALID_FD && peerClosed(connection->fd)) {
+    connection->fd.reset();
+  }
+  if (connection->fd == INVALID_FD) {
+    connection->fd = connectToSocket(sockpath, false);
+    if (connection->fd == INVALID_FD) {
+      return {};
+    }
+  }
+  return fcntl(connection->fd, F_DUPFD_CLOEXEC, 0);
+}
+
+bool LocalIPCBufferSenderImpl::writeHeartbeat(const SocketPath &sockpath,
+                                              SockFD fd) {
+  // Must not land inside a frame being written on the same connection
+  auto connection = connectionTo(sockpath);
+  std::lock_guard lock(connection->mutex);
+  SizeType emptyFrame = 0;
+  // A write this small is never split. A full socket buffer means the
+  // receiver is busy, not gone
+  auto n = ::send(fd, &emptyFrame, sizeof(emptyFrame),
+                  MSG_DONTWAIT | MSG_NOSIGNAL);
+  counters_.syscalls.fetch_add(1, relaxed);
+  return n == sizeof(emptyFrame) ||
+         (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR));
+}
+
+LocalIPCBufferSenderImpl::ConnectionPtr
+LocalIPCBufferSenderImpl::connectionTo(const SocketPath &sockpath) {
+  std::lock_guard lock(connectionsMutex_);
+  auto &connection = connections_[sockpath];
+  if (!connection) {
+    connection = std::make_shared<Connection>();
   }
-  return acs;
+  return connection;
 }
 
 }  // namespace local
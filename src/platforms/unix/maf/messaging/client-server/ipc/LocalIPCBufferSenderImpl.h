@@ -3,6 +3,16 @@
 #include <maf/messaging/client-server/CSStatus.h>
 #include <maf/utils/serialization/Buffer.h>
 
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
 #include "SocketShared.h"
 
 namespace maf {
@@ -13,10 +23,94 @@ namespace local {
 class LocalIPCBufferSenderImpl {
  public:
   using Buffer = maf::srz::Buffer;
+  using Clock = std::chrono::steady_clock;
+  using StatusCallback = std::function<void(Availability)>;
+
+  //! OneShot connects for each message. Persistent keeps one connection per
+  //! destination open and frames the messages on it. Batched also packs the
+  //! frames queued for a destination into one write, made once batchBytes
+  //! are queued or batchDelay after the first of them
+  enum class Mode : char { OneShot, Persistent, Batched };
 
+  //! Payloads from sharedPayloadThreshold bytes on are passed as memfd
+  explicit LocalIPCBufferSenderImpl(
+      Mode mode = Mode::Persistent,
+      size_t sharedPayloadThreshold = std::numeric_limits<size_t>::max(),
+      std::chrono::microseconds batchDelay = {}, size_t batchBytes = 0,
+      std::chrono::milliseconds retryInterval = std::chrono::milliseconds{500},
+      std::chrono::milliseconds heartbeatInterval = {});
+  ~LocalIPCBufferSenderImpl();
   ActionCallStatus send(const Buffer &payload, const Address &destination);
   ActionCallStatus send(const Buffer &payload, const SocketPath &sockpath);
   Availability checkReceiverStatus(const Address &destination) const;
+  bool watchReceiver(const Address &destination, StatusCallback callback);
+  const IOCounters &counters() const { return counters_; }
+
+ private:
+  // Writes of one connection are serialized to keep the frames intact
+  struct Connection {
+    std::mutex mutex;
+    AutoCloseFD<SockFD> fd;
+    // Frames waiting to be written together, batched mode only
+    Buffer batch;
+  };
+  using ConnectionPtr = std::shared_ptr<Connection>;
+
+  // A watched receiver is up while a connection to it is open, its hangup
+  // tells the receiver went away
+  struct Watch {
+    StatusCallback callback;
+    Availability status = Availability::Unavailable;
+    AutoCloseFD<SockFD> fd;
+    std::chrono::milliseconds retryDelay{};
+    Clock::time_point nextCheck;
+  };
+
+  ActionCallStatus sendOneShot(const Buffer &payload,
+                               const SocketPath &sockpath);
+  ActionCallStatus sendPersistent(const Buffer &payload,
+                                  const SocketPath &sockpath);
+  ActionCallStatus sendBatched(const Buffer &payload,
+                               const SocketPath &sockpath);
+  ConnectionPtr connectionTo(const SocketPath &sockpath);
+
+  bool writeFrame(SockFD fd, const Buffer &payload, size_t &totalWritten);
+  bool writeAll(SockFD fd, iovec *iov, size_t count, size_t &totalWritten);
+  bool flushBatch(Connection &connection);
+  void scheduleFlush(ConnectionPtr connection);
+  void runFlusher();
+
+  void runWatcher();
+  void checkWatch(const SocketPath &sockpath, Watch &watch,
+                  Clock::time_point now);
+  void setUnavailable(Watch &watch, Clock::time_point now);
+  AutoCloseFD<SockFD> connectWatched(const SocketPath &sockpath);
+  bool writeHeartbeat(const SocketPath &sockpath, SockFD fd);
+
+  Mode mode_;
+  size_t sharedPayloadThreshold_;
+  std::chrono::microseconds batchDelay_;
+  size_t batchBytes_;
+  IOCounters counters_;
+  std::mutex connectionsMutex_;
+  std::unordered_map<SocketPath, ConnectionPtr> connections_;
+
+  // Batches to flush when their delay is over, in deadline order
+  std::mutex flushMutex_;
+  std::condition_variable flushCondition_;
+  std::deque<std::pair<Clock::time_point, ConnectionPtr>> flushQueue_;
+  bool stopped_ = false;
+  std::thread flusher_;
+
+  // Watched receivers, served by one thread started with the first of them
+  std::chrono::milliseconds retryInterval_;
+  std::chrono::milliseconds heartbeatInterval_;
+  std::mutex watchesMutex_;
+  std::unordered_map<SocketPath, Watch> watches_;
+  AutoCloseFD<FD> fdWatchEpoll_;
+  AutoCloseFD<FD> fdWatchWakeup_;
+  bool watcherStopped_ = false;
+  std::thread watcher_;
 };
 
 }  // namespace local
@@ -0,0 +1,441 @@
+#include "LocalIPCQueuedSenderImpl.h"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#include <algorithm>
+
+#include "SharedPayload.h"
+
+namespace maf {
+namespace messaging {
+namespace ipc {
+namespace local {
+
+namespace {
+
+static constexpr int MAX_EVENTS = 64;
+// Frames gathered into one write
+static constexpr size_t MAX_WRITE_FRAMES = 32;
+
+}  // namespace
+
+LocalIPCQueuedSenderImpl::LocalIPCQueuedSenderImpl(Policy policy,
+                                                   size_t maxQueued,
+                                                   size_t sharedPayloadThreshold)
+    : policy_{policy},
+      maxQueued_{std::max<size_t>(maxQueued, 1)},
+      sharedPayloadThreshold_{sharedPayloadThreshold} {
+  fdEpoll_ = epoll_create1(EPOLL_CLOEXEC);
+  fdWakeup_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  epoll_event ev{};
+  ev.events = EPOLLIN;
+  ev.data.ptr = nullptr;
+  if (fdEpoll_ == INVALID_FD || fdWakeup_ == INVALID_FD ||
+      epoll_ctl(fdEpoll_, EPOLL_CTL_ADD, fdWakeup_, &ev) != 0) {
+    MAF_SOCKET_ERROR("Could not set up queued sender");
+  } else {
+    io_ = std::thread{[this] { runIO(); }};
+  }
+}
+
+LocalIPCQueuedSenderImpl::~LocalIPCQueuedSenderImpl() {
+  stopped_ = true;
+  if (io_.joinable()) {
+    eventfd_write(fdWakeup_, 1);
+    io_.join();
+  }
+}
+
+ActionCallStatus LocalIPCQueuedSenderImpl::send(
+    std::shared_ptr<const Buffer> payload, const Address &destination) {
+  if (!io_.joinable()) {
+    return ActionCallStatus::FailedUnknown;
+  }
+  Frame frame{std::move(payload), {}};
+  if (frame.bytes->size() >= sharedPayloadThreshold_) {
+    frame.payloadFd = sharedPayloadOf(frame.bytes);
+  }
+
+  while (true) {
+    auto dest = destinationTo(destination);
+    std::unique_lock lock(dest->mutex);
+    if (dest->removed) {
+      continue;
+    }
+    if (dest->fd == INVALID_FD && !connect(*dest)) {
+      forget(destination);
+      return ActionCallStatus::ReceiverUnavailable;
+    }
+    if (dest->queue.size() >= maxQueued_ && !makeSpace(*dest, lock)) {
+      return ActionCallStatus::ReceiverUnavailable;
+    }
+
+    dest->queue.push_back(std::move(frame));
+    auto &counters = dest->counters;
+    counters.maxDepth = std::max(counters.maxDepth, dest->queue.size());
+    if (!dest->scheduled && !dest->waitingWritable) {
+      schedule(*dest);
+    }
+    return ActionCallStatus::Success;
+  }
+}
+
+Availability LocalIPCQueuedSenderImpl::checkReceiverStatus(
+    const Address &destination) const {
+  auto sockaddr = createUnixAbstractSocketAddr(destination.get_name());
+  return connectable(&sockaddr) ? Availability::Available
+                                : Availability::Unavailable;
+}
+
+std::vector<std::pair<Address, LocalIPCQueuedSenderImpl::QueueCounters>>
+LocalIPCQueuedSenderImpl::queueCounters() const {
+  std::vector<std::pair<Address, QueueCounters>> result;
+  std::lock_guard lock(destinationsMutex_);
+  for (auto &[sockpath, dest] : destinations_) {
+    std::lock_guard destLock(dest->mutex);
+    auto counters = dest->counters;
+    counters.depth = dest->queue.size();
+    result.emplace_back(dest->address, counters);
+  }
+  return result;
+}
+
+void LocalIPCQueuedSenderImpl::setReceiverGoneCallback(
+    std::function<void(const Address &)> callback) {
+  std::lock_guard lock(destinationsMutex_);
+  receiverGone_ = std::move(callback);
+}
+
+LocalIPCQueuedSenderImpl::DestinationPtr
+LocalIPCQueuedSenderImpl::destinationTo(const Address &destination) {
+  std::lock_guard lock(destinationsMutex_);
+  auto &dest = destinations_[destination.get_name()];
+  if (!dest) {
+    dest = std::make_shared<Destination>();
+    dest->address = destination;
+  }
+  return dest;
+}
+
+LocalIPCQueuedSenderImpl::PayloadFDPtr
+LocalIPCQueuedSenderImpl::sharedPayloadOf(
+    const std::shared_ptr<const Buffer> &payload) {
+  {
+    std::lock_guard lock(sharedPayloadMutex_);
+    if (lastSharedBytes_.lock() == payload) {
+      if (auto fd = lastSharedFd_.lock()) {
+        return fd;
+      }
+    }
+  }
+  auto fd = std::make_shared<AutoCloseFD<FD>>(createSharedPayload(*payload));
+  if (*fd == INVALID_FD) {
+    // Out of memfds, the socket still works
+    return {};
+  }
+  std::lock_guard lock(sharedPayloadMutex_);
+  lastSharedBytes_ = payload;
+  lastSharedFd_ = fd;
+  return fd;
+}
+
+bool LocalIPCQueuedSenderImpl::connect(Destination &dest) {
+  dest.fd = connectToSocket(dest.address.get_name());
+  if (dest.fd == INVALID_FD) {
+    return false;
+  }
+  // Hangup only for now, writability is watched once a write would block
+  epoll_event ev{};
+  ev.events = EPOLLRDHUP;
+  ev.data.ptr = &dest;
+  if (epoll_ctl(fdEpoll_, EPOLL_CTL_ADD, dest.fd, &ev) != 0) {
+    MAF_SOCKET_ERROR("Could not watch connection to ", dest.address.dump());
+    dest.fd.reset();
+    return false;
+  }
+  dest.waitingWritable = false;
+  return true;
+}
+
+void LocalIPCQueuedSenderImpl::close(Destination &dest) {
+  // Out of the epoll set first, the destination may be freed afterwards
+  if (dest.fd != INVALID_FD) {
+    epoll_ctl(fdEpoll_, EPOLL_CTL_DEL, dest.fd, nullptr);
+    dest.fd.reset();
+  }
+  dest.counters.dropped += dest.queue.size();
+  dest.queue.clear();
+  dest.headWritten = 0;
+  dest.waitingWritable = false;
+  dest.spaceAvailable.notify_all();
+}
+
+bool LocalIPCQueuedSenderImpl::makeSpace(Destination &dest,
+                                         std::unique_lock<std::mutex> &lock) {
+  switch (policy_) {
+    case Policy::DropOldest: {
+      // The first frame stays if its start is written already
+      auto oldest = dest.queue.begin() + (dest.headWritten != 0 ? 1 : 0);
+      if (oldest != dest.queue.end()) {
+        dest.queue.erase(oldest);
+        ++dest.counters.dropped;
+      }
+      return true;
+    }
+    case Policy::DropClient:
+      MAF_LOGGER_WARN("Receiver ", dest.address.dump(),
+                      " does not keep up, dropping it with ",
+                      dest.queue.size(), " queued messages");
+      close(dest);
+      return false;
+    default:
+      dest.spaceAvailable.wait(lock, [&dest, this] {
+        return dest.queue.size() < maxQueued_ || dest.fd == INVALID_FD ||
+               stopped_;
+      });
+      return dest.fd != INVALID_FD && !stopped_;
+  }
+}
+
+// A client dropped for being slow is not forgotten, the next send connects
+// to it again and its counters go on
+void LocalIPCQueuedSenderImpl::forget(const Address &destination) {
+  {
+    std::lock_guard lock(scheduledMutex_);
+    forgotten_.push_back(destination);
+  }
+  eventfd_write(fdWakeup_, 1);
+}
+
+void LocalIPCQueuedSenderImpl::removeForgotten() {
+  std::vector<Address> forgotten;
+  {
+    std::lock_guard lock(scheduledMutex_);
+    forgotten.swap(forgotten_);
+  }
+  if (forgotten.empty()) {
+    return;
+  }
+  std::vector<Address> removed;
+  std::function<void(const Address &)> receiverGone;
+  {
+    std::lock_guard lock(destinationsMutex_);
+    for (auto &address : forgotten) {
+      auto it = destinations_.find(address.get_name());
+      if (it == destinations_.end()) {
+        continue;
+      }
+      auto dest = it->second;
+      std::lock_guard destLock(dest->mutex);
+      // A send may have connected again meanwhile
+      if (dest->fd == INVALID_FD && dest->queue.empty() && !dest->scheduled) {
+        dest->removed = true;
+        destinations_.erase(it);
+        removed.push_back(std::move(address));
+      }
+    }
+    receiverGone = receiverGone_;
+  }
+  if (receiverGone) {
+    for (auto &address : removed) {
+      receiverGone(address);
+    }
+  }
+}
+
+void LocalIPCQueuedSenderImpl::schedule(Destination &dest) {
+  dest.scheduled = true;
+  {
+    std::lock_guard lock(scheduledMutex_);
+    scheduled_.push_back(&dest);
+  }
+  eventfd_write(fdWakeup_, 1);
+}
+
+void LocalIPCQueuedSenderImpl::runIO() {
+  epoll_event events[MAX_EVENTS];
+  std::vector<Destination *> scheduled;
+  while (!stopped_) {
+    auto count = epoll_wait(fdEpoll_, events, MAX_EVENTS, -1);
+    if (count < 0 && errno != EINTR) {
+      MAF_SOCKET_ERROR("Queued sender failed waiting for connections");
+      break;
+    }
+    for (int i = 0; i < count; ++i) {
+      auto dest = static_cast<Destination *>(events[i].data.ptr);
+      if (!dest) {
+        eventfd_t value;
+        eventfd_read(fdWakeup_, &value);
+        continue;
+      }
+      std::lock_guard lock(dest->mutex);
+      if (events[i].events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+        close(*dest);
+        forget(dest->address);
+      } else {
+        flush(*dest);
+      }
+    }
+
+    {
+      std::lock_guard lock(scheduledMutex_);
+      scheduled.swap(scheduled_);
+    }
+    for (auto dest : scheduled) {
+      std::lock_guard lock(dest->mutex);
+      dest->scheduled = false;
+      flush(*dest);
+    }
+    scheduled.clear();
+    // The events of this round are handled, none of them points to a
+    // destination freed here
+    removeForgotten();
+  }
+
+  // What the receivers can take right away still goes, then the senders
+  // waiting for space are woken
+  std::lock_guard lock(destinationsMutex_);
+  for (auto &[sockpath, dest] : destinations_) {
+    std::lock_guard destLock(dest->mutex);
+    flush(*dest);
+    dest->spaceAvailable.notify_all();
+  }
+}
+
+void LocalIPCQueuedSenderImpl::flush(Destination &dest) {
+  SizeType sizes[MAX_WRITE_FRAMES];
+  iovec iov[MAX_WRITE_FRAMES * 2];
+  msghdr msg{};
+  msg.msg_iov = iov;
+  auto spaceWasFull = dest.queue.size() >= maxQueued_;
+  while (dest.fd != INVALID_FD && !dest.queue.empty()) {
+    // The fd of a shared payload goes alone with the start of its marker
+    if (dest.queue.front().payloadFd && dest.headWritten == 0) {
+      if (!flushSharedFrame(dest)) {
+        break;
+      }
+      continue;
+    }
+
+    size_t iovCount = 0;
+    size_t frames = std::min(dest.queue.size(), MAX_WRITE_FRAMES);
+    for (size_t i = 0; i < frames; ++i) {
+      auto &frame = dest.queue[i];
+      if (frame.payloadFd) {
+        if (i != 0) {
+          break;
+        }
+        sizes[i] = SHARED_PAYLOAD_FRAME;
+        iov[iovCount++] = {&sizes[i], sizeof(SizeType)};
+        continue;
+      }
+      sizes[i] = static_cast<SizeType>(frame.bytes->size());
+      iov[iovCount++] = {&sizes[i], sizeof(SizeType)};
+      iov[iovCount++] = {const_cast<char *>(frame.bytes->data()),
+                         frame.bytes->size()};
+    }
+    // Skip what is written of the first frame
+    if (auto skip = dest.headWritten; skip < sizeof(SizeType)) {
+      iov[0].iov_base = reinterpret_cast<char *>(&sizes[0]) + skip;
+      iov[0].iov_len -= skip;
+    } else {
+      iov[0].iov_len = 0;
+      iov[1].iov_base = static_cast<char *>(iov[1].iov_base) +
+                        (skip - sizeof(SizeType));
+      iov[1].iov_len -= skip - sizeof(SizeType);
+    }
+    msg.msg_iovlen = iovCount;
+
+    auto n = sendmsg(dest.fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        watchWritable(dest, true);
+        break;
+      }
+      MAF_SOCKET_ERROR("Failed to send queued frames to ",
+                       dest.address.dump());
+      close(dest);
+      forget(dest.address);
+      return;
+    }
+    popWritten(dest, static_cast<size_t>(n));
+  }
+  if (dest.fd != INVALID_FD && dest.queue.empty() && dest.waitingWritable) {
+    watchWritable(dest, false);
+  }
+  if (spaceWasFull && dest.queue.size() < maxQueued_) {
+    dest.spaceAvailable.notify_all();
+  }
+}
+
+// Returns false if nothing more can be written now
+bool LocalIPCQueuedSenderImpl::flushSharedFrame(Destination &dest) {
+  FD payloadFd = *dest.queue.front().payloadFd;
+  SizeType marker = SHARED_PAYLOAD_FRAME;
+  iovec iov{&marker, sizeof(marker)};
+  alignas(cmsghdr) char control[CMSG_SPACE(sizeof(FD))];
+  msghdr msg{};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+  auto cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(FD));
+  memcpy(CMSG_DATA(cmsg), &payloadFd, sizeof(FD));
+
+  ssize_t n;
+  do {
+    n = sendmsg(dest.fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+  } while (n < 0 && errno == EINTR);
+  if (n < 0) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      watchWritable(dest, true);
+    } else {
+      MAF_SOCKET_ERROR("Failed to send shared payload to ",
+                       dest.address.dump());
+      close(dest);
+      forget(dest.address);
+    }
+    return false;
+  }
+  popWritten(dest, static_cast<size_t>(n));
+  return true;
+}
+
+void LocalIPCQueuedSenderImpl::popWritten(Destination &dest, size_t written) {
+  while (written != 0) {
+    auto frameLeft = dest.queue.front().size() - dest.headWritten;
+    if (written < frameLeft) {
+      dest.headWritten += written;
+      break;
+    }
+    written -= frameLeft;
+    dest.queue.pop_front();
+    dest.headWritten = 0;
+    ++dest.counters.sent;
+  }
+}
+
+void LocalIPCQueuedSenderImpl::watchWritable(Destination &dest,
+                                             bool writable) {
+  epoll_event ev{};
+  ev.events = writable ? EPOLLRDHUP | EPOLLOUT : EPOLLRDHUP;
+  ev.data.ptr = &dest;
+  if (epoll_ctl(fdEpoll_, EPOLL_CTL_MOD, dest.fd, &ev) == 0) {
+    dest.waitingWritable = writable;
+  } else {
+    MAF_SOCKET_ERROR("Could not watch connection to ", dest.address.dump());
+    close(dest);
+    forget(dest.address);
+  }
+}
+
+}  // namespace local
+}  // namespace ipc
+}  // namespace messaging
+}  // namespace maf
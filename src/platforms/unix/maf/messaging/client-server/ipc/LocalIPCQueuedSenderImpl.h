@@ -0,0 +1,127 @@
+#pragma once
+
+#include <maf/messaging/client-server/CSStatus.h>
+#include <maf/utils/serialization/Buffer.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "SocketShared.h"
+
+namespace maf {
+namespace messaging {
+namespace ipc {
+namespace local {
+
+/*! \brief Sends without waiting for the receivers
+ * Frames are queued per destination and written by one I/O thread with
+ * non-blocking writes, a receiver that does not read only fills its own
+ * queue. What happens when a queue is full is set by the Policy. A frame
+ * queued for many receivers is shared, not copied, and one from
+ * sharedPayloadThreshold bytes on is passed to all of them as one memfd.
+ */
+class LocalIPCQueuedSenderImpl {
+ public:
+  using Buffer = maf::srz::Buffer;
+
+  //! DropOldest discards the oldest frame not being written yet, DropClient
+  //! closes the connection and drops the whole queue, Block waits for space
+  enum class Policy : char { DropOldest, DropClient, Block };
+
+  struct QueueCounters {
+    size_t depth = 0;
+    size_t maxDepth = 0;
+    uint64_t sent = 0;
+    uint64_t dropped = 0;
+  };
+
+  LocalIPCQueuedSenderImpl(
+      Policy policy, size_t maxQueued,
+      size_t sharedPayloadThreshold = std::numeric_limits<size_t>::max());
+  ~LocalIPCQueuedSenderImpl();
+  ActionCallStatus send(std::shared_ptr<const Buffer> payload,
+                        const Address &destination);
+  Availability checkReceiverStatus(const Address &destination) const;
+  std::vector<std::pair<Address, QueueCounters>> queueCounters() const;
+  //! Called on the I/O thread with the receivers whose destination is
+  //! removed: they hung up, or could not be written to or connected to
+  void setReceiverGoneCallback(std::function<void(const Address &)> callback);
+
+ private:
+  using PayloadFDPtr = std::shared_ptr<AutoCloseFD<FD>>;
+
+  struct Frame {
+    std::shared_ptr<const Buffer> bytes;
+    // Set if the payload goes as a memfd, only its marker is written then
+    PayloadFDPtr payloadFd;
+    size_t size() const {
+      return sizeof(SizeType) + (payloadFd ? 0 : bytes->size());
+    }
+  };
+
+  struct Destination {
+    Address address;
+    std::mutex mutex;
+    std::condition_variable spaceAvailable;
+    AutoCloseFD<SockFD> fd;
+    std::deque<Frame> queue;
+    // Bytes of the first frame, size included, already written
+    size_t headWritten = 0;
+    bool waitingWritable = false;
+    bool scheduled = false;
+    // No longer in destinations_, a sender holding it must look up again
+    bool removed = false;
+    QueueCounters counters;
+  };
+  using DestinationPtr = std::shared_ptr<Destination>;
+
+  DestinationPtr destinationTo(const Address &destination);
+  PayloadFDPtr sharedPayloadOf(const std::shared_ptr<const Buffer> &payload);
+  bool connect(Destination &dest);
+  void close(Destination &dest);
+  void forget(const Address &destination);
+  void removeForgotten();
+  bool makeSpace(Destination &dest, std::unique_lock<std::mutex> &lock);
+  void schedule(Destination &dest);
+  void runIO();
+  void flush(Destination &dest);
+  bool flushSharedFrame(Destination &dest);
+  void popWritten(Destination &dest, size_t written);
+  void watchWritable(Destination &dest, bool writable);
+
+  Policy policy_;
+  size_t maxQueued_;
+  size_t sharedPayloadThreshold_;
+  mutable std::mutex destinationsMutex_;
+  // The epoll events point to the destinations, only the I/O thread removes
+  // them, after it is done with the events of the round
+  std::unordered_map<SocketPath, DestinationPtr> destinations_;
+  std::function<void(const Address &)> receiverGone_;
+
+  // The memfd of the last large payload, reused while it is queued
+  std::mutex sharedPayloadMutex_;
+  std::weak_ptr<const Buffer> lastSharedBytes_;
+  std::weak_ptr<AutoCloseFD<FD>> lastSharedFd_;
+
+  AutoCloseFD<FD> fdEpoll_;
+  AutoCloseFD<FD> fdWakeup_;
+  std::mutex scheduledMutex_;
+  std::vector<Destination *> scheduled_;
+  // Closed destinations to remove if they are still unused
+  std::vector<Address> forgotten_;
+  std::atomic_bool stopped_ = false;
+  std::thread io_;
+};
+
+}  // namespace local
+}  // namespace ipc
+}  // namespace messaging
+}  // namespace maf
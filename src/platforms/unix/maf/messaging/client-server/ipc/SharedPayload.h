@@ -0,0 +1,79 @@
+#pragma once
+
+#include <fcntl.h>
+#include <maf/utils/serialization/Buffer.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <limits>
+
+#include "SocketShared.h"
+
+namespace maf {
+namespace messaging {
+namespace ipc {
+namespace local {
+
+// Frame size announcing a payload passed as a sealed memfd, the fd comes with
+// the size bytes
+static constexpr SizeType SHARED_PAYLOAD_FRAME =
+    std::numeric_limits<SizeType>::max();
+
+// Once sealed the payload cannot change under the receiver, nor shrink and
+// make it fault while reading
+static constexpr int SHARED_PAYLOAD_SEALS =
+    F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL;
+
+inline AutoCloseFD<FD> createSharedPayload(const srz::Buffer &payload) {
+  AutoCloseFD<FD> fd =
+      memfd_create("maf.ipc.payload", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  if (fd == INVALID_FD) {
+    MAF_SOCKET_ERROR("Could not create memfd for payload");
+    return fd;
+  }
+  size_t written = 0;
+  while (written < payload.size()) {
+    auto n = write(fd, payload.data() + written, payload.size() - written);
+    if (n > 0) {
+      written += static_cast<size_t>(n);
+    } else if (n == 0 || errno != EINTR) {
+      MAF_SOCKET_ERROR("Could not write payload to memfd");
+      fd.reset();
+      return fd;
+    }
+  }
+  if (fcntl(fd, F_ADD_SEALS, SHARED_PAYLOAD_SEALS) != 0) {
+    MAF_SOCKET_ERROR("Could not seal payload memfd");
+    fd.reset();
+  }
+  return fd;
+}
+
+//! Maps a payload received as memfd, the owner unmaps it when released.
+//! Returns no owner if the fd is not a sealed payload
+inline srz::SharedBytes mapSharedPayload(FD fd) {
+  constexpr int RequiredSeals = F_SEAL_SHRINK | F_SEAL_WRITE;
+  struct stat st;
+  auto seals = fcntl(fd, F_GET_SEALS);
+  if (seals < 0 || (seals & RequiredSeals) != RequiredSeals ||
+      fstat(fd, &st) != 0 || st.st_size <= 0) {
+    MAF_LOGGER_ERROR("Received payload fd is not a sealed memfd");
+    return {};
+  }
+  auto size = static_cast<size_t>(st.st_size);
+  auto addr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  if (addr == MAP_FAILED) {
+    MAF_SOCKET_ERROR("Could not map received payload of ", size, " bytes");
+    return {};
+  }
+  std::shared_ptr<const void> owner{addr, [size](const void *p) {
+                                      munmap(const_cast<void *>(p), size);
+                                    }};
+  return {std::move(owner),
+          std::string_view{static_cast<const char *>(addr), size}};
+}
+
+}  // namespace local
+}  // namespace ipc
+}  // namespace messaging
+}  // namespace maf
@@ -0,0 +1,281 @@
+#include "ShmBufferReceiverImpl.h"
+
+#include <maf/logging/Logger.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+namespace maf {
+namespace messaging {
+namespace ipc {
+namespace local {
+
+namespace {
+
+static constexpr int MAX_EVENTS = 64;
+static constexpr int RING_FD_COUNT = 3;
+// Bytes taken from one ring before serving the others
+static constexpr size_t DRAIN_BUDGET = ShmRing::DEFAULT_CAPACITY;
+
+static bool watch(FD epollFd, FD fd, uint32_t events) {
+  epoll_event ev{};
+  ev.events = events;
+  ev.data.fd = fd;
+  return epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) == 0;
+}
+
+// Returns the number of bytes read, the received fds are owned by fds
+static ssize_t receiveRingFds(SockFD control,
+                              AutoCloseFD<FD> (&fds)[RING_FD_COUNT]) {
+  char byte;
+  iovec iov{&byte, sizeof(byte)};
+  alignas(cmsghdr) char controlBuf[CMSG_SPACE(sizeof(FD) * RING_FD_COUNT)];
+  msghdr msg{};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = controlBuf;
+  msg.msg_controllen = sizeof(controlBuf);
+  auto n = recvmsg(control, &msg, MSG_CMSG_CLOEXEC);
+  if (n <= 0) {
+    return n;
+  }
+  for (auto cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+      auto count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(FD);
+      for (size_t i = 0; i < count; ++i) {
+        FD fd;
+        memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(FD), sizeof(FD));
+        // Extra fds are closed right away
+        AutoCloseFD<FD> received = fd;
+        if (i < RING_FD_COUNT) {
+          fds[i] = std::move(received);
+        }
+      }
+    }
+  }
+  return n;
+}
+
+}  // namespace
+
+ShmBufferReceiverImpl::~ShmBufferReceiverImpl() { stop(); }
+
+bool ShmBufferReceiverImpl::init(const Address &addr) {
+  myaddr_ = addr;
+  auto sockpath = constructShmSocketPath(myaddr_);
+  if (!isValidSocketPath(sockpath)) {
+    MAF_LOGGER_ERROR(
+        "Length of address exeeds the limitation of unix domain socket path");
+    return false;
+  }
+
+  mySockAddr_ = createUnixAbstractSocketAddr(sockpath);
+  fdMySock_ = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  fdEpoll_ = epoll_create1(EPOLL_CLOEXEC);
+  fdStopEvent_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (fdMySock_ == INVALID_FD || fdEpoll_ == INVALID_FD ||
+      fdStopEvent_ == INVALID_FD) {
+    MAF_SOCKET_ERROR("Could not create shared memory receiver");
+  } else if (bind(fdMySock_, _2sockAddr(&mySockAddr_), sizeof(mySockAddr_)) <
+             0) {
+    MAF_LOGGER_ERROR("Coud not bind socket to address ", myaddr_.dump());
+  } else if (listen(fdMySock_, SOMAXCONN) != 0 ||
+             !watch(fdEpoll_, fdMySock_, EPOLLIN | EPOLLET) ||
+             !watch(fdEpoll_, fdStopEvent_, EPOLLIN)) {
+    MAF_SOCKET_ERROR("Could not listen on socket");
+  } else {
+    MAF_LOGGER_INFO("Listening for shared memory rings on address ",
+                    myaddr_.dump());
+    setState(State::Initialized);
+    return true;
+  }
+  return false;
+}
+
+bool ShmBufferReceiverImpl::start() {
+  auto expected = State::Initialized;
+  if (!state_.compare_exchange_strong(expected, State::Running)) {
+    return false;
+  }
+  bool ok = false;
+  try {
+    ok = waitAndProcessChannels();
+  } catch (...) {
+  }
+  setState(State::Stopped);
+  closeAllChannels();
+  fdMySock_.reset();
+  return ok;
+}
+
+void ShmBufferReceiverImpl::stop() {
+  auto current = getState();
+  while (current == State::Initialized || current == State::Running) {
+    if (state_.compare_exchange_weak(current, State::Stopped)) {
+      eventfd_write(fdStopEvent_, 1);
+      break;
+    }
+  }
+}
+
+void ShmBufferReceiverImpl::deinit() {}
+
+bool ShmBufferReceiverImpl::running() const {
+  return getState() == State::Running;
+}
+
+const Address &ShmBufferReceiverImpl::address() const { return myaddr_; }
+
+void ShmBufferReceiverImpl::setObserver(BytesComeCallback callback) {
+  bytesComeCallback_ = std::move(callback);
+}
+
+bool ShmBufferReceiverImpl::waitAndProcessChannels() {
+  epoll_event events[MAX_EVENTS];
+  SockFD listeningSock = fdMySock_;
+  FD stopEvent = fdStopEvent_;
+  while (getState() == State::Running) {
+    auto count = epoll_wait(fdEpoll_, events, MAX_EVENTS, -1);
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      MAF_SOCKET_ERROR("Failed waiting for shared memory channels");
+      return false;
+    }
+
+    for (int i = 0; i < count; ++i) {
+      auto fd = events[i].data.fd;
+      if (fd == stopEvent) {
+        MAF_LOGGER_INFO("Finish running due to stop request, address: ",
+                        myaddr_.dump());
+        return true;
+      } else if (fd == listeningSock) {
+        if (!acceptChannels()) {
+          return false;
+        }
+      } else if (auto it = channels_.find(fd); it != channels_.end()) {
+        auto channel = it->second;
+        if (fd == channel->control) {
+          if (!onControlEvent(*channel)) {
+            closeChannel(channel);
+          }
+        } else {
+          eventfd_t count;
+          eventfd_read(channel->dataEvent, &count);
+          drainRing(*channel);
+        }
+      }
+    }
+  }
+  return true;
+}
+
+bool ShmBufferReceiverImpl::acceptChannels() {
+  while (true) {
+    auto acceptedSD =
+        accept4(fdMySock_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (acceptedSD == INVALID_FD) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        return true;
+      } else if (errno == EINTR || errno == ECONNABORTED) {
+        continue;
+      } else if (errno == EMFILE || errno == ENFILE) {
+        MAF_SOCKET_ERROR("Too many open files, cannot accept connection");
+        return true;
+      }
+      MAF_SOCKET_ERROR("Failed on accepting new socket connection");
+      return false;
+    }
+
+    auto channel = std::make_shared<Channel>();
+    channel->control = acceptedSD;
+    if (watch(fdEpoll_, acceptedSD, EPOLLIN | EPOLLRDHUP)) {
+      channels_.emplace(acceptedSD, std::move(channel));
+    } else {
+      MAF_SOCKET_ERROR("Could not watch new connection");
+    }
+  }
+}
+
+bool ShmBufferReceiverImpl::onControlEvent(Channel &channel) {
+  if (!channel.ring.mapped()) {
+    return attachRing(channel);
+  }
+  // Nothing else is sent on the control socket: the sender is gone, take
+  // what it wrote before leaving
+  drainRing(channel);
+  return false;
+}
+
+bool ShmBufferReceiverImpl::attachRing(Channel &channel) {
+  AutoCloseFD<FD> fds[RING_FD_COUNT];
+  auto n = receiveRingFds(channel.control, fds);
+  if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+    return true;
+  }
+  if (n <= 0) {
+    // Availability checks connect then close without sending anything
+    return false;
+  }
+  if (fds[2] == INVALID_FD || !channel.ring.attach(fds[0])) {
+    MAF_LOGGER_ERROR("Sender passed no valid shared memory ring");
+    return false;
+  }
+  channel.dataEvent = std::move(fds[1]);
+  channel.spaceEvent = std::move(fds[2]);
+  // The memfd itself is no longer needed once mapped
+  if (!watch(fdEpoll_, channel.dataEvent, EPOLLIN)) {
+    MAF_SOCKET_ERROR("Could not watch shared memory ring");
+    return false;
+  }
+  channels_.emplace(channel.dataEvent, channels_.at(channel.control));
+  drainRing(channel);
+  return true;
+}
+
+void ShmBufferReceiverImpl::drainRing(Channel &channel) {
+  auto &ring = channel.ring;
+  auto consume = [&channel, this](const char *data, size_t size) {
+    channel.frames.consume(data, size, bytesComeCallback_);
+  };
+  size_t drained = 0;
+  while (drained < DRAIN_BUDGET) {
+    auto n = ring.read(consume);
+    drained += n;
+    if (n != 0 && ring.takeProducerWaiting()) {
+      eventfd_write(channel.spaceEvent, 1);
+    }
+    if (n == 0) {
+      // Sleep only if nothing came after raising the flag
+      ring.setConsumerWaiting();
+      if (ring.available() == 0) {
+        return;
+      }
+    }
+  }
+  // Serve other rings first, this one wakes the loop again
+  eventfd_write(channel.dataEvent, 1);
+}
+
+void ShmBufferReceiverImpl::closeChannel(const ChannelPtr &channel) {
+  if (channel->ring.mapped()) {
+    channel->ring.close();
+    channels_.erase(channel->dataEvent);
+  }
+  // Closing the fds also removes them from the epoll set
+  channels_.erase(channel->control);
+}
+
+void ShmBufferReceiverImpl::closeAllChannels() {
+  for (auto &[fd, channel] : channels_) {
+    if (channel->ring.mapped()) {
+      channel->ring.close();
+    }
+  }
+  channels_.clear();
+}
+
+}  // namespace local
+}  // namespace ipc
+}  // namespace messaging
+}  // namespace maf
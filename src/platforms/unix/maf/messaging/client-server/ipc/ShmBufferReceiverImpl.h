@@ -0,0 +1,73 @@
+#pragma once
+
+#include <maf/utils/serialization/Buffer.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+
+#include "FrameAssembler.h"
+#include "ShmRing.h"
+
+namespace maf {
+namespace messaging {
+namespace ipc {
+namespace local {
+
+using BytesComeCallback = std::function<void(srz::Buffer &&)>;
+
+/*! \brief Receives frames that senders write into shared memory rings
+ * Each sender connects to the control socket once and passes its ring, then
+ * only signals the ring's data eventfd when this receiver sleeps. The control
+ * socket is watched to drop the ring of a sender that is gone.
+ */
+class ShmBufferReceiverImpl {
+ public:
+  ~ShmBufferReceiverImpl();
+  bool init(const Address &addr);
+  bool start();
+  void stop();
+  void deinit();
+  bool running() const;
+  const Address &address() const;
+  void setObserver(BytesComeCallback callback);
+
+ private:
+  enum class State : char { Uninitialized, Initialized, Running, Stopped };
+
+  struct Channel {
+    AutoCloseFD<SockFD> control;
+    AutoCloseFD<FD> dataEvent;
+    AutoCloseFD<FD> spaceEvent;
+    ShmRing ring;
+    FrameAssembler frames;
+  };
+  using ChannelPtr = std::shared_ptr<Channel>;
+
+  State getState() const { return state_.load(std::memory_order_acquire); }
+  void setState(State state) { state_.store(state, std::memory_order_release); }
+
+  bool waitAndProcessChannels();
+  bool acceptChannels();
+  bool onControlEvent(Channel &channel);
+  bool attachRing(Channel &channel);
+  void drainRing(Channel &channel);
+  void closeChannel(const ChannelPtr &channel);
+  void closeAllChannels();
+
+  BytesComeCallback bytesComeCallback_;
+  Address myaddr_;
+  sockaddr_un mySockAddr_;
+  AutoCloseFD<SockFD> fdMySock_;
+  AutoCloseFD<FD> fdEpoll_;
+  AutoCloseFD<FD> fdStopEvent_;
+  // Keyed by both the control socket and the data eventfd of a channel
+  std::unordered_map<FD, ChannelPtr> channels_;
+  std::atomic<State> state_ = State::Uninitialized;
+};
+
+}  // namespace local
+}  // namespace ipc
+}  // namespace messaging
+}  // namespace maf
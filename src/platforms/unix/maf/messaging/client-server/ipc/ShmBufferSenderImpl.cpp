@@ -0,0 +1,170 @@
+#include "ShmBufferSenderImpl.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+
+namespace maf {
+namespace messaging {
+namespace ipc {
+namespace local {
+
+namespace {
+
+static constexpr int SPACE_WAIT_SLICE_MS = 100;
+
+static bool sendRingFds(SockFD control, FD memfd, FD dataEvent,
+                        FD spaceEvent) {
+  FD fds[] = {memfd, dataEvent, spaceEvent};
+  char byte = 0;
+  iovec iov{&byte, sizeof(byte)};
+  alignas(cmsghdr) char control_[CMSG_SPACE(sizeof(fds))];
+  msghdr msg{};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control_;
+  msg.msg_controllen = sizeof(control_);
+  auto cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+  memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+  return sendmsg(control, &msg, MSG_NOSIGNAL) == sizeof(byte);
+}
+
+}  // namespace
+
+ActionCallStatus ShmBufferSenderImpl::send(const Buffer &payload,
+                                           const Address &destination) {
+  auto sockpath = constructShmSocketPath(destination);
+  auto channel = channelTo(sockpath);
+  std::lock_guard lock(channel->mutex);
+  if (channel->ring.mapped() && channel->ring.closed()) {
+    // Receiver stopped, it may have been restarted since
+    reset(*channel);
+  }
+  if (!channel->ring.mapped() && !open(*channel, sockpath)) {
+    reset(*channel);
+    return ActionCallStatus::ReceiverUnavailable;
+  }
+
+  SizeType payloadSize = static_cast<SizeType>(payload.length());
+  if (writeAll(*channel, reinterpret_cast<const char *>(&payloadSize),
+               sizeof(SizeType)) &&
+      writeAll(*channel, payload.data(), payload.length())) {
+    return ActionCallStatus::Success;
+  }
+  // The receiver drops the partial frame along with the ring
+  MAF_LOGGER_ERROR("Failed to send payload of ", payload.length(),
+                   " bytes through shared memory");
+  reset(*channel);
+  return ActionCallStatus::ReceiverUnavailable;
+}
+
+Availability ShmBufferSenderImpl::checkReceiverStatus(
+    const Address &destination) const {
+  auto sockaddr =
+      createUnixAbstractSocketAddr(constructShmSocketPath(destination));
+  return connectable(&sockaddr) ? Availability::Available
+                                : Availability::Unavailable;
+}
+
+ShmBufferSenderImpl::ChannelPtr ShmBufferSenderImpl::channelTo(
+    const SocketPath &sockpath) {
+  std::lock_guard lock(channelsMutex_);
+  auto &channel = channels_[sockpath];
+  if (!channel) {
+    channel = std::make_shared<Channel>();
+  }
+  return channel;
+}
+
+bool ShmBufferSenderImpl::open(Channel &channel, const SocketPath &sockpath) {
+  if (channel.control = connectToSocket(sockpath);
+      channel.control == INVALID_FD) {
+    return false;
+  }
+
+  auto capacity = ShmRing::DEFAULT_CAPACITY;
+  AutoCloseFD<FD> memfd =
+      memfd_create("maf.shm.ring", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  channel.dataEvent = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  channel.spaceEvent = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (memfd == INVALID_FD || channel.dataEvent == INVALID_FD ||
+      channel.spaceEvent == INVALID_FD) {
+    MAF_SOCKET_ERROR("Could not create shared memory channel");
+    return false;
+  }
+  // Sealed size: the receiver can trust the mapping stays valid
+  if (ftruncate(memfd, static_cast<off_t>(ShmRing::segmentSize(capacity))) !=
+          0 ||
+      fcntl(memfd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) !=
+          0 ||
+      !channel.ring.create(memfd, capacity)) {
+    MAF_SOCKET_ERROR("Could not set up shared memory ring");
+    return false;
+  }
+  if (!sendRingFds(channel.control, memfd, channel.dataEvent,
+                   channel.spaceEvent)) {
+    MAF_SOCKET_ERROR("Could not pass shared memory ring to ", sockpath);
+    return false;
+  }
+  return true;
+}
+
+void ShmBufferSenderImpl::reset(Channel &channel) {
+  channel.ring.unmap();
+  channel.control.reset();
+  channel.dataEvent.reset();
+  channel.spaceEvent.reset();
+}
+
+bool ShmBufferSenderImpl::writeAll(Channel &channel, const char *data,
+                                   size_t size) {
+  while (true) {
+    auto written = channel.ring.write(data, size);
+    data += written;
+    size -= written;
+    if (written != 0 && channel.ring.takeConsumerWaiting()) {
+      // The receiver was idle: wake it, and make sure it is still there since
+      // nothing else would tell
+      eventfd_write(channel.dataEvent, 1);
+      if (peerClosed(channel.control)) {
+        return false;
+      }
+    }
+    if (size == 0) {
+      return true;
+    }
+    if (!waitForSpace(channel)) {
+      return false;
+    }
+  }
+}
+
+bool ShmBufferSenderImpl::waitForSpace(Channel &channel) {
+  while (!channel.ring.closed()) {
+    channel.ring.setProducerWaiting();
+    if (channel.ring.freeSpace() != 0) {
+      return true;
+    }
+    pollfd fds[] = {{channel.spaceEvent, POLLIN, 0},
+                    {channel.control, POLLRDHUP, 0}};
+    if (poll(fds, 2, SPACE_WAIT_SLICE_MS) < 0 && errno != EINTR) {
+      return false;
+    }
+    if (fds[1].revents != 0) {
+      return false;
+    }
+    if (fds[0].revents & POLLIN) {
+      eventfd_t count;
+      eventfd_read(channel.spaceEvent, &count);
+    }
+  }
+  return false;
+}
+
+}  // namespace local
+}  // namespace ipc
+}  // namespace messaging
+}  // namespace maf
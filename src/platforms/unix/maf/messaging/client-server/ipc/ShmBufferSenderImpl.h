@@ -0,0 +1,53 @@
+#pragma once
+
+#include <maf/messaging/client-server/CSStatus.h>
+#include <maf/utils/serialization/Buffer.h>
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "ShmRing.h"
+
+namespace maf {
+namespace messaging {
+namespace ipc {
+namespace local {
+
+/*! \brief Sends frames through a shared memory ring per destination
+ * The first message to a destination connects to its control socket and
+ * passes a sealed memfd holding the ring plus two eventfds: one wakes the
+ * receiver, the other wakes this sender when it waits for free space.
+ * The control socket stays open so each side notices when the other is gone.
+ */
+class ShmBufferSenderImpl {
+ public:
+  using Buffer = maf::srz::Buffer;
+
+  ActionCallStatus send(const Buffer &payload, const Address &destination);
+  Availability checkReceiverStatus(const Address &destination) const;
+
+ private:
+  struct Channel {
+    std::mutex mutex;
+    AutoCloseFD<SockFD> control;
+    AutoCloseFD<FD> dataEvent;
+    AutoCloseFD<FD> spaceEvent;
+    ShmRing ring;
+  };
+  using ChannelPtr = std::shared_ptr<Channel>;
+
+  ChannelPtr channelTo(const SocketPath &sockpath);
+  static bool open(Channel &channel, const SocketPath &sockpath);
+  static void reset(Channel &channel);
+  static bool writeAll(Channel &channel, const char *data, size_t size);
+  static bool waitForSpace(Channel &channel);
+
+  std::mutex channelsMutex_;
+  std::unordered_map<SocketPath, ChannelPtr> channels_;
+};
+
+}  // namespace local
+}  // namespace ipc
+}  // namespace messaging
+}  // namespace maf
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+#include "SocketShared.h"
+
+namespace maf {
+namespace messaging {
+namespace ipc {
+namespace local {
+
+// Control socket of a shared memory receiver, kept apart from the socket a
+// local IPC receiver of the same address listens on
+inline SocketPath constructShmSocketPath(const Address &addr) {
+  return addr.get_name() + ".shm";
+}
+
+// Lives at the start of the shared segment, the ring bytes follow it.
+// Both processes map it, so only address-free atomics are used here
+struct ShmRingHeader {
+  alignas(64) std::atomic<uint64_t> tail;
+  std::atomic<uint32_t> producerWaiting;
+  alignas(64) std::atomic<uint64_t> head;
+  std::atomic<uint32_t> consumerWaiting;
+  alignas(64) std::atomic<uint32_t> closed;
+  uint32_t capacity;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free &&
+                  std::atomic<uint32_t>::is_always_lock_free,
+              "Shared memory ring needs lock-free atomics");
+
+/*! \brief Single producer/single consumer byte ring in a shared segment
+ * The producer owns tail, the consumer owns head. A side about to sleep
+ * raises its waiting flag then checks the ring again, the other side clears
+ * the flag and signals an eventfd, so a busy stream costs no syscall.
+ */
+class ShmRing {
+ public:
+  static constexpr uint32_t DEFAULT_CAPACITY = 1u << 20;
+
+  ShmRing() = default;
+  ShmRing(const ShmRing &) = delete;
+  ShmRing &operator=(const ShmRing &) = delete;
+  ~ShmRing() { unmap(); }
+
+  static size_t segmentSize(uint32_t capacity) {
+    return sizeof(ShmRingHeader) + capacity;
+  }
+
+  //! Producer side, the segment must be segmentSize(capacity) long
+  bool create(FD memfd, uint32_t capacity) {
+    if (!map(memfd, segmentSize(capacity))) {
+      return false;
+    }
+    new (header_) ShmRingHeader{};
+    header_->capacity = capacity_ = capacity;
+    // The consumer sleeps until the first bytes come
+    header_->consumerWaiting.store(1, std::memory_order_release);
+    return true;
+  }
+
+  //! Consumer side, validates what the producer set up. The segment must be
+  //! sealed against shrinking, a peer truncating it would fault this side
+  bool attach(FD memfd) {
+    struct stat st;
+    auto seals = fcntl(memfd, F_GET_SEALS);
+    if (seals < 0 || (seals & F_SEAL_SHRINK) == 0 || fstat(memfd, &st) != 0 ||
+        static_cast<size_t>(st.st_size) <= sizeof(ShmRingHeader) ||
+        !map(memfd, static_cast<size_t>(st.st_size))) {
+      return false;
+    }
+    // Kept on this side, the peer could still change the shared copy
+    capacity_ = header_->capacity;
+    if (capacity_ == 0 || (capacity_ & (capacity_ - 1)) != 0 ||
+        segmentSize(capacity_) != size_) {
+      unmap();
+      return false;
+    }
+    return true;
+  }
+
+  bool mapped() const { return header_ != nullptr; }
+
+  void unmap() {
+    if (header_) {
+      munmap(header_, size_);
+      header_ = nullptr;
+    }
+  }
+
+  //! Copies as much as fits, returns the number of bytes written
+  size_t write(const char *data, size_t size) {
+    auto tail = header_->tail.load(std::memory_order_relaxed);
+    auto head = header_->head.load(std::memory_order_acquire);
+    auto n = std::min<size_t>(size, capacity_ - (tail - head));
+    copyIn(tail, data, n);
+    // seq_cst pairs with the consumer raising its waiting flag
+    header_->tail.store(tail + n, std::memory_order_seq_cst);
+    return n;
+  }
+
+  //! Hands the readable bytes to consume(data, size), at most two spans
+  template <class Consume> size_t read(Consume &&consume) {
+    auto head = header_->head.load(std::memory_order_relaxed);
+    auto tail = header_->tail.load(std::memory_order_acquire);
+    auto available =
+        std::min<size_t>(static_cast<size_t>(tail - head), capacity_);
+    auto mask = capacity_ - 1;
+    auto first = std::min<size_t>(available, capacity_ - (head & mask));
+    if (first != 0) {
+      consume(data() + (head & mask), first);
+    }
+    if (available > first) {
+      consume(data(), available - first);
+    }
+    header_->head.store(head + available, std::memory_order_seq_cst);
+    return available;
+  }
+
+  size_t available() const {
+    return static_cast<size_t>(header_->tail.load(std::memory_order_seq_cst) -
+                               header_->head.load(std::memory_order_seq_cst));
+  }
+
+  size_t freeSpace() const { return capacity_ - available(); }
+
+  //! Returns true if the consumer was sleeping and must be signaled
+  bool takeConsumerWaiting() {
+    return header_->consumerWaiting.load(std::memory_order_seq_cst) != 0 &&
+           header_->consumerWaiting.exchange(0, std::memory_order_seq_cst) != 0;
+  }
+
+  bool takeProducerWaiting() {
+    return header_->producerWaiting.load(std::memory_order_seq_cst) != 0 &&
+           header_->producerWaiting.exchange(0, std::memory_order_seq_cst) != 0;
+  }
+
+  void setConsumerWaiting() {
+    header_->consumerWaiting.store(1, std::memory_order_seq_cst);
+  }
+
+  void setProducerWaiting() {
+    header_->producerWaiting.store(1, std::memory_order_seq_cst);
+  }
+
+  //! Set by the consumer when it stops reading for good
+  void close() { header_->closed.store(1, std::memory_order_release); }
+  bool closed() const {
+    return header_->closed.load(std::memory_order_acquire) != 0;
+  }
+
+ private:
+  bool map(FD memfd, size_t size) {
+    auto addr =
+        mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+    if (addr == MAP_FAILED) {
+      MAF_SOCKET_ERROR("Could not map shared ring of ", size, " bytes");
+      return false;
+    }
+    header_ = static_cast<ShmRingHeader *>(addr);
+    size_ = size;
+    return true;
+  }
+
+  char *data() { return reinterpret_cast<char *>(header_ + 1); }
+
+  void copyIn(uint64_t tail, const char *src, size_t size) {
+    auto mask = capacity_ - 1;
+    auto first = std::min<size_t>(size, capacity_ - (tail & mask));
+    memcpy(data() + (tail & mask), src, first);
+    memcpy(data(), src + first, size - first);
+  }
+
+  ShmRingHeader *header_ = nullptr;
+  size_t size_ = 0;
+  uint32_t capacity_ = 0;
+};
+
+}  // namespace local
+}  // namespace ipc
+}  // namespace messaging
+}  // namespace maf
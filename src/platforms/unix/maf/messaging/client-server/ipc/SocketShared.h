@@ -3,10 +3,14 @@
 #include <error.h>
 #include <maf/logging/Logger.h>
 #include <maf/messaging/client-server/Address.h>
+#include <poll.h>
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <unistd.h>
 
+#include <atomic>
+#include <cstdint>
+
 namespace maf {
 namespace messaging {
 namespace ipc {
@@ -16,7 +20,6 @@ using SocketPath = std::string;
 using FD = int;
 using SockFD = FD;
 
-static constexpr size_t MAXCLIENTS = 30;
 static constexpr SockFD INVALID_FD = -1;
 template <typename FileDescriptor, FD INVALID_VALUE = INVALID_FD>
 class AutoCloseFD {
@@ -25,8 +28,10 @@ class AutoCloseFD {
 
 public:
   AutoCloseFD(FileDescriptor fd_ = INVALID_VALUE) : fd{fd_} {}
-  AutoCloseFD(AutoCloseFD &&rhs) { takefrom(std::move(rhs)); }
-  AutoCloseFD &operator=(AutoCloseFD &&rhs) {
+  AutoCloseFD(AutoCloseFD &&rhs) noexcept : fd{INVALID_VALUE} {
+    takefrom(std::move(rhs));
+  }
+  AutoCloseFD &operator=(AutoCloseFD &&rhs) noexcept {
     takefrom(std::move(rhs));
     return *this;
   }
@@ -35,12 +40,12 @@ public:
   operator FileDescriptor() { return fd; }
 
 private:
-  void takefrom(AutoCloseFD &&rhs) {
+  void takefrom(AutoCloseFD &&rhs) noexcept {
     closeFD();
     fd = rhs.fd;
     rhs.fd = INVALID_VALUE;
   }
-  void closeFD() {
+  void closeFD() noexcept {
     if (fd != INVALID_VALUE) {
       close(fd);
       fd = INVALID_VALUE;
@@ -49,6 +54,13 @@ private:
   FileDescriptor fd;
 };
 
+// Kept by senders and receivers to tell how many syscalls a message costs
+struct IOCounters {
+  std::atomic<uint64_t> messages{0};
+  std::atomic<uint64_t> syscalls{0};
+  std::atomic<uint64_t> bytes{0};
+};
+
 #define MAF_SOCKET_ERROR(...)                                                  \
   MAF_LOGGER_ERROR(__VA_ARGS__, " with errno = ", errno, "!");
 
@@ -72,7 +84,21 @@ template <typename SockAddress> inline sockaddr *_2sockAddr(SockAddress *sa) {
   return reinterpret_cast<sockaddr *>(sa);
 }
 
-inline AutoCloseFD<SockFD> connectToSocket(const std::string &sockpath) {
+//! Tells whether a receiver listens on sockaddr, without logging failures
+inline bool connectable(sockaddr_un *sockaddr) {
+  AutoCloseFD<SockFD> fd;
+  if (fd = socket(AF_UNIX, SOCK_STREAM, 0); fd == INVALID_FD) {
+    MAF_SOCKET_ERROR("Cannot create socket");
+  } else {
+    if (connect(fd, _2sockAddr(sockaddr), sizeof(sockaddr_un)) == INVALID_FD) {
+      fd.reset();
+    }
+  }
+  return fd != INVALID_FD;
+}
+
+inline AutoCloseFD<SockFD> connectToSocket(const std::string &sockpath,
+                                           bool reportFailure = true) {
   AutoCloseFD<SockFD> fd;
   if (isValidSocketPath(sockpath)) {
     if (fd = socket(AF_UNIX, SOCK_STREAM, 0); fd == INVALID_FD) {
@@ -80,7 +106,9 @@ inline AutoCloseFD<SockFD> connectToSocket(const std::string &sockpath) {
     } else {
       auto addr = createUnixAbstractSocketAddr(sockpath);
       if (connect(fd, _2sockAddr(&addr), sizeof(addr)) == INVALID_FD) {
-        MAF_SOCKET_ERROR("Can't connect to address ", sockpath);
+        if (reportFailure) {
+          MAF_SOCKET_ERROR("Can't connect to address ", sockpath);
+        }
         fd.reset();
       }
     }
@@ -92,6 +120,12 @@ inline AutoCloseFD<SockFD> connectToSocket(const std::string &sockpath) {
   return fd;
 }
 
+//! Tells without blocking whether the peer closed its end of the connection
+inline bool peerClosed(SockFD fd) {
+  pollfd pfd{fd, POLLRDHUP, 0};
+  return poll(&pfd, 1, 0) > 0 && pfd.revents != 0;
+}
+
 } // namespace ipc
 } // namespace messaging
 } // namespace maf
@@ -1,13 +1,29 @@
 
 #include <maf/logging/Logger.h>
+#include <maf/messaging/client-server/ipc/local/ParamTrait.h>
 #include <maf/threading/AtomicObject.h>
 
 #include <atomic>
+#include <memory>
+#include <chrono>
+#include <condition_variable>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
 #include <thread>
 #include <vector>
 
 #include "../src/common/maf/messaging/client-server/ipc/LocalIPCBufferReceiver.h"
 #include "../src/common/maf/messaging/client-server/ipc/LocalIPCBufferSender.h"
+#include "../src/common/maf/messaging/client-server/ipc/LocalIPCMessage.h"
+#include "../src/common/maf/messaging/client-server/ipc/LocalIPCQueuedSender.h"
+#include "../src/common/maf/messaging/client-server/ipc/LocalIPCServer.h"
+#include "../src/common/maf/messaging/client-server/ipc/ShmBufferReceiver.h"
+#include "../src/common/maf/messaging/client-server/ipc/ShmBufferSender.h"
+#include "../src/common/maf/messaging/client-server/ShardedThreadPool.h"
+#include "../src/platforms/unix/maf/messaging/client-server/ipc/ShmRing.h"
 #include "test.h"
 
 using namespace maf::messaging;
@@ -77,10 +93,1021 @@ void test() {
   receiver.stop();
   receiverThread.join();
 }
+struct CountingBytesComeObserver : public BytesComeObserver {
+  void onBytesCome(Buffer&&) override { ++count; }
+  bool waitFor(size_t expected) {
+    auto until = std::chrono::steady_clock::now() + 20s;
+    while (count < expected && std::chrono::steady_clock::now() < until) {
+      std::this_thread::sleep_for(1ms);
+    }
+    return count == expected;
+  }
+  std::atomic_size_t count = 0;
+};
+
+static long long sendThroughputRun(ConnectionMode mode, const Address& addr) {
+  const size_t MessageCount = 20000;
+  const size_t SenderThreadsCount = 4;
+  auto sender = local::LocalIPCBufferSender{mode};
+  auto receiver = local::LocalIPCBufferReceiver{};
+  auto observer = CountingBytesComeObserver{};
+  if (!receiver.init(addr)) {
+    return -1;
+  }
+  receiver.setObserver(&observer);
+  std::thread receiverThread{[&receiver] { receiver.start(); }};
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> senderThreads;
+  for (size_t i = 0; i < SenderThreadsCount; ++i) {
+    senderThreads.emplace_back([&] {
+      const Buffer message(64, 'x');
+      for (size_t m = 0; m < MessageCount / SenderThreadsCount; ++m) {
+        sender.send(message, addr);
+      }
+    });
+  }
+  for (auto& th : senderThreads) {
+    th.join();
+  }
+  auto received = observer.waitFor(MessageCount);
+  auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start);
+  receiver.stop();
+  receiverThread.join();
+
+  const char* modeNames[] = {"OneShot", "Persistent", "Batched"};
+  auto sent = sender.stats();
+  auto read = receiver.stats();
+  std::cout << modeNames[static_cast<int>(mode)] << ": " << MessageCount
+            << " messages in " << elapsed.count() << "us, "
+            << MessageCount * 1000000 / (elapsed.count() + 1)
+            << " msgs/s, syscalls per message: sender "
+            << static_cast<double>(sent.syscalls) / sent.messages
+            << ", receiver "
+            << static_cast<double>(read.syscalls) / (read.messages + 1)
+            << std::endl;
+  return received ? elapsed.count() : -1;
+}
+
+void throughputBenchmark() {
+  TEST_CASE_B(persistent_connection_throughput) {
+    auto oneShot =
+        sendThroughputRun(ConnectionMode::OneShot, {"maf.bench.oneshot", 0});
+    auto persistent = sendThroughputRun(ConnectionMode::Persistent,
+                                        {"maf.bench.persistent", 0});
+    auto batched =
+        sendThroughputRun(ConnectionMode::Batched, {"maf.bench.batched", 0});
+    EXPECT(oneShot >= 0);
+    EXPECT(persistent >= 0);
+    EXPECT(batched >= 0);
+  }
+  TEST_CASE_E()
+}
+
+void batchedOrderTest() {
+  TEST_CASE_B(batched_frames_keep_order) {
+    struct SequenceObserver : public BytesComeObserver {
+      void onBytesCome(Buffer&& bytes) override {
+        if (std::stoul(bytes) != received) {
+          outOfOrder = true;
+        }
+        ++received;
+      }
+      std::atomic_size_t received = 0;
+      std::atomic_bool outOfOrder = false;
+    };
+    const size_t MessageCount = 10000;
+    Address addr{"maf.batched.order", 0};
+    auto sender = local::LocalIPCBufferSender{
+        ConnectionMode::Batched, DefaultSharedPayloadThreshold, {1ms, 4096}};
+    auto receiver = local::LocalIPCBufferReceiver{};
+    auto observer = SequenceObserver{};
+    EXPECT(receiver.init(addr));
+    receiver.setObserver(&observer);
+    std::thread receiverThread{[&receiver] { receiver.start(); }};
+    bool allQueued = true;
+    for (size_t i = 0; i < MessageCount; ++i) {
+      allQueued &=
+          sender.send(std::to_string(i), addr) == ActionCallStatus::Success;
+      if (i % 1000 == 0) {
+        // Let the delay flush a batch below the byte limit
+        std::this_thread::sleep_for(2ms);
+      }
+    }
+    EXPECT(allQueued);
+    auto until = std::chrono::steady_clock::now() + 10s;
+    while (observer.received < MessageCount &&
+           std::chrono::steady_clock::now() < until) {
+      std::this_thread::sleep_for(1ms);
+    }
+    EXPECT(observer.received == MessageCount);
+    EXPECT(!observer.outOfOrder);
+    EXPECT(sender.stats().syscalls < MessageCount / 10);
+    receiver.stop();
+    receiverThread.join();
+  }
+  TEST_CASE_E()
+}
+
+void reconnectTest() {
+  TEST_CASE_B(persistent_connection_reconnect) {
+    Address addr{"maf.reconnect", 0};
+    auto sender = local::LocalIPCBufferSender{};
+    for (int round = 0; round < 2; ++round) {
+      auto receiver = local::LocalIPCBufferReceiver{};
+      auto observer = CountingBytesComeObserver{};
+      EXPECT(receiver.init(addr));
+      receiver.setObserver(&observer);
+      std::thread receiverThread{[&receiver] { receiver.start(); }};
+      for (int i = 0; i < 10; ++i) {
+        EXPECT(sender.send("round " + std::to_string(round), addr) ==
+               ActionCallStatus::Success);
+      }
+      EXPECT(observer.waitFor(10));
+      receiver.stop();
+      receiverThread.join();
+    }
+    EXPECT(sender.send("nobody", addr) ==
+           ActionCallStatus::ReceiverUnavailable);
+  }
+  TEST_CASE_E()
+}
+
+void livenessTest() {
+  TEST_CASE_B(receiver_liveness_without_polling) {
+    using namespace std::chrono;
+    Address addr{"maf.liveness", 0};
+    // Heartbeats must reach the receiver without being delivered
+    auto sender = local::LocalIPCBufferSender{
+        ConnectionMode::Persistent, DefaultSharedPayloadThreshold, {},
+        {200ms, 10ms}};
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::vector<Availability> statuses;
+    auto waitForStatus = [&](size_t count) {
+      std::unique_lock lock(mutex);
+      return changed.wait_for(lock, 2s,
+                              [&] { return statuses.size() >= count; });
+    };
+    EXPECT(sender.watchReceiver(addr, [&](Availability status) {
+      std::lock_guard lock(mutex);
+      statuses.push_back(status);
+      changed.notify_all();
+    }));
+
+    for (size_t round = 0; round < 2; ++round) {
+      auto receiver = local::LocalIPCBufferReceiver{};
+      auto observer = CountingBytesComeObserver{};
+      EXPECT(receiver.init(addr));
+      receiver.setObserver(&observer);
+      std::thread receiverThread{[&receiver] { receiver.start(); }};
+      auto startedAt = steady_clock::now();
+      EXPECT(waitForStatus(round * 2 + 1));
+      auto upDelay = steady_clock::now() - startedAt;
+
+      // Idle and up: heartbeats go through and none is delivered
+      auto before = receiver.stats();
+      std::this_thread::sleep_for(100ms);
+      EXPECT(observer.count == 0);
+      EXPECT(receiver.stats().bytes > before.bytes);
+
+      auto stoppedAt = steady_clock::now();
+      receiver.stop();
+      receiverThread.join();
+      EXPECT(waitForStatus(round * 2 + 2));
+      auto downDelay = steady_clock::now() - stoppedAt;
+      std::cout << "Receiver seen up after "
+                << duration_cast<microseconds>(upDelay).count()
+                << "us, down after "
+                << duration_cast<microseconds>(downDelay).count() << "us"
+                << std::endl;
+    }
+    const auto expectedStatuses = std::vector{
+        Availability::Available, Availability::Unavailable,
+        Availability::Available, Availability::Unavailable};
+    EXPECT(statuses == expectedStatuses);
+    EXPECT(sender.watchReceiver(addr, {}));
+  }
+  TEST_CASE_E()
+}
+
+void manyConnectionsTest() {
+  TEST_CASE_B(many_connections_and_large_frames) {
+    // Well above the 30 connections the select based receiver could serve
+    const size_t SenderCount = 100;
+    Address addr{"maf.many.connections", 0};
+    auto receiver = local::LocalIPCBufferReceiver{};
+    auto observer = CountingBytesComeObserver{};
+    EXPECT(receiver.init(addr));
+    receiver.setObserver(&observer);
+    std::thread receiverThread{[&receiver] { receiver.start(); }};
+
+    std::vector<std::unique_ptr<local::LocalIPCBufferSender>> senders;
+    for (size_t i = 0; i < SenderCount; ++i) {
+      senders.push_back(std::make_unique<local::LocalIPCBufferSender>());
+    }
+    std::atomic_size_t succeeded = 0;
+    std::vector<std::thread> senderThreads;
+    for (size_t t = 0; t < 4; ++t) {
+      senderThreads.emplace_back([&, t] {
+        for (size_t i = t; i < SenderCount; i += 4) {
+          for (int m = 0; m < 10; ++m) {
+            if (senders[i]->send("small", addr) == ActionCallStatus::Success) {
+              ++succeeded;
+            }
+          }
+        }
+      });
+    }
+    // Large frames arrive in many pieces while the small ones keep coming
+    const Buffer large(4 * 1024 * 1024 + 3, 'L');
+    for (int m = 0; m < 3; ++m) {
+      if (senders[0]->send(large, addr) == ActionCallStatus::Success) {
+        ++succeeded;
+      }
+    }
+    for (auto& th : senderThreads) {
+      th.join();
+    }
+    EXPECT(succeeded == SenderCount * 10 + 3);
+    EXPECT(observer.waitFor(SenderCount * 10 + 3));
+    receiver.stop();
+    receiverThread.join();
+  }
+  TEST_CASE_E()
+}
+
+struct SharedPayloadObserver : public BytesComeObserver {
+  void onBytesCome(Buffer&& bytes) override {
+    checksum += bytes.front() + bytes.back();
+    ++copied;
+  }
+  void onSharedBytesCome(SharedBytes&& bytes) override {
+    checksum += bytes.bytes.front() + bytes.bytes.back();
+    lastShared = std::move(bytes);
+    ++shared;
+  }
+  bool waitFor(size_t expected) {
+    auto until = std::chrono::steady_clock::now() + 20s;
+    while (copied + shared < expected &&
+           std::chrono::steady_clock::now() < until) {
+      std::this_thread::sleep_for(1ms);
+    }
+    return copied + shared == expected;
+  }
+  std::atomic_size_t copied = 0;
+  std::atomic_size_t shared = 0;
+  std::atomic_size_t checksum = 0;
+  SharedBytes lastShared;
+};
+
+static long long sendLargePayloads(size_t sharedPayloadThreshold,
+                                   size_t payloadSize, const Address& addr) {
+  const size_t MessageCount = 320 * 1024 * 1024 / payloadSize;
+  const Buffer payload(payloadSize, 'p');
+  auto sender = local::LocalIPCBufferSender{ConnectionMode::Persistent,
+                                            sharedPayloadThreshold};
+  auto receiver = local::LocalIPCBufferReceiver{};
+  auto observer = SharedPayloadObserver{};
+  if (!receiver.init(addr)) {
+    return -1;
+  }
+  receiver.setObserver(&observer);
+  std::thread receiverThread{[&receiver] { receiver.start(); }};
+  auto start = std::chrono::steady_clock::now();
+  for (size_t m = 0; m < MessageCount; ++m) {
+    sender.send(payload, addr);
+  }
+  auto received = observer.waitFor(MessageCount);
+  auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start);
+  receiver.stop();
+  receiverThread.join();
+  std::cout << MessageCount << " payloads of " << payloadSize / 1024 << "KiB "
+            << (observer.shared != 0 ? "shared" : "copied") << " in "
+            << elapsed.count() << "us" << std::endl;
+  return received ? elapsed.count() : -1;
+}
+
+void sharedPayloadTest() {
+  TEST_CASE_B(shared_payload_memfd) {
+    // Below the default threshold, to keep the test light
+    const size_t Threshold = 64 * 1024;
+    Address addr{"maf.shared.payload", 0};
+    auto sender =
+        local::LocalIPCBufferSender{ConnectionMode::Persistent, Threshold};
+    auto receiver = local::LocalIPCBufferReceiver{};
+    auto observer = SharedPayloadObserver{};
+    EXPECT(receiver.init(addr));
+    receiver.setObserver(&observer);
+    std::thread receiverThread{[&receiver] { receiver.start(); }};
+
+    Buffer large(Threshold * 16 + 5, 0);
+    for (size_t i = 0; i < large.size(); ++i) {
+      large[i] = static_cast<char>(i * 31);
+    }
+    EXPECT(sender.send(Buffer(Threshold - 1, 's'), addr) ==
+           ActionCallStatus::Success);
+    EXPECT(sender.send(large, addr) == ActionCallStatus::Success);
+    EXPECT(sender.send(Buffer(10, 's'), addr) == ActionCallStatus::Success);
+    EXPECT(observer.waitFor(3));
+    EXPECT(observer.copied == 2 && observer.shared == 1);
+    // Still mapped while the receiver is gone, the view owns the mapping
+    receiver.stop();
+    receiverThread.join();
+    EXPECT(observer.lastShared.bytes == large);
+  }
+  TEST_CASE_E()
+
+  TEST_CASE_B(shared_payload_decoded_in_place) {
+    using namespace local;
+    auto content = std::make_shared<std::string>(1024 * 1024, 'c');
+    auto outgoing = createCSMessage<LocalIPCMessage>(
+        "shared.service", "shared.op", OpCode::Request, RequestIDInvalid,
+        ParamTrait::translate(content));
+    auto bytes = std::make_shared<const Buffer>(outgoing->toBytes());
+
+    LocalIPCMessage incoming;
+    EXPECT(incoming.fromBytes(SharedBytes{bytes, *bytes}));
+    EXPECT(incoming.serviceID() == "shared.service");
+    auto view = static_cast<IncomingPayload*>(incoming.payload().get())
+                    ->streamView()
+                    .readingPos();
+    // The payload is read where it lies in the shared bytes
+    EXPECT(view < bytes->size());
+    EXPECT(*ParamTrait::translate<std::string>(incoming.payload()) == *content);
+  }
+  TEST_CASE_E()
+
+  TEST_CASE_B(incoming_payload_decoded_once) {
+    using namespace local;
+    auto outgoing = createCSMessage<LocalIPCMessage>(
+        "shared.service", "shared.op", OpCode::StatusRegister, RequestIDInvalid,
+        ParamTrait::translate(std::make_shared<std::string>(4096, 'd')));
+    LocalIPCMessage incoming;
+    EXPECT(incoming.fromBytes(outgoing->toBytes()));
+
+    // Every subscriber and the cached copy get the same decoded content
+    auto payload = incoming.payload();
+    auto first = ParamTrait::translate<std::string>(payload);
+    auto cached = CSPayloadIFPtr{payload->clone()};
+    EXPECT(first && *first == std::string(4096, 'd'));
+    EXPECT(ParamTrait::translate<std::string>(payload) == first);
+    EXPECT(ParamTrait::translate<std::string>(cached) == first);
+
+    // Decoding as another type does not take the cached content
+    TranslationStatus status;
+    auto chars = ParamTrait::translate<std::vector<char>>(payload, &status);
+    EXPECT(status == TranslationStatus::Success && chars);
+    EXPECT(static_cast<void*>(chars.get()) != static_cast<void*>(first.get()));
+  }
+  TEST_CASE_E()
+
+  TEST_CASE_B(shared_payload_vs_copy_throughput) {
+    for (size_t size : {8 << 20, 64 << 20}) {
+      auto copied = sendLargePayloads(std::numeric_limits<size_t>::max(), size,
+                                      {"maf.bench.copied.payload", 0});
+      auto shared = sendLargePayloads(0, size, {"maf.bench.shared.payload", 0});
+      EXPECT(copied >= 0);
+      EXPECT(shared >= 0);
+    }
+  }
+  TEST_CASE_E()
+}
+
+// Stops reading on the first message until released
+struct StalledBytesComeObserver : public CountingBytesComeObserver {
+  void onBytesCome(Buffer&&) override {
+    ++count;
+    std::unique_lock lock(mutex);
+    releasedCondition.wait(lock, [this] { return released; });
+  }
+  void release() {
+    std::lock_guard lock(mutex);
+    released = true;
+    releasedCondition.notify_all();
+  }
+  std::mutex mutex;
+  std::condition_variable releasedCondition;
+  bool released = false;
+};
+
+void internedIDTest() {
+  TEST_CASE_B(interned_ids_on_the_wire) {
+    using namespace local;
+    // Compared with these, other names would be interned
+    constexpr auto WireService = ServiceID::fromLiteral("wire.service");
+    constexpr auto WireOp = OpID::fromLiteral("wire.op");
+    static_assert(WireOp.hash() == OpID::hashOf("wire.op"));
+    auto outgoing = createCSMessage<LocalIPCMessage>(WireService, WireOp,
+                                                     OpCode::Request, 1);
+
+    // The compact header carries the hashes only, the name is known once
+    // published
+    auto bytes = outgoing->toBytes(HeaderVersion::Compact, 1);
+    LocalIPCMessage incoming;
+    EXPECT(incoming.fromBytes(Buffer{bytes}));
+    EXPECT(incoming.serviceID() == WireService);
+    EXPECT(incoming.operationID() == WireOp);
+    EXPECT(incoming.operationID().name().empty());
+    EXPECT(OpID::publish(WireOp));
+    EXPECT(incoming.fromBytes(Buffer{bytes}));
+    EXPECT(incoming.operationID().name() == "wire.op");
+
+    // The full header carries the names as serialized strings, the same
+    // bytes as before the IDs were interned
+    auto fullBytes = outgoing->toBytes();
+    IByteStream fullStream{Buffer{fullBytes}};
+    DSR<IByteStream> fullDs{fullStream};
+    std::string serviceName;
+    std::string operationName;
+    fullDs >> serviceName >> operationName;
+    EXPECT(serviceName == "wire.service" && operationName == "wire.op");
+    OByteStream baselineStream;
+    SR<OByteStream> baseline{baselineStream};
+    baseline.serializeBatch(std::string{"wire.service"}, std::string{"wire.op"},
+                            OpCode::Request, outgoing->requestID(),
+                            outgoing->sourceAddress(), CSPayloadType::NA);
+    baseline << Buffer{};
+    EXPECT(fullBytes == baselineStream.bytes());
+    EXPECT(incoming.fromBytes(Buffer{fullBytes}));
+    EXPECT(incoming.serviceID().name() == "wire.service");
+    EXPECT(incoming.operationID() == WireOp);
+
+    // Names built at run time are copied once
+    auto first = OpID{std::string{"wire.dynamic.op"}};
+    auto second = OpID{std::string{"wire.dynamic.op"}};
+    EXPECT(first.name().data() == second.name().data());
+    EXPECT(OpID::fromHash(first.hash()).name() == "wire.dynamic.op");
+    EXPECT(OpID::fromHash(OpID::hashOf("wire.unknown")).str()[0] == '#');
+
+    // A name ends at its NUL. Arrays are copied, not referred to, only
+    // fromLiteral keeps a view
+    static constexpr char padded[16] = "wire.op";
+    static_assert(OpID::fromLiteral(padded) == WireOp);
+    char buffer[64] = "wire.dynamic.op";
+    auto fromBuffer = OpID{buffer};
+    buffer[0] = 'x';
+    EXPECT(fromBuffer == first);
+    EXPECT(fromBuffer.name() == "wire.dynamic.op");
+    const char constBuffer[] = "wire.dynamic.op";
+    auto fromConstBuffer = OpID{constBuffer};
+    EXPECT(fromConstBuffer.name().data() == first.name().data());
+  }
+  TEST_CASE_E()
+}
+
+// Keeps what it is given to send, by destination
+struct RecordingSender : public BufferSenderIF {
+  ActionCallStatus send(const Buffer& bytes, const Address& addr) override {
+    std::lock_guard lock(mutex);
+    if (unreachable.count(addr) != 0) {
+      return ActionCallStatus::ReceiverUnavailable;
+    }
+    sent[addr].push_back(bytes);
+    return ActionCallStatus::Success;
+  }
+  void setReceiverGoneCallback(ReceiverGoneCallback callback) override {
+    receiverGone = std::move(callback);
+  }
+  Availability checkReceiverStatus(const Address&) const override {
+    return Availability::Available;
+  }
+  std::shared_ptr<local::LocalIPCMessage> last(const Address& addr,
+                                               size_t* size = nullptr) {
+    std::lock_guard lock(mutex);
+    auto msg = std::make_shared<local::LocalIPCMessage>();
+    if (auto it = sent.find(addr); it != sent.end() && !it->second.empty()) {
+      if (size) {
+        *size = it->second.back().size();
+      }
+      if (msg->fromBytes(Buffer{it->second.back()})) {
+        return msg;
+      }
+    }
+    return {};
+  }
+  std::mutex mutex;
+  std::map<Address, std::vector<Buffer>> sent;
+  std::set<Address> unreachable;
+  ReceiverGoneCallback receiverGone;
+};
+
+void compactHeaderTest() {
+  TEST_CASE_B(compact_header_negotiation) {
+    using namespace local;
+    auto request = createCSMessage<LocalIPCMessage>(
+        "compact.service", "compact.op", OpCode::Request, 7,
+        ParamTrait::translate(std::make_shared<std::string>("hi")),
+        Address{"maf.compact.client", 0});
+    auto full = request->toBytes();
+    auto compact = request->toBytes(HeaderVersion::Compact, 42);
+    EXPECT(compact.size() < full.size());
+    LocalIPCMessage decoded;
+    EXPECT(decoded.fromBytes(Buffer{compact}));
+    EXPECT(decoded.headerVersion() == HeaderVersion::Compact);
+    EXPECT(decoded.session() == 42 && decoded.requestID() == 7);
+    EXPECT(decoded.operationCode() == OpCode::Request);
+    EXPECT(decoded.operationID() == "compact.op");
+    EXPECT(*ParamTrait::translate<std::string>(decoded.payload()) == "hi");
+    std::cout << "Small request: " << full.size() << " bytes with the full "
+              << "header, " << compact.size() << " with the compact one"
+              << std::endl;
+
+    sharded_threadpool::init();
+    auto sender = std::make_unique<RecordingSender>();
+    auto& recording = *sender;
+    auto server = std::make_shared<LocalIPCServer>(
+        std::move(sender), std::make_unique<LocalIPCBufferReceiver>());
+    Address oldClient{"maf.compact.old", 0};
+    Address newClient{"maf.compact.new", 0};
+    server->onIncomingMessage(createCSMessage<LocalIPCMessage>(
+        ServiceIDInvalid, OpIDInvalid, OpCode::NegotiateHeader,
+        static_cast<RequestID>(HeaderVersion::Compact), nullptr, newClient));
+    auto reply = recording.last(newClient);
+    EXPECT(reply && reply->headerVersion() == HeaderVersion::Compact);
+    EXPECT(reply->session() != SessionHandleInvalid);
+
+    // The session stands for the address of the new client, the old one
+    // only speaks the full header
+    auto registerMsg = createCSMessage<LocalIPCMessage>(
+        ServiceIDInvalid, OpIDInvalid, OpCode::RegisterServiceStatus);
+    BytesComeObserver& observer = *server;
+    observer.onBytesCome(
+        registerMsg->toBytes(HeaderVersion::Compact, reply->session()));
+    registerMsg->setSourceAddress(oldClient);
+    observer.onBytesCome(registerMsg->toBytes());
+
+    std::shared_ptr<LocalIPCMessage> toOld;
+    std::shared_ptr<LocalIPCMessage> toNew;
+    size_t fullSize = 0;
+    size_t compactSize = 0;
+    for (int i = 0; i < 200; ++i) {
+      server->notifyServiceStatusToClient("compact.service",
+                                          Availability::Unavailable,
+                                          Availability::Available);
+      toOld = recording.last(oldClient, &fullSize);
+      toNew = recording.last(newClient, &compactSize);
+      if (toOld && toNew &&
+          toNew->operationCode() == OpCode::ServiceStatusUpdate) {
+        break;
+      }
+      std::this_thread::sleep_for(10ms);
+    }
+    EXPECT(toOld && toOld->headerVersion() == HeaderVersion::Full);
+    EXPECT(toNew && toNew->headerVersion() == HeaderVersion::Compact);
+    EXPECT(toNew->operationCode() == OpCode::ServiceStatusUpdate);
+    EXPECT(toNew->serviceID() == "compact.service");
+    EXPECT(compactSize < fullSize);
+  }
+  TEST_CASE_E()
+
+  TEST_CASE_B(sessions_end_with_their_clients) {
+    using namespace local;
+    // Still running from the previous case, the pool does not start again
+    sharded_threadpool::init();
+    auto sender = std::make_unique<RecordingSender>();
+    auto& recording = *sender;
+    auto server = std::make_shared<LocalIPCServer>(
+        std::move(sender), std::make_unique<LocalIPCBufferReceiver>());
+    EXPECT(server->init({"maf.sessions.server", 0}));
+    Address unreachable{"maf.sessions.unreachable", 0};
+    Address hungUp{"maf.sessions.hungup", 0};
+    BytesComeObserver& observer = *server;
+    // Negotiates the compact header then registers, returns the session
+    auto connect = [&](const Address& clAddr) {
+      server->onIncomingMessage(createCSMessage<LocalIPCMessage>(
+          ServiceIDInvalid, OpIDInvalid, OpCode::NegotiateHeader,
+          static_cast<RequestID>(HeaderVersion::Compact), nullptr, clAddr));
+      auto session = recording.last(clAddr)->session();
+      observer.onBytesCome(
+          createCSMessage<LocalIPCMessage>(ServiceIDInvalid, OpIDInvalid,
+                                           OpCode::RegisterServiceStatus)
+              ->toBytes(HeaderVersion::Compact, session));
+      return session;
+    };
+    // Header version of the service status the client gets next, Full once
+    // its session is closed
+    auto nextHeader = [&](const Address& clAddr) {
+      recording.mutex.lock();
+      recording.sent.clear();
+      recording.mutex.unlock();
+      server->onIncomingMessage(createCSMessage<LocalIPCMessage>(
+          ServiceIDInvalid, OpIDInvalid, OpCode::RegisterServiceStatus,
+          RequestIDInvalid, nullptr, clAddr));
+      server->notifyServiceStatusToClient("sessions.service",
+                                          Availability::Unavailable,
+                                          Availability::Available);
+      auto msg = recording.last(clAddr);
+      return msg ? msg->headerVersion() : HeaderVersion::Full;
+    };
+    // Messages from clients and gone receivers are handled asynchronously
+    auto headerBecomes = [&](const Address& clAddr, HeaderVersion version) {
+      for (int i = 0; i < 100 && nextHeader(clAddr) != version; ++i) {
+        std::this_thread::sleep_for(10ms);
+      }
+      return nextHeader(clAddr) == version;
+    };
+    EXPECT(connect(unreachable) != SessionHandleInvalid);
+    EXPECT(connect(hungUp) != SessionHandleInvalid);
+    EXPECT(headerBecomes(unreachable, HeaderVersion::Compact));
+
+    // Dropped as unreachable by a service status broadcast
+    recording.mutex.lock();
+    recording.unreachable.insert(unreachable);
+    recording.mutex.unlock();
+    server->notifyServiceStatusToClient("sessions.service",
+                                        Availability::Available,
+                                        Availability::Unavailable);
+    recording.mutex.lock();
+    recording.unreachable.clear();
+    recording.mutex.unlock();
+    EXPECT(nextHeader(unreachable) == HeaderVersion::Full);
+
+    // Found gone by the sender
+    EXPECT(headerBecomes(hungUp, HeaderVersion::Compact));
+    EXPECT(recording.receiverGone != nullptr);
+    recording.receiverGone(hungUp);
+    EXPECT(headerBecomes(hungUp, HeaderVersion::Full));
+    sharded_threadpool::deinit();
+  }
+  TEST_CASE_E()
+}
+
+void queuedSenderTest() {
+  TEST_CASE_B(slow_receiver_does_not_hold_up_others) {
+    for (auto policy :
+         {SlowReceiverPolicy::DropOldest, SlowReceiverPolicy::DropClient,
+          SlowReceiverPolicy::Block}) {
+      const size_t MessageCount = 200;
+      const size_t QueueLimit = 16;
+      const Buffer payload(16 * 1024, 'q');
+      Address stalledAddr{"maf.queued.stalled", 0};
+      Address healthyAddr{"maf.queued.healthy", 0};
+      auto stalled = local::LocalIPCBufferReceiver{};
+      auto healthy = local::LocalIPCBufferReceiver{};
+      auto stalledObserver = StalledBytesComeObserver{};
+      auto healthyObserver = CountingBytesComeObserver{};
+      EXPECT(stalled.init(stalledAddr));
+      EXPECT(healthy.init(healthyAddr));
+      stalled.setObserver(&stalledObserver);
+      healthy.setObserver(&healthyObserver);
+      std::thread stalledThread{[&stalled] { stalled.start(); }};
+      std::thread healthyThread{[&healthy] { healthy.start(); }};
+
+      auto sender = local::LocalIPCQueuedSender{policy, QueueLimit};
+      // Blocking sends wait on their own thread
+      std::atomic_size_t stalledAccepted = 0;
+      std::thread stalledSender{[&] {
+        for (size_t i = 0; i < MessageCount; ++i) {
+          if (sender.send(payload, stalledAddr) == ActionCallStatus::Success) {
+            ++stalledAccepted;
+          }
+        }
+      }};
+      if (policy != SlowReceiverPolicy::Block) {
+        stalledSender.join();
+      }
+
+      // The other receiver is served meanwhile, at the pace it reads
+      bool allAccepted = true;
+      bool allReceived = true;
+      for (size_t i = 1; i <= MessageCount; ++i) {
+        allAccepted &=
+            sender.send(payload, healthyAddr) == ActionCallStatus::Success;
+        if (i % QueueLimit == 0 || i == MessageCount) {
+          allReceived &= healthyObserver.waitFor(i);
+        }
+      }
+      EXPECT(allAccepted);
+      EXPECT(allReceived);
+
+      auto stats = sender.queueStats();
+      auto& stalledStats = stats[stalledAddr];
+      EXPECT(stalledStats.maxDepth <= QueueLimit);
+      EXPECT(stats[healthyAddr].sent == MessageCount);
+      if (policy == SlowReceiverPolicy::DropOldest) {
+        EXPECT(stalledAccepted == MessageCount);
+        EXPECT(stalledStats.dropped > 0);
+      } else if (policy == SlowReceiverPolicy::DropClient) {
+        EXPECT(stalledAccepted < MessageCount);
+        EXPECT(stalledStats.dropped > 0);
+      } else {
+        EXPECT(stalledAccepted < MessageCount);
+        EXPECT(stalledStats.depth == QueueLimit);
+      }
+      std::cout << "Policy " << static_cast<int>(policy)
+                << ": stalled receiver queue depth " << stalledStats.depth
+                << ", max " << stalledStats.maxDepth << ", sent " << stalledStats.sent
+                << ", dropped " << stalledStats.dropped << std::endl;
+
+      stalledObserver.release();
+      if (stalledSender.joinable()) {
+        stalledSender.join();
+        EXPECT(stalledObserver.waitFor(MessageCount));
+      }
+      stalled.stop();
+      healthy.stop();
+      stalledThread.join();
+      healthyThread.join();
+    }
+  }
+  TEST_CASE_E()
+
+  TEST_CASE_B(queued_sender_shares_frames) {
+    const size_t Threshold = 64 * 1024;
+    Address addrs[] = {{"maf.queued.shared.first", 0},
+                       {"maf.queued.shared.second", 0}};
+    local::LocalIPCBufferReceiver receivers[2];
+    SharedPayloadObserver observers[2];
+    std::thread receiverThreads[2];
+    for (int i = 0; i < 2; ++i) {
+      EXPECT(receivers[i].init(addrs[i]));
+      receivers[i].setObserver(&observers[i]);
+      receiverThreads[i] = std::thread{[&receiver = receivers[i]] {
+        receiver.start();
+      }};
+    }
+
+    auto sender = local::LocalIPCQueuedSender{SlowReceiverPolicy::Block,
+                                              DefaultSendQueueLimit, Threshold};
+    auto small = std::make_shared<const Buffer>(1024, 's');
+    auto large = std::make_shared<const Buffer>(Threshold * 4, 'l');
+    bool allAccepted = true;
+    for (auto& addr : addrs) {
+      allAccepted &= sender.sendShared(small, addr) == ActionCallStatus::Success;
+      allAccepted &= sender.sendShared(large, addr) == ActionCallStatus::Success;
+    }
+    EXPECT(allAccepted);
+    for (auto& observer : observers) {
+      EXPECT(observer.waitFor(2));
+      EXPECT(observer.copied == 1 && observer.shared == 1);
+      EXPECT(observer.lastShared.bytes == *large);
+    }
+
+    // A receiver gone away is forgotten, its destination is not kept
+    receivers[0].stop();
+    receiverThreads[0].join();
+    auto forgotten = false;
+    auto until = std::chrono::steady_clock::now() + 5s;
+    while (!forgotten && std::chrono::steady_clock::now() < until) {
+      forgotten = sender.queueStats().count(addrs[0]) == 0;
+      std::this_thread::sleep_for(1ms);
+    }
+    EXPECT(forgotten);
+    EXPECT(sender.queueStats().count(addrs[1]) == 1);
+    EXPECT(sender.sendShared(small, addrs[0]) ==
+           ActionCallStatus::ReceiverUnavailable);
+    receivers[1].stop();
+    receiverThreads[1].join();
+  }
+  TEST_CASE_E()
+}
+
+// Takes the bytes without sending them, leaves the server side cost only
+struct DiscardingSender : public BufferSenderIF {
+  ActionCallStatus send(const Buffer&, const Address&) override {
+    ++sent;
+    return ActionCallStatus::Success;
+  }
+  Availability checkReceiverStatus(const Address&) const override {
+    return Availability::Available;
+  }
+  size_t sent = 0;
+};
+
+// Microseconds taken to broadcast status rounds times to subscribers, one
+// address at a time then all at once
+static std::pair<long long, long long> timeBroadcasts(
+    local::LocalIPCServer& server, const CSMessagePtr& status,
+    const std::vector<Address>& subscribers, size_t rounds,
+    bool& allSucceeded) {
+  using namespace std::chrono;
+  auto start = steady_clock::now();
+  for (size_t r = 0; r < rounds; ++r) {
+    for (const auto& addr : subscribers) {
+      allSucceeded &= server.sendMessageToClient(status, addr) ==
+                      ActionCallStatus::Success;
+    }
+  }
+  auto perAddress = steady_clock::now() - start;
+  start = steady_clock::now();
+  for (size_t r = 0; r < rounds; ++r) {
+    for (auto result : server.sendMessageToClients(status, subscribers)) {
+      allSucceeded &= result == ActionCallStatus::Success;
+    }
+  }
+  auto once = steady_clock::now() - start;
+  return {duration_cast<microseconds>(perAddress).count(),
+          duration_cast<microseconds>(once).count()};
+}
+
+void broadcastTest() {
+  TEST_CASE_B(broadcast_serializes_once) {
+    const size_t SubscriberCount = 100;
+    auto status = createCSMessage<local::LocalIPCMessage>(
+        "broadcast.service", "broadcast.status", OpCode::StatusRegister,
+        RequestIDInvalid,
+        local::ParamTrait::translate(std::make_shared<std::string>(4096, 's')));
+    std::vector<Address> subscribers;
+    for (size_t i = 0; i < SubscriberCount; ++i) {
+      subscribers.emplace_back("maf.subscriber." + std::to_string(i), 0);
+    }
+
+    {
+      const size_t Rounds = 2000;
+      auto sender = std::make_unique<DiscardingSender>();
+      auto& discarding = *sender;
+      local::LocalIPCServer server{
+          std::move(sender), std::make_unique<local::LocalIPCBufferReceiver>()};
+      bool allSucceeded = true;
+      auto [perAddress, once] =
+          timeBroadcasts(server, status, subscribers, Rounds, allSucceeded);
+      EXPECT(allSucceeded);
+      EXPECT(discarding.sent == 2 * Rounds * SubscriberCount);
+      std::cout << "Broadcast of 4KiB to " << SubscriberCount
+                << " subscribers, no transport: " << perAddress / Rounds
+                << "us serialized per subscriber, " << once / Rounds
+                << "us serialized once" << std::endl;
+    }
+
+    {
+      const size_t Rounds = 100;
+      std::vector<std::unique_ptr<local::LocalIPCBufferReceiver>> receivers;
+      std::vector<std::unique_ptr<CountingBytesComeObserver>> observers;
+      std::vector<std::thread> receiverThreads;
+      for (const auto& addr : subscribers) {
+        auto& receiver = receivers.emplace_back(
+            std::make_unique<local::LocalIPCBufferReceiver>());
+        auto& observer =
+            observers.emplace_back(std::make_unique<CountingBytesComeObserver>());
+        EXPECT(receiver->init(addr));
+        receiver->setObserver(observer.get());
+        receiverThreads.emplace_back(
+            [receiver = receiver.get()] { receiver->start(); });
+      }
+      local::LocalIPCServer server;
+      // Connections are opened before timing
+      server.sendMessageToClients(status, subscribers);
+      bool allSucceeded = true;
+      auto [perAddress, once] =
+          timeBroadcasts(server, status, subscribers, Rounds, allSucceeded);
+      EXPECT(allSucceeded);
+      bool allReceived = true;
+      for (auto& observer : observers) {
+        allReceived &= observer->waitFor(2 * Rounds + 1);
+      }
+      EXPECT(allReceived);
+      std::cout << "Broadcast of 4KiB to " << SubscriberCount
+                << " subscribers, sockets: " << perAddress / Rounds
+                << "us serialized per subscriber, " << once / Rounds
+                << "us serialized once" << std::endl;
+      for (auto& receiver : receivers) {
+        receiver->stop();
+      }
+      for (auto& th : receiverThreads) {
+        th.join();
+      }
+    }
+  }
+  TEST_CASE_E()
+}
+
+// Replies to every message with the same bytes
+struct EchoBytesComeObserver : public BytesComeObserver {
+  EchoBytesComeObserver(BufferSenderIF& sender, Address replyTo)
+      : sender{sender}, replyTo{std::move(replyTo)} {}
+  void onBytesCome(Buffer&& buff) override { sender.send(buff, replyTo); }
+  BufferSenderIF& sender;
+  Address replyTo;
+};
+
+struct TransportResult {
+  long long throughputUs = -1;
+  long long roundTripNs = -1;
+};
+
+template <class Sender, class Receiver>
+static TransportResult measureTransport(const std::string& name,
+                                        size_t messageSize) {
+  const size_t MessageCount = messageSize >= 64 * 1024 ? 2000 : 20000;
+  const size_t RoundTrips = 2000;
+  Address pingAddr{"maf.bench." + name + ".ping", 0};
+  Address pongAddr{"maf.bench." + name + ".pong", 0};
+  TransportResult result;
+
+  Sender sender, echoSender;
+  Receiver pingReceiver, pongReceiver;
+  CountingBytesComeObserver counter;
+  EchoBytesComeObserver echo{echoSender, pingAddr};
+  if (!pingReceiver.init(pingAddr) || !pongReceiver.init(pongAddr)) {
+    return result;
+  }
+  pingReceiver.setObserver(&counter);
+  pongReceiver.setObserver(&counter);
+  std::thread pingThread{[&pingReceiver] { pingReceiver.start(); }};
+  std::thread pongThread{[&pongReceiver] { pongReceiver.start(); }};
+
+  const Buffer message(messageSize, 'x');
+  auto start = std::chrono::steady_clock::now();
+  for (size_t m = 0; m < MessageCount; ++m) {
+    sender.send(message, pongAddr);
+  }
+  if (counter.waitFor(MessageCount)) {
+    result.throughputUs =
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start)
+            .count();
+  }
+
+  counter.count = 0;
+  pongReceiver.setObserver(&echo);
+  start = std::chrono::steady_clock::now();
+  size_t trip = 0;
+  for (; trip < RoundTrips; ++trip) {
+    sender.send(message, pongAddr);
+    // Spinning, a sleeping poll would hide the transport latency
+    auto until = std::chrono::steady_clock::now() + 5s;
+    while (counter.count <= trip && std::chrono::steady_clock::now() < until) {
+      std::this_thread::yield();
+    }
+    if (counter.count <= trip) {
+      break;
+    }
+  }
+  if (trip == RoundTrips) {
+    result.roundTripNs =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start)
+            .count() /
+        RoundTrips;
+  }
+
+  pingReceiver.stop();
+  pongReceiver.stop();
+  pingThread.join();
+  pongThread.join();
+  return result;
+}
+
+void transportComparison() {
+  TEST_CASE_B(shm_ring_needs_shrink_seal) {
+    // A peer could truncate an unsealed segment under the receiver
+    const auto capacity = uint32_t{4096};
+    auto segment = [&](bool sealed) {
+      AutoCloseFD<FD> memfd =
+          memfd_create("maf.test.ring", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+      if (ftruncate(memfd, local::ShmRing::segmentSize(capacity)) != 0 ||
+          (sealed && fcntl(memfd, F_ADD_SEALS, F_SEAL_SHRINK) != 0)) {
+        memfd.reset();
+      }
+      return memfd;
+    };
+    auto unsealed = segment(false);
+    auto sealed = segment(true);
+    local::ShmRing producer, unsealedConsumer, sealedConsumer;
+    EXPECT(unsealed != INVALID_FD && sealed != INVALID_FD);
+    EXPECT(producer.create(sealed, capacity));
+    EXPECT(!unsealedConsumer.attach(unsealed));
+    EXPECT(sealedConsumer.attach(sealed));
+  }
+  TEST_CASE_E()
+
+  TEST_CASE_B(socket_vs_shared_memory_transport) {
+    for (size_t size : {64, 4096, 256 * 1024}) {
+      auto socket =
+          measureTransport<local::LocalIPCBufferSender,
+                           local::LocalIPCBufferReceiver>("socket", size);
+      auto shm = measureTransport<local::ShmBufferSender,
+                                  local::ShmBufferReceiver>("shm", size);
+      EXPECT(socket.throughputUs >= 0 && socket.roundTripNs >= 0);
+      EXPECT(shm.throughputUs >= 0 && shm.roundTripNs >= 0);
+      std::cout << size << " bytes: socket " << socket.throughputUs
+                << "us, round trip " << socket.roundTripNs / 1000
+                << "us | shared memory " << shm.throughputUs
+                << "us, round trip " << shm.roundTripNs / 1000 << "us"
+                << std::endl;
+    }
+  }
+  TEST_CASE_E()
+}
+
 int main() {
   using namespace maf::logging;
   // maf::logging::init(LOG_LEVEL_ERROR | LOG_LEVEL_INFO,
   //                   [](const auto& msg) { std::cout << msg << std::endl; });
   maf::test::init_test_cases();
   test();
+  reconnectTest();
+  livenessTest();
+  manyConnectionsTest();
+  sharedPayloadTest();
+  internedIDTest();
+  compactHeaderTest();
+  batchedOrderTest();
+  broadcastTest();
+  queuedSenderTest();
+  throughputBenchmark();
+  transportComparison();
 }
@@ -0,0 +1,197 @@
+#include <maf/threading/Queue.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "test.h"
+
+using namespace std;
+using namespace chrono;
+using namespace maf::threading;
+
+static constexpr int ITEM_COUNT = 200000;
+static constexpr size_t BATCH_SIZE = 32;
+template <class QueueType>
+static constexpr bool BATCHABLE = !is_same_v<QueueType, Queue<int>>;
+
+// Every producer pushes its share of 1..ITEM_COUNT, consumers pop until the
+// queue is closed. Returns the elapsed time, or -1 if an item got lost
+template <class QueueType>
+static long long contentionRun(QueueType &queue, int producers, int consumers,
+                               bool batched) {
+  atomic<long long> sum = 0;
+  vector<thread> consumerThreads;
+  for (int c = 0; c < consumers; ++c) {
+    consumerThreads.emplace_back([&queue, &sum, batched] {
+      long long local = 0;
+      if constexpr (BATCHABLE<QueueType>) {
+        int values[BATCH_SIZE];
+        while (batched) {
+          auto n = queue.popN(values, BATCH_SIZE);
+          if (n == 0) {
+            break;
+          }
+          local = accumulate(values, values + n, local);
+        }
+      }
+      int value;
+      while (!batched && queue.wait(value)) {
+        local += value;
+      }
+      sum.fetch_add(local);
+    });
+  }
+
+  auto start = steady_clock::now();
+  vector<thread> producerThreads;
+  for (int p = 0; p < producers; ++p) {
+    producerThreads.emplace_back([&queue, p, producers, batched] {
+      vector<int> values;
+      for (int v = p + 1; v <= ITEM_COUNT; v += producers) {
+        values.push_back(v);
+      }
+      if constexpr (BATCHABLE<QueueType>) {
+        for (size_t i = 0; batched && i < values.size(); i += BATCH_SIZE) {
+          auto last = min(values.size(), i + BATCH_SIZE);
+          queue.pushN(values.begin() + long(i), values.begin() + long(last));
+        }
+      }
+      for (size_t i = 0; !batched && i < values.size(); ++i) {
+        queue.push(values[i]);
+      }
+    });
+  }
+  for (auto &t : producerThreads) {
+    t.join();
+  }
+  while (!queue.empty()) {
+    this_thread::yield();
+  }
+  auto elapsed = duration_cast<microseconds>(steady_clock::now() - start);
+  queue.close();
+  for (auto &t : consumerThreads) {
+    t.join();
+  }
+  auto expected = (long long)ITEM_COUNT * (ITEM_COUNT + 1) / 2;
+  return sum.load() == expected ? elapsed.count() : -1;
+}
+
+static void boundedQueueTest() {
+  TEST_CASE_B(bounded_queue)
+  BoundedQueue<unique_ptr<string>> queue{4};
+  EXPECT(queue.capacity() == 4);
+  for (int i = 0; i < 4; ++i) {
+    EXPECT(queue.tryPush(make_unique<string>(to_string(i))));
+  }
+  auto extra = make_unique<string>("extra");
+  EXPECT(!queue.tryPush(std::move(extra)));
+  EXPECT(extra && *extra == "extra");
+
+  unique_ptr<string> value;
+  EXPECT(queue.tryPop(value) && *value == "0");
+  EXPECT(queue.waitFor(value, 10) && *value == "1");
+  vector<unique_ptr<string>> rest(4);
+  EXPECT(queue.popN(rest.begin(), rest.size()) == 2);
+  EXPECT(*rest[0] == "2" && *rest[1] == "3");
+  EXPECT(!queue.waitFor(value, milliseconds{10}));
+
+  auto waiter = async(launch::async, [&queue] {
+    unique_ptr<string> v;
+    return queue.wait(v);
+  });
+  this_thread::sleep_for(milliseconds{10});
+  queue.close();
+  EXPECT(waiter.wait_for(seconds{5}) == future_status::ready);
+  EXPECT(!waiter.get());
+  EXPECT(!queue.push(make_unique<string>("closed")));
+  TEST_CASE_E()
+}
+
+static void blockingPushTest() {
+  TEST_CASE_B(blocking_push)
+  BoundedQueue<int> queue{2};
+  vector<int> values(100);
+  iota(values.begin(), values.end(), 0);
+  auto producer = async(launch::async, [&] {
+    return queue.pushN(values.begin(), values.end());
+  });
+  vector<int> received;
+  int value;
+  while (received.size() < values.size() && queue.waitFor(value, 1000)) {
+    received.push_back(value);
+  }
+  EXPECT(producer.get() == values.size());
+  EXPECT(received == values);
+  TEST_CASE_E()
+}
+
+static void spscQueueTest() {
+  TEST_CASE_B(spsc_queue)
+  SPSCQueue<int> queue{64};
+  auto producer = async(launch::async, [&queue] {
+    int batch[7];
+    for (int v = 0; v < ITEM_COUNT; v += 7) {
+      auto n = min(7, ITEM_COUNT - v);
+      iota(batch, batch + n, v);
+      queue.pushN(batch, batch + n);
+    }
+  });
+  bool inOrder = true;
+  int expected = 0;
+  int values[16];
+  while (expected < ITEM_COUNT) {
+    auto n = queue.popN(values, 16);
+    for (size_t i = 0; i < n; ++i) {
+      inOrder = inOrder && values[i] == expected++;
+    }
+  }
+  producer.get();
+  EXPECT(inOrder);
+  EXPECT(queue.empty());
+  TEST_CASE_E()
+}
+
+static void contentionBenchmark() {
+  TEST_CASE_B(contention_benchmark)
+  for (int threads : {1, 2, 4, 8, 16}) {
+    Queue<int> locked;
+    auto lockedTime = contentionRun(locked, threads, threads, false);
+    BoundedQueue<int> ring;
+    auto ringTime = contentionRun(ring, threads, threads, false);
+    BoundedQueue<int> batchedRing;
+    auto batchedTime = contentionRun(batchedRing, threads, threads, true);
+    cout << threads << " producers/" << threads << " consumers, "
+         << ITEM_COUNT << " items: ThreadSafeQueue " << lockedTime
+         << "us, BoundedQueue " << ringTime << "us, BoundedQueue pushN/popN "
+         << batchedTime << "us" << endl;
+    EXPECT(lockedTime >= 0 && ringTime >= 0 && batchedTime >= 0);
+  }
+  Queue<int> locked;
+  auto lockedTime = contentionRun(locked, 1, 1, false);
+  SPSCQueue<int> spsc;
+  auto spscTime = contentionRun(spsc, 1, 1, false);
+  SPSCQueue<int> batchedSpsc;
+  auto batchedTime = contentionRun(batchedSpsc, 1, 1, true);
+  cout << "1 producer/1 consumer, " << ITEM_COUNT
+       << " items: ThreadSafeQueue " << lockedTime << "us, SPSCQueue "
+       << spscTime << "us, SPSCQueue pushN/popN " << batchedTime << "us"
+       << endl;
+  EXPECT(lockedTime >= 0 && spscTime >= 0 && batchedTime >= 0);
+  TEST_CASE_E()
+}
+
+int main() {
+  cout.sync_with_stdio(false);
+  maf::test::init_test_cases();
+  boundedQueueTest();
+  blockingPushTest();
+  spscQueueTest();
+  contentionBenchmark();
+  return 0;
+}
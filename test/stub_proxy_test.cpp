@@ -2,6 +2,8 @@
 #include <maf/ITCStub.h>
 #include <maf/LocalIPCProxy.h>
 #include <maf/LocalIPCStub.h>
+#include <maf/LocalShmProxy.h>
+#include <maf/LocalShmStub.h>
 #include <maf/logging/Logger.h>
 #include <maf/messaging/client-server/ServiceStatusSignal.h>
 #include <maf/threading/AtomicObject.h>
@@ -13,6 +15,7 @@
 #include <iostream>
 #include <map>
 #include <set>
+#include <thread>
 
 #include "test.h"
 
@@ -55,6 +58,17 @@ PROPERTY(varied_string)
 	STATUS((std::string, its_status))
 ENDPROPERTY()
 
+PROPERTY(counter)
+    using History = std::vector<int>;
+    STATUS
+    (
+        (std::string, label),
+        (int, count),
+        (History, history),
+        (bool, even)
+    )
+ENDPROPERTY()
+
 // clang-format on
 
 #include <maf/messaging/client-server/CSContractDefinesEnd.mc.h>
@@ -62,6 +76,7 @@ ENDPROPERTY()
 using namespace maf::messaging;
 using namespace maf::util;
 namespace localipc = maf::localipc;
+namespace localshm = maf::localshm;
 namespace itc = maf::itc;
 using namespace std::chrono_literals;
 
@@ -376,9 +391,219 @@ class Tester {
     }
     TEST_CASE_E(broad_cast_status_signal)
 
+    TEST_CASE_B(status_changes_patch_cached_status) {
+      // Only the count changes, the other fields come from the cached status
+      const std::string label = "counter";
+      const counter_property::History history(64, 7);
+      const int LastCount = 40;
+      std::atomic_int lastCount = -1;
+      std::atomic_bool othersKept = true;
+      std::atomic_bool evenKept = true;
+      auto regID = proxy->template registerStatus<counter_property::status>(
+          [&](counter_property::status_cptr status) {
+            othersKept = othersKept && status->get_label() == label &&
+                         status->get_history() == history;
+            evenKept = evenKept &&
+                       status->get_even() == (status->get_count() % 2 == 0);
+            lastCount = status->get_count();
+          });
+      std::this_thread::sleep_for(1ms);
+
+      for (int count = 0; count <= LastCount; ++count) {
+        stub->template setStatus<counter_property::status>(
+            label, count, history, count % 2 == 0);
+      }
+      for (int i = 0; i < 100 && lastCount != LastCount; ++i) {
+        std::this_thread::sleep_for(10ms);
+      }
+      EXPECT(lastCount == LastCount);
+      EXPECT(othersKept);
+      EXPECT(evenKept);
+      auto cached = proxy->template getStatus<counter_property::status>();
+      EXPECT(cached && cached->get_count() == LastCount);
+      EXPECT(cached->get_label() == label && cached->get_history() == history);
+      proxy->unregister(regID);
+    }
+    TEST_CASE_E(status_changes_patch_cached_status)
+
+    TEST_CASE_B(registering_while_status_changes) {
+      // The label changes every 10 counts, a subscriber patching changes onto
+      // an older status than the one they were made against mixes them up
+      auto labelOf = [](int count) {
+        return "tens" + std::to_string(count / 10 * 10);
+      };
+      const int LastCount = 3000;
+      // Callbacks may still be queued on the executor after unregistering
+      auto mixedUp = std::make_shared<std::atomic_int>(0);
+      auto received = std::make_shared<std::atomic_int>(0);
+      std::atomic_bool published = false;
+      stub->template setStatus<counter_property::status>(
+          labelOf(0), 0, counter_property::History{}, true);
+      std::this_thread::sleep_for(10ms);
+
+      std::thread publisher{[&] {
+        for (int count = 1; count <= LastCount; ++count) {
+          stub->template setStatus<counter_property::status>(
+              labelOf(count), count, counter_property::History{},
+              count % 2 == 0);
+        }
+        published = true;
+      }};
+      auto check = [labelOf, mixedUp,
+                    received](counter_property::status_cptr status) {
+        if (status->get_label() != labelOf(status->get_count())) {
+          ++*mixedUp;
+        }
+        ++*received;
+      };
+      while (!published) {
+        auto regID =
+            proxy->template registerStatus<counter_property::status>(check);
+        std::this_thread::sleep_for(1ms);
+        proxy->unregister(regID);
+      }
+      publisher.join();
+      std::this_thread::sleep_for(10ms);
+      EXPECT(*received > 0);
+      EXPECT(*mixedUp == 0);
+    }
+    TEST_CASE_E(registering_while_status_changes)
+
+    TEST_CASE_B(status_publishing_is_rate_limited) {
+      // Updates within an interval coalesce, the last one is flushed
+      const int LastCount = 1000;
+      const auto Interval = 50ms;
+      std::atomic_int received = 0;
+      std::atomic_int lastCount = -1;
+      stub->template setPublishInterval<counter_property::status>(Interval);
+      auto regID = proxy->template registerStatus<counter_property::status>(
+          [&](counter_property::status_cptr status) {
+            ++received;
+            lastCount = status->get_count();
+          });
+      std::this_thread::sleep_for(1ms);
+
+      auto start = std::chrono::steady_clock::now();
+      for (int count = 0; count <= LastCount; ++count) {
+        stub->template setStatus<counter_property::status>(
+            "limited", count, counter_property::History{}, false);
+      }
+      auto elapsed = std::chrono::steady_clock::now() - start;
+      for (int i = 0; i < 100 && lastCount != LastCount; ++i) {
+        std::this_thread::sleep_for(10ms);
+      }
+      EXPECT(lastCount == LastCount);
+      EXPECT(received <= 3 + elapsed / Interval);
+      EXPECT(stub->template getStatus<counter_property::status>()->get_count() ==
+             LastCount);
+      proxy->unregister(regID);
+      stub->template setPublishInterval<counter_property::status>(0ms);
+    }
+    TEST_CASE_E(status_publishing_is_rate_limited)
+
+    TEST_CASE_B(server_filters_status_updates) {
+      using Counts = std::vector<int>;
+      maf::threading::AtomicObject<Counts> received;
+      auto collect = [&](counter_property::status_cptr status) {
+        received->push_back(status->get_count());
+      };
+      auto waitFor = [&](size_t count) -> Counts {
+        for (int i = 0; i < 100 && received->size() < count; ++i) {
+          std::this_thread::sleep_for(10ms);
+        }
+        std::this_thread::sleep_for(10ms);
+        return **received;
+      };
+      auto setCounts = [&](int from, int to) {
+        for (int count = from; count <= to; ++count) {
+          stub->template setStatus<counter_property::status>(
+              "filtered", count, counter_property::History{}, false);
+        }
+      };
+      stub->template setStatus<counter_property::status>(
+          "filtered", -1, counter_property::History{}, false);
+
+      // Field 1 is the count
+      auto regID = proxy->template registerStatus<counter_property::status>(
+          collect,
+          {SubscriptionFilter::range(1, 10, 20), SubscriptionFilter::everyNth(2)});
+      std::this_thread::sleep_for(1ms);
+      setCounts(0, 40);
+      EXPECT(waitFor(6) == Counts({10, 12, 14, 16, 18, 20}));
+      proxy->unregister(regID);
+      std::this_thread::sleep_for(1ms);
+
+      received->clear();
+      regID = proxy->template registerStatus<counter_property::status>(
+          collect, {SubscriptionFilter::changeAtLeast(1, 5)});
+      std::this_thread::sleep_for(1ms);
+      setCounts(41, 60);
+      EXPECT(waitFor(5) == Counts({40, 45, 50, 55, 60}));
+      proxy->unregister(regID);
+    }
+    TEST_CASE_E(server_filters_status_updates)
+
+    TEST_CASE_B(callbacks_with_other_filters_get_their_own_updates) {
+      using Counts = std::vector<int>;
+      maf::threading::AtomicObject<Counts> filtered, all;
+      auto waitFor = [](maf::threading::AtomicObject<Counts> &received,
+                        size_t count) -> Counts {
+        for (int i = 0; i < 100 && received->size() < count; ++i) {
+          std::this_thread::sleep_for(10ms);
+        }
+        std::this_thread::sleep_for(10ms);
+        return **received;
+      };
+      auto setCounts = [&](int from, int to) {
+        for (int count = from; count <= to; ++count) {
+          stub->template setStatus<counter_property::status>(
+              "shared", count, counter_property::History{}, false);
+        }
+      };
+      auto countsFrom = [](int from, int to) {
+        Counts counts;
+        for (int count = from; count <= to; ++count) {
+          counts.push_back(count);
+        }
+        return counts;
+      };
+      stub->template setStatus<counter_property::status>(
+          "shared", -1, counter_property::History{}, false);
+      // Lets the updates sent for the previous case arrive first
+      std::this_thread::sleep_for(10ms);
+
+      auto filteredRegID =
+          proxy->template registerStatus<counter_property::status>(
+              [&](counter_property::status_cptr status) {
+                filtered->push_back(status->get_count());
+              },
+              {SubscriptionFilter::range(1, 10, 20)});
+      std::this_thread::sleep_for(1ms);
+      setCounts(0, 12);
+      EXPECT(waitFor(filtered, 3) == countsFrom(10, 12));
+
+      // The later unfiltered callback gets every update, the first one
+      // still only those in its range
+      auto allRegID = proxy->template registerStatus<counter_property::status>(
+          [&](counter_property::status_cptr status) {
+            all->push_back(status->get_count());
+          });
+      EXPECT(waitFor(all, 1) == Counts{12});
+      setCounts(13, 25);
+      EXPECT(waitFor(all, 14) == countsFrom(12, 25));
+      EXPECT(waitFor(filtered, 11) == countsFrom(10, 20));
+      proxy->unregister(filteredRegID);
+      proxy->unregister(allRegID);
+    }
+    TEST_CASE_E(callbacks_with_other_filters_get_their_own_updates)
+
+    // Pending requests are broken before status observers are notified, wait
+    // for the observers before checking the status
+    auto stoppedSignal = serviceStatusSignal(proxy);
     auto callstatus = ActionCallStatus{};
     auto response =
         proxy->template sendRequest<no_response_request>(&callstatus);
+    stoppedSignal->waitIfNot(Availability::Unavailable, 100ms);
 
     TEST_CASE_B(stopable_sync_request) {
       EXPECT(callstatus == ActionCallStatus::ActionBroken);
@@ -413,6 +638,21 @@ void testLocalIPC() {
   tester.test();
 }
 
+void testLocalShm() {
+  using namespace localshm;
+  maf::test::log_rec()
+      << "--------------START LOCAL SHARED MEMORY IPC TEST ------------";
+  Address addr{"maf.request_response_test.shm", 0};
+
+  auto stub = createStub(addr, ServiceIDTest);
+  while (!stub) {
+    std::this_thread::sleep_for(10ms);
+    stub = createStub(addr, ServiceIDTest);
+  };
+  Tester<localshm::ParamTrait> tester{stub, createProxy(addr, ServiceIDTest)};
+  tester.test();
+}
+
 void testITC() {
   using namespace itc;
 
@@ -423,6 +663,51 @@ void testITC() {
   tester.test();
 }
 
+// Sync round trips of the same request, through messages and directly
+void testITCDirectRequests() {
+  using namespace itc;
+  using Request = itc::Stub::Request<string_request::input>;
+  constexpr int Count = 20000;
+
+  auto measure = [](const ServiceID& sid, bool direct, bool& allAnswered) {
+    maf::messaging::itc::setDirectRequests(direct);
+    auto stub = createStub(sid, directExecutor());
+    stub->registerRequestHandler<string_request::input>([](Request request) {
+      request.respond<string_request::output>(
+          request.getInput()->get_string_input());
+    });
+    auto proxy = createProxy(sid, directExecutor());
+    stub->startServing();
+    serviceStatusSignal(proxy)->waitIfNot(Availability::Available);
+
+    auto input = string_request::make_input("ping");
+    auto start = std::chrono::steady_clock::now();
+    allAnswered = true;
+    for (int i = 0; i < Count; ++i) {
+      auto response = proxy->sendRequest<string_request::output>(input);
+      allAnswered = allAnswered && response.isOutput() &&
+                    response.getOutput()->get_string_output() == "ping";
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    stub->stopServing();
+    maf::messaging::itc::setDirectRequests(true);
+    return std::chrono::duration_cast<std::chrono::microseconds>(elapsed);
+  };
+
+  TEST_CASE_B(itc_direct_requests) {
+    bool throughMessages = false;
+    bool direct = false;
+    auto messagesTime = measure("itc.bench.messages", false, throughMessages);
+    auto directTime = measure("itc.bench.direct", true, direct);
+    maf::test::log_rec() << Count << " ITC requests: " << messagesTime.count()
+                         << "us through messages, " << directTime.count()
+                         << "us direct";
+    EXPECT(throughMessages);
+    EXPECT(direct);
+  }
+  TEST_CASE_E(itc_direct_requests)
+}
+
 int main() {
   //  maf::logging::init(maf::logging::LOG_LEVEL_FROM_INFO |
   //                         maf::logging::LOG_LEVEL_VERBOSE |
@@ -434,6 +719,8 @@ int main() {
   });
   maf::test::init_test_cases();
   testLocalIPC();
+  testLocalShm();
   testITC();
+  testITCDirectRequests();
   return 0;
 }
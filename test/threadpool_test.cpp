@@ -0,0 +1,428 @@
+#include <maf/messaging/Component.h>
+#include <maf/threading/ElasticThreadPool.h>
+#include <maf/threading/Parallel.h>
+#include <maf/threading/PriorityThreadPool.h>
+#include <maf/threading/ThreadPoolFactory.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "test.h"
+
+using namespace std;
+using namespace chrono;
+using namespace maf::threading;
+
+struct CountingTask : public Runnable {
+  CountingTask(atomic<int> &counter) : counter_{counter} {
+    setAutoDeleted(true);
+  }
+  void run() override { counter_.fetch_add(1, memory_order_relaxed); }
+  atomic<int> &counter_;
+};
+
+// Splits itself in two until depth reaches 0, the way divide and conquer
+// algorithms feed a pool from its own threads
+struct SplittingTask : public Runnable {
+  SplittingTask(IThreadPool *pool, atomic<int> &counter, int depth)
+      : pool_{pool}, counter_{counter}, depth_{depth} {
+    setAutoDeleted(true);
+  }
+  void run() override {
+    if (depth_ > 0) {
+      pool_->run(new SplittingTask{pool_, counter_, depth_ - 1});
+      pool_->run(new SplittingTask{pool_, counter_, depth_ - 1});
+    }
+    counter_.fetch_add(1, memory_order_relaxed);
+  }
+  IThreadPool *pool_;
+  atomic<int> &counter_;
+  int depth_;
+};
+
+static bool waitForCount(const atomic<int> &counter, int expected,
+                         milliseconds timeout = seconds{20}) {
+  auto until = steady_clock::now() + timeout;
+  while (counter.load() < expected && steady_clock::now() < until) {
+    this_thread::yield();
+  }
+  return counter.load() == expected;
+}
+
+static const char *poolName(PoolType type) {
+  switch (type) {
+  case StableCount:
+    return "StableCount";
+  case WorkStealing:
+    return "WorkStealing";
+  default:
+    return "Other";
+  }
+}
+
+static long long externalSubmissionRun(PoolType type, int taskCount) {
+  atomic<int> counter = 0;
+  auto pool = ThreadPoolFactory::createPool(type, 4);
+  auto start = steady_clock::now();
+  for (int i = 0; i < taskCount; ++i) {
+    pool->run(new CountingTask{counter});
+  }
+  auto ok = waitForCount(counter, taskCount);
+  auto elapsed = duration_cast<microseconds>(steady_clock::now() - start);
+  cout << poolName(type) << ": " << taskCount
+       << " tasks submitted from outside in " << elapsed.count() << "us"
+       << endl;
+  return ok ? elapsed.count() : -1;
+}
+
+static long long nestedSubmissionRun(PoolType type, int depth) {
+  atomic<int> counter = 0;
+  auto expected = (1 << (depth + 1)) - 1;
+  auto pool = ThreadPoolFactory::createPool(type, 4);
+  auto start = steady_clock::now();
+  pool->run(new SplittingTask{pool.get(), counter, depth});
+  auto ok = waitForCount(counter, expected);
+  auto elapsed = duration_cast<microseconds>(steady_clock::now() - start);
+  cout << poolName(type) << ": " << expected
+       << " tasks submitted from pool threads in " << elapsed.count() << "us"
+       << endl;
+  return ok ? elapsed.count() : -1;
+}
+
+static void externalSubmissionTest() {
+  TEST_CASE_B(work_stealing_external_submission)
+  EXPECT(externalSubmissionRun(StableCount, 200000) >= 0);
+  EXPECT(externalSubmissionRun(WorkStealing, 200000) >= 0);
+  TEST_CASE_E()
+}
+
+static void nestedSubmissionTest() {
+  TEST_CASE_B(work_stealing_nested_submission)
+  auto stable = nestedSubmissionRun(StableCount, 17);
+  auto stealing = nestedSubmissionRun(WorkStealing, 17);
+  EXPECT(stable >= 0);
+  EXPECT(stealing >= 0);
+  if (stealing > 0) {
+    cout << "Speedup of work stealing on nested tasks: "
+         << static_cast<double>(stable) / stealing << endl;
+  }
+  TEST_CASE_E()
+}
+
+static void shutdownTest() {
+  TEST_CASE_B(work_stealing_shutdown)
+  struct TrackedTask : public Runnable {
+    TrackedTask(atomic<int> &destroyed) : destroyed_{destroyed} {
+      setAutoDeleted(true);
+    }
+    ~TrackedTask() override { destroyed_.fetch_add(1); }
+    void run() override { this_thread::sleep_for(microseconds{50}); }
+    atomic<int> &destroyed_;
+  };
+
+  atomic<int> destroyed = 0;
+  auto pool = ThreadPoolFactory::createPool(WorkStealing, 2);
+  for (int i = 0; i < 1000; ++i) {
+    pool->run(new TrackedTask{destroyed});
+  }
+  pool->shutdown();
+  // Tasks that didn't get to run are still released
+  EXPECT(destroyed.load() == 1000);
+  pool->run(new TrackedTask{destroyed});
+  EXPECT(destroyed.load() == 1001);
+  TEST_CASE_E()
+}
+
+struct SleepingTask : public Runnable {
+  SleepingTask(atomic<int> &counter, milliseconds duration)
+      : counter_{counter}, duration_{duration} {
+    setAutoDeleted(true);
+  }
+  void run() override {
+    this_thread::sleep_for(duration_);
+    counter_.fetch_add(1);
+  }
+  atomic<int> &counter_;
+  milliseconds duration_;
+};
+
+static void elasticGrowAndShrinkTest() {
+  TEST_CASE_B(elastic_grow_and_shrink)
+  ElasticThreadPool::Config config;
+  config.minThreads = 2;
+  config.maxThreads = 16;
+  config.idleTimeout = milliseconds{50};
+  ElasticThreadPool pool{config};
+  EXPECT(pool.activeThreadCount() == 2);
+
+  atomic<int> counter = 0;
+  for (int i = 0; i < 64; ++i) {
+    pool.run(new SleepingTask{counter, milliseconds{10}});
+  }
+  EXPECT(pool.stats().spawned == 16);
+  EXPECT(waitForCount(counter, 64));
+
+  this_thread::sleep_for(milliseconds{300});
+  auto stats = pool.stats();
+  EXPECT(stats.alive == 2);
+  EXPECT(stats.retired == stats.spawned - 2);
+
+  // a single slow stream of tasks doesn't need more than the minimum
+  for (int i = 0; i < 5; ++i) {
+    pool.run(new SleepingTask{counter, milliseconds{1}});
+    this_thread::sleep_for(milliseconds{5});
+  }
+  EXPECT(waitForCount(counter, 69));
+  EXPECT(pool.stats().spawned == stats.spawned);
+  TEST_CASE_E()
+}
+
+static void elasticSetMaxThreadCountTest() {
+  TEST_CASE_B(elastic_set_max_thread_count)
+  ElasticThreadPool::Config config;
+  config.maxThreads = 8;
+  config.idleTimeout = seconds{10};
+  ElasticThreadPool pool{config};
+  atomic<int> counter = 0;
+  for (int i = 0; i < 32; ++i) {
+    pool.run(new SleepingTask{counter, milliseconds{5}});
+  }
+  EXPECT(pool.activeThreadCount() == 8);
+  pool.setMaxThreadCount(3);
+  EXPECT(waitForCount(counter, 32));
+  this_thread::sleep_for(milliseconds{20});
+  EXPECT(pool.activeThreadCount() == 3);
+  TEST_CASE_E()
+}
+
+static void priorityNoStarvationTest() {
+  TEST_CASE_B(priority_no_starvation)
+  struct RecordingTask : public Runnable {
+    RecordingTask(mutex &m, vector<int> &order, int id)
+        : m_{m}, order_{order}, id_{id} {
+      setAutoDeleted(true);
+    }
+    void run() override {
+      lock_guard lock(m_);
+      order_.push_back(id_);
+    }
+    mutex &m_;
+    vector<int> &order_;
+    int id_;
+  };
+  struct GateTask : public Runnable {
+    GateTask(atomic<bool> &open) : open_{open} { setAutoDeleted(true); }
+    void run() override {
+      while (!open_.load()) {
+        this_thread::yield();
+      }
+    }
+    atomic<bool> &open_;
+  };
+
+  const int highCount = 3000;
+  const int lowCount = 10;
+  mutex m;
+  vector<int> order;
+  atomic<bool> open = false;
+  PriorityThreadPool pool{1};
+  pool.run(new GateTask{open}, 0);
+  this_thread::sleep_for(milliseconds{10});
+  for (int i = 0; i < highCount; ++i) {
+    pool.run(new RecordingTask{m, order, highCount + i}, 7);
+    if (i % (highCount / lowCount) == 0) {
+      pool.run(new RecordingTask{m, order, i / (highCount / lowCount)}, 0);
+    }
+  }
+  EXPECT(pool.bandStats(7).pending == highCount);
+  EXPECT(pool.bandStats(0).pending == lowCount);
+  open.store(true);
+
+  auto until = steady_clock::now() + seconds{10};
+  while (pool.bandStats(7).pending + pool.bandStats(0).pending != 0 &&
+         steady_clock::now() < until) {
+    this_thread::sleep_for(milliseconds{1});
+  }
+  pool.shutdown();
+
+  EXPECT(order.size() == highCount + lowCount);
+  vector<int> lowOrder;
+  size_t lastLowPosition = 0;
+  for (size_t i = 0; i < order.size(); ++i) {
+    if (order[i] < lowCount) {
+      lowOrder.push_back(order[i]);
+      lastLowPosition = i;
+    }
+  }
+  // low priority tasks get through while high ones are still queued, in
+  // submission order
+  EXPECT(lastLowPosition < order.size() - 1);
+  EXPECT(is_sorted(lowOrder.begin(), lowOrder.end()));
+  EXPECT(is_sorted(order.begin() + static_cast<long>(lastLowPosition) + 1,
+                   order.end()));
+  EXPECT(pool.bandStats(0).executed == lowCount + 1);
+  TEST_CASE_E()
+}
+
+static void submitTest() {
+  TEST_CASE_B(submit_post_and_bulk)
+  for (auto type : {StableCount, DynamicCount, Priority, WorkStealing}) {
+    auto pool = ThreadPoolFactory::createPool(type, 4);
+
+    auto answer =
+        pool->submit([base = string{"4"}] { return stoi(base) * 10 + 2; });
+    EXPECT(answer.get() == 42);
+
+    auto failed = pool->submit([]() -> int { throw runtime_error{"oops"}; });
+    auto thrown = false;
+    try {
+      failed.get();
+    } catch (const runtime_error &) {
+      thrown = true;
+    }
+    EXPECT(thrown);
+
+    atomic<int> counter = 0;
+    TaskGroup group;
+    for (int i = 0; i < 1000; ++i) {
+      pool->post(group, [&counter] { counter.fetch_add(1); });
+    }
+    EXPECT(group.waitFor(seconds{10}));
+    EXPECT(counter.load() == 1000);
+
+    vector<int> squares(1000);
+    auto bulk = pool->submitBulk(
+        squares.size(), [&squares](size_t i) { squares[i] = int(i * i); });
+    bulk.get();
+    EXPECT(squares[999] == 999 * 999);
+  }
+  TEST_CASE_E()
+}
+
+static void droppedSubmissionTest() {
+  TEST_CASE_B(dropped_submission)
+  auto pool = ThreadPoolFactory::createPool(WorkStealing, 1);
+  pool->shutdown();
+  TaskGroup group;
+  pool->post(group, [] {});
+  EXPECT(group.pending() == 0);
+  auto result = pool->submit([] { return 1; });
+  EXPECT(!result.get());
+  TEST_CASE_E()
+}
+
+static double slowTerm(size_t i) {
+  double x = double(i);
+  for (int k = 0; k < 50; ++k) {
+    x = x * 0.5 + 1.0;
+  }
+  return x;
+}
+
+static void parallelForReduceTest() {
+  TEST_CASE_B(parallel_for_and_reduce)
+  auto pool = ThreadPoolFactory::createPool(WorkStealing, 4);
+
+  vector<int> values(100003);
+  parallel_for(*pool, size_t{0}, values.size(),
+               [&values](size_t i) { values[i] = int(i % 7); })
+      .get();
+  EXPECT(accumulate(values.begin(), values.end(), 0LL) ==
+         parallel_reduce(*pool, values, 0LL,
+                         [](int v) { return (long long)v; }, plus<>{},
+                         ChunkSize{1000})
+             .get());
+
+  parallel_for_each(*pool, values, [](int &v) { v = 1; }, ChunkSize{3}).get();
+  EXPECT(count(values.begin(), values.end(), 1) == long(values.size()));
+
+  // Non commutative combine: the partial results keep their order
+  auto digits =
+      parallel_reduce(*pool, 0, 10, string{},
+                      [](int i) { return to_string(i); }, plus<>{},
+                      ChunkSize{2});
+  EXPECT(digits.get() == "0123456789");
+  EXPECT(parallel_for(*pool, 5, 5, [](int) {}).valid());
+
+  auto failed = parallel_for(*pool, 0, 100, [](int i) {
+    if (i == 42) {
+      throw runtime_error{"oops"};
+    }
+  });
+  auto thrown = false;
+  try {
+    failed.get();
+  } catch (const runtime_error &) {
+    thrown = true;
+  }
+  EXPECT(thrown);
+
+  const size_t termCount = 2000000;
+  auto start = steady_clock::now();
+  double sequential = 0;
+  for (size_t i = 0; i < termCount; ++i) {
+    sequential += slowTerm(i);
+  }
+  auto sequentialTime = steady_clock::now() - start;
+  start = steady_clock::now();
+  auto parallel =
+      parallel_reduce(*pool, size_t{0}, termCount, 0.0, slowTerm, plus<>{})
+          .get();
+  auto parallelTime = steady_clock::now() - start;
+  cout << "Sum of " << termCount << " terms: sequential "
+       << duration_cast<microseconds>(sequentialTime).count()
+       << "us, parallel_reduce on 4 threads "
+       << duration_cast<microseconds>(parallelTime).count() << "us" << endl;
+  EXPECT(parallel && abs(*parallel - sequential) < 1e-6 * sequential);
+  TEST_CASE_E()
+}
+
+static void parallelPostBackTest() {
+  TEST_CASE_B(parallel_reduce_post_back)
+  using namespace maf::messaging;
+  auto pool = ThreadPoolFactory::createPool(StableCount, 4);
+  auto comp = Component::create();
+  thread::id resultThread;
+  long long result = 0;
+  comp->execute([&] {
+    parallel_reduce(
+        *pool, 1, 1001, 0LL, [](int i) { return (long long)i; }, plus<>{},
+        this_component::getExecutor(), [&](long long sum) {
+          resultThread = this_thread::get_id();
+          result = sum;
+          this_component::stop();
+        });
+  });
+  auto runner = async(launch::async, [&] {
+    comp->run();
+    return this_thread::get_id();
+  });
+  EXPECT(runner.wait_for(seconds{10}) == future_status::ready);
+  EXPECT(runner.get() == resultThread);
+  EXPECT(result == 500500);
+  TEST_CASE_E()
+}
+
+int main() {
+  cout.sync_with_stdio(false);
+  maf::test::init_test_cases();
+  externalSubmissionTest();
+  nestedSubmissionTest();
+  shutdownTest();
+  elasticGrowAndShrinkTest();
+  elasticSetMaxThreadCountTest();
+  priorityNoStarvationTest();
+  submitTest();
+  droppedSubmissionTest();
+  parallelForReduceTest();
+  parallelPostBackTest();
+  return 0;
+}
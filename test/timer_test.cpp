@@ -1,8 +1,13 @@
 #include <maf/messaging/Component.h>
 #include <maf/messaging/SignalTimer.h>
+#include <maf/messaging/SyncTimer.h>
 #include <maf/messaging/Timer.h>
 #include <maf/utils/TimeMeasurement.h>
 
+#include <atomic>
+#include <memory>
+#include <thread>
+
 #include "test.h"
 
 using namespace std;
@@ -139,11 +144,98 @@ void singleShotTest() {
   TEST_CASE_E()
 }
 
+void coalescingTest() {
+  Timer early;
+  Timer late;
+  milliseconds earlyFiredAfter{0};
+  milliseconds lateFiredAfter{0};
+  auto savedBefore = Timer::savedWakeupCount();
+
+  Component::create()->run([&] {
+    auto start = system_clock::now();
+    early.setSlack(10ms);
+    early.start(5ms, [&, start] {
+      earlyFiredAfter = duration_cast<milliseconds>(system_clock::now() - start);
+    });
+    late.start(10ms, [&, start] {
+      lateFiredAfter = duration_cast<milliseconds>(system_clock::now() - start);
+      this_component::stop();
+    });
+  });
+
+  TEST_CASE_B(timer_coalescing) {
+    EXPECT(earlyFiredAfter >= 5ms);
+    EXPECT(lateFiredAfter >= 10ms);
+    EXPECT(lateFiredAfter - earlyFiredAfter < 2ms);
+    EXPECT(Timer::savedWakeupCount() > savedBefore);
+  }
+  TEST_CASE_E()
+}
+
+void syncTimerScalingTest() {
+  const auto totalTimers = 10000;
+  const auto eachTimerInterval = 10ms;
+  const auto testTime = 300ms;
+  // Stopping does not wait for a callback already running, the counters are
+  // shared with the callbacks to outlive them
+  auto timersHitCount = make_shared<vector<atomic_int>>(totalTimers);
+  vector<unique_ptr<SyncTimer>> timers;
+  for (int i = 0; i < totalTimers; ++i) {
+    timers.emplace_back(make_unique<SyncTimer>(true));
+    timers.back()->start(eachTimerInterval, [timersHitCount, i] {
+      (*timersHitCount)[i].fetch_add(1, memory_order_relaxed);
+    });
+  }
+
+  this_thread::sleep_for(testTime);
+  auto allRunning = true;
+  for (auto& timer : timers) {
+    allRunning = allRunning && timer->running();
+    timer->stop();
+  }
+
+  auto minHits = (*timersHitCount)[0].load();
+  for (auto& hits : *timersHitCount) {
+    minHits = std::min(minHits, hits.load());
+  }
+  cout << "min hits of " << totalTimers << " sync timers = " << minHits << endl;
+
+  TEST_CASE_B(sync_timer_scaling) {
+    EXPECT(allRunning);
+    EXPECT(minHits >= 5);
+  }
+  TEST_CASE_E()
+}
+
+void syncTimerExecutorTest() {
+  auto comp = Component::create();
+  SyncTimer timer;
+  auto expiredOnComponent = false;
+  comp->run([&] {
+    timer.start(
+        1ms,
+        [&] {
+          expiredOnComponent = this_component::instance() == comp;
+          this_component::stop();
+        },
+        this_component::getExecutor());
+  });
+
+  TEST_CASE_B(sync_timer_executor) {
+    EXPECT(expiredOnComponent);
+    EXPECT(!timer.running());
+  }
+  TEST_CASE_E()
+}
+
 int main() {
   cout.sync_with_stdio(false);
   maf::test::init_test_cases();
   multiTimersTest();
   restartTimerTest();
   singleShotTest();
+  coalescingTest();
+  syncTimerScalingTest();
+  syncTimerExecutorTest();
   return 0;
 }